@@ -0,0 +1,413 @@
+#include "benchmark.hxx"
+
+#include <SFE/utility.hxx>
+
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    std::atomic<std::size_t> allocations(0);
+
+    std::vector<std::pair<std::string, bench::BenchmarkFunction>> & benchmarks()
+    {
+        static std::vector<std::pair<std::string, bench::BenchmarkFunction>> instance;
+        return instance;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Write the results as JSON object.
+    ////////////////////////////////////////////////////////////
+    void write_json(std::ostream & out, std::vector<bench::Result> const & results)
+    {
+        out << "{\"benchmarks\":[";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            auto const & r = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+            sfe::write_json_string(out, r.name);
+            out << std::setprecision(17)
+                << ",\"iterations\":" << r.iterations
+                << ",\"items_per_iteration\":" << r.items_per_iteration
+                << ",\"ns_per_iteration\":" << r.ns_per_iteration
+                << ",\"ns_per_item\":" << r.ns_per_iteration / r.items_per_iteration
+                << ",\"allocations_per_iteration\":" << r.allocations_per_iteration << '}';
+        }
+        out << "\n]}\n";
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Reads the JSON that write_json() writes. Only strings,
+    /// numbers, objects and arrays are supported.
+    ////////////////////////////////////////////////////////////
+    class JsonReader
+    {
+    public:
+
+        explicit JsonReader(std::string text)
+            :
+            text_(std::move(text)),
+            pos_(0)
+        {}
+
+        ////////////////////////////////////////////////////////////
+        /// Return the results of the benchmarks array.
+        ////////////////////////////////////////////////////////////
+        std::vector<bench::Result> read_results()
+        {
+            std::vector<bench::Result> results;
+            expect('{');
+            while (!accept('}'))
+            {
+                auto const key = read_string();
+                expect(':');
+                if (key != "benchmarks")
+                {
+                    skip_value();
+                }
+                else
+                {
+                    expect('[');
+                    while (!accept(']'))
+                    {
+                        results.push_back(read_result());
+                        accept(',');
+                    }
+                }
+                accept(',');
+            }
+            return results;
+        }
+
+    private:
+
+        bench::Result read_result()
+        {
+            bench::Result r{ "", 0, 1, 0.0, 0.0 };
+            expect('{');
+            while (!accept('}'))
+            {
+                auto const key = read_string();
+                expect(':');
+                if (key == "name")
+                    r.name = read_string();
+                else if (key == "iterations")
+                    r.iterations = static_cast<std::size_t>(read_number());
+                else if (key == "items_per_iteration")
+                    r.items_per_iteration = static_cast<std::size_t>(read_number());
+                else if (key == "ns_per_iteration")
+                    r.ns_per_iteration = read_number();
+                else if (key == "allocations_per_iteration")
+                    r.allocations_per_iteration = read_number();
+                else
+                    skip_value();
+                accept(',');
+            }
+            return r;
+        }
+
+        void skip_value()
+        {
+            skip_space();
+            if (pos_ < text_.size() && text_[pos_] == '"')
+            {
+                read_string();
+            }
+            else if (accept('{') || accept('['))
+            {
+                while (!accept('}') && !accept(']'))
+                {
+                    skip_value();
+                    accept(':');
+                    accept(',');
+                }
+            }
+            else
+            {
+                read_number();
+            }
+        }
+
+        std::string read_string()
+        {
+            expect('"');
+            std::string s;
+            while (pos_ < text_.size() && text_[pos_] != '"')
+            {
+                if (text_[pos_] == '\\')
+                    ++pos_;
+                if (pos_ < text_.size())
+                    s += text_[pos_++];
+            }
+            expect('"');
+            return s;
+        }
+
+        double read_number()
+        {
+            skip_space();
+            auto const begin = text_.c_str() + pos_;
+            char * end;
+            auto const value = std::strtod(begin, &end);
+            if (end == begin)
+                fail();
+            pos_ += end - begin;
+            return value;
+        }
+
+        bool accept(char c)
+        {
+            skip_space();
+            if (pos_ < text_.size() && text_[pos_] == c)
+            {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c)
+        {
+            if (!accept(c))
+                fail();
+        }
+
+        void skip_space()
+        {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+                ++pos_;
+        }
+
+        void fail() const
+        {
+            throw std::runtime_error("Invalid baseline at offset " + std::to_string(pos_) + ".");
+        }
+
+        std::string text_;
+        std::size_t pos_;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Read the results that were written with --json.
+    ////////////////////////////////////////////////////////////
+    std::map<std::string, bench::Result> read_baseline(std::string const & path)
+    {
+        std::ifstream in(path);
+        if (!in)
+            throw std::runtime_error("Could not open the baseline " + path + ".");
+        std::ostringstream text;
+        text << in.rdbuf();
+
+        std::map<std::string, bench::Result> baseline;
+        for (auto & r : JsonReader(text.str()).read_results())
+            baseline[r.name] = r;
+        return baseline;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Print the usage.
+    ////////////////////////////////////////////////////////////
+    void print_usage(char const * program)
+    {
+        std::cout
+            << "usage: " << program << " [filter] [options]\n"
+            << "  filter               run the benchmarks whose name contains filter\n"
+            << "  --json <file>        write the results as JSON to file\n"
+            << "  --baseline <file>    compare with results written by --json and fail\n"
+            << "                       if a benchmark got slower or allocates more, or\n"
+            << "                       without filter if a benchmark of it did not run\n"
+            << "  --tolerance <pct>    allowed slowdown in percent (default 10)\n"
+            << "  --min-time <ms>      minimum measuring time per benchmark (default 250)\n";
+    }
+}
+
+// Count the heap allocations of the whole program. The array and nothrow
+// versions of operator new forward to this one.
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (auto p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace bench
+{
+
+    std::size_t allocation_count()
+    {
+        return allocations.load();
+    }
+
+    State::State(std::chrono::nanoseconds min_time)
+        :
+        min_time_(min_time),
+        result_{ "", 0, 1, 0.0, 0.0 }
+    {}
+
+    void State::set_items_per_iteration(std::size_t n)
+    {
+        result_.items_per_iteration = n;
+    }
+
+    Result const & State::get_result() const
+    {
+        return result_;
+    }
+
+    Registration::Registration(std::string const& name, BenchmarkFunction f)
+    {
+        benchmarks().emplace_back(name, std::move(f));
+    }
+
+} // namespace bench
+
+int main(int argc, char* argv[])
+{
+    using namespace bench;
+
+    std::string filter;
+    std::string json_path;
+    std::string baseline_path;
+    double tolerance = 10.0;
+    std::chrono::milliseconds min_time(250);
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg = argv[i];
+        auto const has_value = i + 1 < argc;
+        if (arg == "--json" && has_value)
+            json_path = argv[++i];
+        else if (arg == "--baseline" && has_value)
+            baseline_path = argv[++i];
+        else if (arg == "--tolerance" && has_value)
+            tolerance = std::atof(argv[++i]);
+        else if (arg == "--min-time" && has_value)
+            min_time = std::chrono::milliseconds(std::atol(argv[++i]));
+        else if (arg.compare(0, 1, "-") == 0)
+        {
+            print_usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+        else
+            filter = arg;
+    }
+
+    std::map<std::string, Result> baseline;
+    if (!baseline_path.empty())
+    {
+        try
+        {
+            baseline = read_baseline(baseline_path);
+        }
+        catch (std::exception const& e)
+        {
+            std::cout << e.what() << std::endl;
+            return 2;
+        }
+    }
+
+    std::cout << std::left << std::setw(48) << "benchmark"
+              << std::right << std::setw(12) << "iterations"
+              << std::setw(16) << "ns/iteration"
+              << std::setw(12) << "ns/item"
+              << std::setw(16) << "allocs/iter";
+    if (!baseline.empty())
+        std::cout << std::setw(12) << "vs base";
+    std::cout << std::endl;
+
+    std::vector<Result> results;
+    std::size_t regressions = 0;
+    for (auto const & b : benchmarks())
+    {
+        if (b.first.find(filter) == std::string::npos)
+            continue;
+        State state(min_time);
+        try
+        {
+            b.second(state);
+        }
+        catch (std::exception const& e)
+        {
+            std::cout << b.first << " FAILED: " << e.what() << std::endl;
+            return 1;
+        }
+        auto r = state.get_result();
+        r.name = b.first;
+        results.push_back(r);
+
+        std::cout << std::left << std::setw(48) << b.first
+                  << std::right << std::setw(12) << r.iterations
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(16) << r.ns_per_iteration
+                  << std::setw(12) << r.ns_per_iteration / r.items_per_iteration
+                  << std::setprecision(2)
+                  << std::setw(16) << r.allocations_per_iteration;
+
+        // Allocation counts are deterministic, so any increase
+        // beyond rounding is a regression.
+        auto const base = baseline.find(b.first);
+        if (base != baseline.end())
+        {
+            auto const change = 100.0 * (r.ns_per_iteration / base->second.ns_per_iteration - 1.0);
+            std::cout << std::setprecision(1) << std::setw(11) << std::showpos << change << std::noshowpos << '%';
+            if (change > tolerance)
+            {
+                std::cout << "  REGRESSION: slower";
+                ++regressions;
+            }
+            if (r.allocations_per_iteration > base->second.allocations_per_iteration + 0.5)
+            {
+                std::cout << "  REGRESSION: allocates more";
+                ++regressions;
+            }
+            baseline.erase(base);
+        }
+        std::cout << std::endl;
+    }
+
+    // Without filter, all benchmarks of the baseline must still
+    // exist, so that renaming or removing one does not hide it.
+    if (filter.empty())
+    {
+        for (auto const & base : baseline)
+        {
+            std::cout << std::left << std::setw(48) << base.first << "  REGRESSION: missing" << std::endl;
+            ++regressions;
+        }
+    }
+
+    if (!json_path.empty())
+    {
+        std::ofstream out(json_path);
+        write_json(out, results);
+        if (!out)
+        {
+            std::cout << "Could not write " << json_path << "." << std::endl;
+            return 2;
+        }
+    }
+
+    if (regressions > 0)
+    {
+        std::cout << regressions << " regression(s) against " << baseline_path << "." << std::endl;
+        return 1;
+    }
+}
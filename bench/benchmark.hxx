@@ -0,0 +1,124 @@
+#ifndef SFE_BENCH_BENCHMARK_HXX
+#define SFE_BENCH_BENCHMARK_HXX
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    ////////////////////////////////////////////////////////////
+    /// Return the number of heap allocations since the start of
+    /// the program.
+    ////////////////////////////////////////////////////////////
+    std::size_t allocation_count();
+
+    ////////////////////////////////////////////////////////////
+    /// The measured values of a single benchmark.
+    ////////////////////////////////////////////////////////////
+    struct Result
+    {
+        std::string name;
+        std::size_t iterations;
+        std::size_t items_per_iteration;
+        double ns_per_iteration;
+        double allocations_per_iteration;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// The state is passed to each benchmark function. The
+    /// benchmark does its setup and then hands the code that
+    /// shall be measured to run(). Benchmarks that verify their
+    /// results throw an exception if the verification fails.
+    ////////////////////////////////////////////////////////////
+    class State
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create a state that measures for at least the given
+        /// time.
+        ////////////////////////////////////////////////////////////
+        explicit State(std::chrono::nanoseconds min_time);
+
+        ////////////////////////////////////////////////////////////
+        /// Set the number of items (events, objects, ...) that are
+        /// processed in a single iteration.
+        ////////////////////////////////////////////////////////////
+        void set_items_per_iteration(std::size_t n);
+
+        ////////////////////////////////////////////////////////////
+        /// Call f once to warm up and then repeatedly until the
+        /// minimum time has passed. Time and heap allocations are
+        /// only measured after the warm up.
+        ////////////////////////////////////////////////////////////
+        template <typename F>
+        void run(F && f);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the measured values.
+        ////////////////////////////////////////////////////////////
+        Result const & get_result() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The minimum measuring time.
+        ////////////////////////////////////////////////////////////
+        std::chrono::nanoseconds min_time_;
+
+        ////////////////////////////////////////////////////////////
+        /// The measured values.
+        ////////////////////////////////////////////////////////////
+        Result result_;
+
+    }; // class State
+
+    ////////////////////////////////////////////////////////////
+    /// The benchmark function type.
+    ////////////////////////////////////////////////////////////
+    typedef std::function<void(State &)> BenchmarkFunction;
+
+    ////////////////////////////////////////////////////////////
+    /// Add a benchmark to the global list. Use this in a static
+    /// initializer of the benchmark source files.
+    ////////////////////////////////////////////////////////////
+    struct Registration
+    {
+        Registration(std::string const& name, BenchmarkFunction f);
+    };
+
+    template <typename F>
+    void State::run(F && f)
+    {
+        typedef std::chrono::steady_clock clock;
+
+        // Warm up, so containers have reached their steady state capacity.
+        f();
+
+        // Double the number of iterations until the minimum time is reached.
+        std::size_t iterations = 0;
+        std::size_t batch = 1;
+        std::chrono::nanoseconds elapsed(0);
+        auto const allocations_before = allocation_count();
+        while (elapsed < min_time_)
+        {
+            auto const start = clock::now();
+            for (std::size_t i = 0; i < batch; ++i)
+                f();
+            elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            iterations += batch;
+            batch *= 2;
+        }
+        auto const allocations = allocation_count() - allocations_before;
+
+        result_.iterations = iterations;
+        result_.ns_per_iteration = elapsed.count() / static_cast<double>(iterations);
+        result_.allocations_per_iteration = allocations / static_cast<double>(iterations);
+    }
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,229 @@
+#include "benchmark.hxx"
+
+#include <SFE/event_manager.hxx>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const events_per_frame = 5000;
+
+    ////////////////////////////////////////////////////////////
+    /// Dispatch a frame of events to a few listeners per event.
+    /// After the warm up, this must not allocate.
+    ////////////////////////////////////////////////////////////
+    bench::Registration dispatch("EventManager/dispatch", [](bench::State & state)
+    {
+        Event const events[] = { Event("MovedSnake"), Event("CollectedFood"), Event("CollectedCoin"), Event("Unheard") };
+        EventManager event_manager;
+        for (auto const& name : { "MovedSnake", "CollectedFood", "CollectedCoin", "Unheard" })
+            event_manager.register_event(name);
+        std::vector<ListenerHandle> listeners;
+        std::size_t counter = 0;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 4; ++j)
+                listeners.push_back(event_manager.register_listener(events[i], [&counter](Event const&) { ++counter; }));
+
+        state.set_items_per_iteration(events_per_frame);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < events_per_frame; ++i)
+                event_manager.enqueue(events[i % 4]);
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Dispatch events whose listeners register new listeners.
+    ////////////////////////////////////////////////////////////
+    bench::Registration dispatch_with_registration("EventManager/dispatch_with_registration", [](bench::State & state)
+    {
+        Event const spawn("Spawn");
+        Event const spawned("Spawned");
+        EventManager event_manager;
+        event_manager.register_event("Spawn");
+        event_manager.register_event("Spawned");
+        std::vector<ListenerHandle> listeners;
+        auto const spawner = event_manager.register_listener(spawn, [&](Event const&)
+        {
+            listeners.push_back(event_manager.register_listener(spawned, [](Event const&) {}));
+            event_manager.enqueue(spawned);
+        });
+
+        state.set_items_per_iteration(100);
+        state.run([&]()
+        {
+            for (int i = 0; i < 100; ++i)
+                event_manager.enqueue(spawn);
+            event_manager.dispatch();
+            listeners.clear();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Dispatch a frame of events that carry a payload. The
+    /// payloads are stored in the frame arena, so after the warm
+    /// up this must not allocate.
+    ////////////////////////////////////////////////////////////
+    struct Position
+    {
+        int x;
+        int y;
+    };
+
+    bench::Registration dispatch_payload("EventManager/dispatch_payload", [](bench::State & state)
+    {
+        Event const collected("CollectedCoin");
+        EventManager event_manager;
+        event_manager.register_event("CollectedCoin");
+        long sum = 0;
+        auto const listener = event_manager.register_listener(collected, [&sum](Event const& event)
+        {
+            auto const & p = event.get_payload<Position>();
+            sum += p.x + p.y;
+        });
+
+        state.set_items_per_iteration(events_per_frame);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < events_per_frame; ++i)
+                event_manager.enqueue(collected, Position{ static_cast<int>(i), 1 });
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The same as dispatch_payload with a batch listener that
+    /// receives all events of the frame at once.
+    ////////////////////////////////////////////////////////////
+    bench::Registration dispatch_batch("EventManager/dispatch_batch", [](bench::State & state)
+    {
+        Event const collected("CollectedCoin");
+        EventManager event_manager;
+        event_manager.register_event("CollectedCoin");
+        long sum = 0;
+        auto const listener = event_manager.register_batch_listener(collected, [&sum](EventSpan const& events)
+        {
+            for (auto const& event : events)
+            {
+                auto const & p = event.get_payload<Position>();
+                sum += p.x + p.y;
+            }
+        });
+
+        state.set_items_per_iteration(events_per_frame);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < events_per_frame; ++i)
+                event_manager.enqueue(collected, Position{ static_cast<int>(i), 1 });
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Enqueue the same event many times per frame and deliver
+    /// it once with the number of occurrences.
+    ////////////////////////////////////////////////////////////
+    bench::Registration dispatch_coalesced("EventManager/dispatch_coalesced", [](bench::State & state)
+    {
+        Event const moved("MovedSnake");
+        EventManager event_manager;
+        event_manager.register_event("MovedSnake");
+        event_manager.set_coalesce_policy(moved, CoalescePolicy::Count);
+        std::size_t counter = 0;
+        auto const listener = event_manager.register_listener(moved, [&counter](Event const& event)
+        {
+            counter += event.get_payload<EventCount>().count;
+        });
+
+        state.set_items_per_iteration(events_per_frame);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < events_per_frame; ++i)
+                event_manager.enqueue(moved);
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Dispatch a few events while many listeners of other
+    /// events are registered. The cost must not depend on the
+    /// idle listeners.
+    ////////////////////////////////////////////////////////////
+    bench::Registration dispatch_idle_listeners("EventManager/dispatch_idle_listeners", [](bench::State & state)
+    {
+        Event const moved("MovedSnake");
+        EventManager event_manager;
+        event_manager.register_event("MovedSnake");
+        std::vector<ListenerHandle> listeners;
+        for (int i = 0; i < 10000; ++i)
+        {
+            auto const name = "Idle" + std::to_string(i % 100);
+            event_manager.register_event(name);
+            listeners.push_back(event_manager.register_listener(Event(name), [](Event const&) {}));
+        }
+        std::size_t counter = 0;
+        auto const listener = event_manager.register_listener(moved, [&counter](Event const&) { ++counter; });
+
+        state.set_items_per_iteration(10);
+        state.run([&]()
+        {
+            for (int i = 0; i < 10; ++i)
+                event_manager.enqueue(moved);
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Register and unregister listeners, as widgets and screens
+    /// do when they are created and destroyed.
+    ////////////////////////////////////////////////////////////
+    bench::Registration register_unregister("EventManager/register_unregister", [](bench::State & state)
+    {
+        Event const events[] = { Event("MovedSnake"), Event("CollectedFood"), Event("CollectedCoin") };
+        EventManager event_manager;
+        for (auto const& name : { "MovedSnake", "CollectedFood", "CollectedCoin" })
+            event_manager.register_event(name);
+        std::vector<ListenerHandle> listeners(300);
+
+        state.set_items_per_iteration(listeners.size());
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < listeners.size(); ++i)
+                listeners[i] = event_manager.register_listener(events[i % 3], [](Event const&) {});
+            for (auto & l : listeners)
+                l.reset();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The dispatch benchmark with enabled instrumentation. It
+    /// equals EventManager/dispatch unless the library is built
+    /// with SFE_EVENT_STATS.
+    ////////////////////////////////////////////////////////////
+    bench::Registration dispatch_stats("EventManager/dispatch_stats", [](bench::State & state)
+    {
+        Event const events[] = { Event("MovedSnake"), Event("CollectedFood"), Event("CollectedCoin"), Event("Unheard") };
+        EventManager event_manager;
+        for (auto const& name : { "MovedSnake", "CollectedFood", "CollectedCoin", "Unheard" })
+            event_manager.register_event(name);
+        event_manager.set_stats_enabled(true);
+        std::vector<ListenerHandle> listeners;
+        std::size_t counter = 0;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 4; ++j)
+                listeners.push_back(event_manager.register_listener(events[i], [&counter](Event const&) { ++counter; }));
+
+        state.set_items_per_iteration(events_per_frame);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < events_per_frame; ++i)
+                event_manager.enqueue(events[i % 4]);
+            event_manager.dispatch();
+        });
+    });
+}
@@ -0,0 +1,151 @@
+#include "benchmark.hxx"
+
+#include <SFE/event_manager.hxx>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const num_threads = 8;
+    std::size_t const events_per_thread = 20000;
+
+    ////////////////////////////////////////////////////////////
+    /// The payload identifies the sending thread and the order
+    /// of the events of that thread.
+    ////////////////////////////////////////////////////////////
+    struct Message
+    {
+        std::size_t thread;
+        std::size_t sequence;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Start the threads, call f(t) on each and wait for them.
+    ////////////////////////////////////////////////////////////
+    template <typename F>
+    void run_threads(F && f)
+    {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < num_threads; ++t)
+            threads.emplace_back([&f, t]() { f(t); });
+        for (auto & t : threads)
+            t.join();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Many threads enqueue events with payloads while the main
+    /// thread keeps dispatching. Each event must arrive exactly
+    /// once and the events of one thread must arrive in order.
+    ////////////////////////////////////////////////////////////
+    bench::Registration stress("EventManager/stress_threads", [](bench::State & state)
+    {
+        Event const message("Message");
+        EventManager event_manager;
+        event_manager.register_event("Message");
+        std::vector<std::size_t> next_sequence(num_threads, 0);
+        bool in_order = true;
+        auto const listener = event_manager.register_listener(message, [&](Event const& event)
+        {
+            auto const & m = event.get_payload<Message>();
+            if (m.sequence != next_sequence[m.thread])
+                in_order = false;
+            ++next_sequence[m.thread];
+        });
+
+        state.set_items_per_iteration(num_threads * events_per_thread);
+        state.run([&]()
+        {
+            std::fill(next_sequence.begin(), next_sequence.end(), 0);
+            std::atomic<std::size_t> running(num_threads);
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t < num_threads; ++t)
+            {
+                threads.emplace_back([&, t]()
+                {
+                    for (std::size_t i = 0; i < events_per_thread; ++i)
+                        event_manager.enqueue(message, Message{ t, i });
+                    --running;
+                });
+            }
+            while (running > 0)
+                event_manager.dispatch();
+            for (auto & t : threads)
+                t.join();
+            event_manager.dispatch();
+
+            for (auto n : next_sequence)
+                if (n != events_per_thread)
+                    throw std::runtime_error("Lost events: received " + std::to_string(n) + " of " + std::to_string(events_per_thread) + ".");
+            if (!in_order)
+                throw std::runtime_error("The events of a thread arrived out of order.");
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Enqueue from many threads and dispatch on the main thread.
+    ////////////////////////////////////////////////////////////
+    bench::Registration enqueue_threads("EventManager/enqueue_threads", [](bench::State & state)
+    {
+        Event const message("Message");
+        EventManager event_manager;
+        event_manager.register_event("Message");
+        std::size_t received = 0;
+        auto const listener = event_manager.register_listener(message, [&received](Event const&) { ++received; });
+
+        state.set_items_per_iteration(num_threads * events_per_thread);
+        state.run([&]()
+        {
+            run_threads([&](std::size_t)
+            {
+                for (std::size_t i = 0; i < events_per_thread; ++i)
+                    event_manager.enqueue(message);
+            });
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The same as above with a single mutex-guarded queue in
+    /// front of the event manager, for comparison.
+    ////////////////////////////////////////////////////////////
+    bench::Registration enqueue_threads_mutex("MutexQueue/enqueue_threads", [](bench::State & state)
+    {
+        Event const message("Message");
+        EventManager event_manager;
+        event_manager.register_event("Message");
+        std::size_t received = 0;
+        auto const listener = event_manager.register_listener(message, [&received](Event const&) { ++received; });
+        std::mutex mutex;
+        std::vector<Event> queue;
+        std::vector<Event> dispatched;
+
+        state.set_items_per_iteration(num_threads * events_per_thread);
+        state.run([&]()
+        {
+            run_threads([&](std::size_t)
+            {
+                for (std::size_t i = 0; i < events_per_thread; ++i)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue.push_back(message);
+                }
+            });
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                dispatched.swap(queue);
+            }
+            for (auto const& ev : dispatched)
+                event_manager.enqueue(ev);
+            event_manager.dispatch();
+            dispatched.clear();
+        });
+    });
+}
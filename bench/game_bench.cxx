@@ -0,0 +1,84 @@
+#include "benchmark.hxx"
+
+#include <SFE/game.hxx>
+#include <SFE/game_object.hxx>
+#include <SFE/screen.hxx>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const object_count = 1000;
+    std::size_t const frame_count = 100;
+
+    ////////////////////////////////////////////////////////////
+    /// A game object that moves on a circle.
+    ////////////////////////////////////////////////////////////
+    class CircleObject : public GameObject
+    {
+    public:
+        void update(sf::Time elapsed_time) override
+        {
+            angle_ += elapsed_time.asSeconds();
+            set_position(std::cos(angle_), std::sin(angle_));
+        }
+
+    protected:
+        void render_impl(sf::RenderTarget &) const override
+        {}
+
+    private:
+        float angle_ = 0.0f;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// A game without window that loads a screen with moving
+    /// game objects.
+    ////////////////////////////////////////////////////////////
+    class HeadlessGame : public Game
+    {
+    public:
+        HeadlessGame()  :
+            Game(800, 600, GameBackend::Null)
+        {}
+
+    private:
+        void init_impl() override
+        {
+            auto screen = std::make_unique<Screen>(sf::View(), get_event_manager(), get_resource_manager());
+            for (std::size_t i = 0; i < object_count; ++i)
+            {
+                auto obj = std::make_unique<CircleObject>();
+                obj->set_size(0.01f, 0.01f);
+                screen->add_game_object(std::move(obj));
+            }
+            load_screen(std::move(screen));
+        }
+
+        void update_impl(sf::Time const &) override
+        {}
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Run the whole main loop of a headless game for a fixed
+    /// number of frames.
+    ////////////////////////////////////////////////////////////
+    bench::Registration headless("Game/headless", [](bench::State & state)
+    {
+        HeadlessGame game;
+        game.set_max_frames(frame_count);
+
+        state.set_items_per_iteration(frame_count);
+        state.run([&]()
+        {
+            game.run();
+        });
+
+        if (game.get_frame_count() != frame_count)
+            throw std::runtime_error("The headless game ran a wrong number of frames.");
+    });
+}
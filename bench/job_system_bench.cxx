@@ -0,0 +1,83 @@
+#include "benchmark.hxx"
+
+#include <SFE/job_system.hxx>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const item_count = 100000;
+
+    ////////////////////////////////////////////////////////////
+    /// Some arithmetic that stands for the logic of an object.
+    ////////////////////////////////////////////////////////////
+    float work(std::size_t i)
+    {
+        auto x = static_cast<float>(i);
+        for (int k = 0; k < 50; ++k)
+            x = std::sin(x) + std::cos(0.5f * x);
+        return x;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// The workload on the calling thread.
+    ////////////////////////////////////////////////////////////
+    bench::Registration sequential("JobSystem/sequential", [](bench::State & state)
+    {
+        std::vector<float> results(item_count);
+
+        state.set_items_per_iteration(item_count);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < item_count; ++i)
+                results[i] = work(i);
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The same workload with parallel_for on all cores. The
+    /// results must not differ from the sequential ones.
+    ////////////////////////////////////////////////////////////
+    bench::Registration parallel_for("JobSystem/parallel_for", [](bench::State & state)
+    {
+        auto & jobs = JobSystem::global();
+        std::vector<float> results(item_count);
+
+        state.set_items_per_iteration(item_count);
+        state.run([&]()
+        {
+            jobs.parallel_for(0, item_count, 256, [&](std::size_t i)
+            {
+                results[i] = work(i);
+            });
+        });
+
+        for (std::size_t i = 0; i < item_count; ++i)
+            if (results[i] != work(i))
+                throw std::runtime_error("parallel_for computed a wrong result.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Run many small independent jobs, like loading resources,
+    /// and wait for them.
+    ////////////////////////////////////////////////////////////
+    bench::Registration run_wait("JobSystem/run_wait", [](bench::State & state)
+    {
+        std::size_t const job_count = 1000;
+        auto & jobs = JobSystem::global();
+        std::vector<float> results(job_count);
+
+        state.set_items_per_iteration(job_count);
+        state.run([&]()
+        {
+            JobGroup group;
+            for (std::size_t i = 0; i < job_count; ++i)
+                jobs.run(group, [&results, i]() { results[i] = work(i); });
+            jobs.wait(group);
+        });
+    });
+}
@@ -0,0 +1,128 @@
+#include "benchmark.hxx"
+
+#include <SFE/ndarray.hxx>
+
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const width = 1024;
+    std::size_t const height = 1024;
+    std::size_t const random_count = 100000;
+
+    ////////////////////////////////////////////////////////////
+    /// Create an array whose values are their linear index, so
+    /// the sums can be verified.
+    ////////////////////////////////////////////////////////////
+    Array2D<int> make_array()
+    {
+        Array2D<int> a(width, height);
+        std::iota(a.begin(), a.end(), 0);
+        return a;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Return the sum of all values of make_array().
+    ////////////////////////////////////////////////////////////
+    long long expected_sum()
+    {
+        auto const n = static_cast<long long>(width * height);
+        return n * (n - 1) / 2;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Visit the cells with operator() row by row.
+    ////////////////////////////////////////////////////////////
+    bench::Registration access_rows("Array2D/access_rows", [](bench::State & state)
+    {
+        auto const a = make_array();
+        long long sum = 0;
+
+        state.set_items_per_iteration(width * height);
+        state.run([&]()
+        {
+            sum = 0;
+            for (std::size_t y = 0; y < height; ++y)
+                for (std::size_t x = 0; x < width; ++x)
+                    sum += a(x, y);
+        });
+
+        if (sum != expected_sum())
+            throw std::runtime_error("The row scan computed a wrong sum.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Visit the cells with operator() column by column.
+    ////////////////////////////////////////////////////////////
+    bench::Registration access_columns("Array2D/access_columns", [](bench::State & state)
+    {
+        auto const a = make_array();
+        long long sum = 0;
+
+        state.set_items_per_iteration(width * height);
+        state.run([&]()
+        {
+            sum = 0;
+            for (std::size_t x = 0; x < width; ++x)
+                for (std::size_t y = 0; y < height; ++y)
+                    sum += a(x, y);
+        });
+
+        if (sum != expected_sum())
+            throw std::runtime_error("The column scan computed a wrong sum.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Visit the cells with the iterators.
+    ////////////////////////////////////////////////////////////
+    bench::Registration scan_iterators("Array2D/scan_iterators", [](bench::State & state)
+    {
+        auto const a = make_array();
+        long long sum = 0;
+
+        state.set_items_per_iteration(width * height);
+        state.run([&]()
+        {
+            sum = std::accumulate(a.begin(), a.end(), 0ll);
+        });
+
+        if (sum != expected_sum())
+            throw std::runtime_error("The iterator scan computed a wrong sum.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Visit random cells.
+    ////////////////////////////////////////////////////////////
+    bench::Registration access_random("Array2D/access_random", [](bench::State & state)
+    {
+        auto const a = make_array();
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<std::size_t> dist_x(0, width - 1);
+        std::uniform_int_distribution<std::size_t> dist_y(0, height - 1);
+        std::vector<std::pair<std::size_t, std::size_t>> cells;
+        long long expected = 0;
+        for (std::size_t i = 0; i < random_count; ++i)
+        {
+            cells.emplace_back(dist_x(rng), dist_y(rng));
+            expected += static_cast<long long>(cells.back().second * width + cells.back().first);
+        }
+        long long sum = 0;
+
+        state.set_items_per_iteration(random_count);
+        state.run([&]()
+        {
+            sum = 0;
+            for (auto const & c : cells)
+                sum += a(c.first, c.second);
+        });
+
+        if (sum != expected)
+            throw std::runtime_error("The random access computed a wrong sum.");
+    });
+}
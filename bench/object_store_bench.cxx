@@ -0,0 +1,137 @@
+#include "benchmark.hxx"
+
+#include <SFE/game_object.hxx>
+#include <SFE/object_store.hxx>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const object_count = 100000;
+
+    ////////////////////////////////////////////////////////////
+    /// The per-object data of the moving objects.
+    ////////////////////////////////////////////////////////////
+    struct Velocity
+    {
+        sf::Vector2f value;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Move 100k objects of an object store by their velocity
+    /// component.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_store("ObjectStore/update", [](bench::State & state)
+    {
+        ObjectStore store;
+        std::mt19937 rand_engine(42);
+        std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+        for (std::size_t i = 0; i < object_count; ++i)
+            store.add_component(store.create(), Velocity{ { speed(rand_engine), speed(rand_engine) } });
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            auto const dt = 1.0f / 60.0f;
+            auto const positions = store.get_positions();
+            store.for_each<Velocity>([&](std::size_t i, Velocity const & v)
+            {
+                positions[i] += dt * v.value;
+            });
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The same workload without the component lookup: The
+    /// velocities are kept in a parallel array.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_store_arrays("ObjectStore/update_arrays", [](bench::State & state)
+    {
+        ObjectStore store;
+        std::mt19937 rand_engine(42);
+        std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+        std::vector<sf::Vector2f> velocities;
+        for (std::size_t i = 0; i < object_count; ++i)
+        {
+            store.create();
+            velocities.emplace_back(speed(rand_engine), speed(rand_engine));
+        }
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            auto const dt = 1.0f / 60.0f;
+            auto const positions = store.get_positions();
+            for (std::size_t i = 0; i < store.size(); ++i)
+                positions[i] += dt * velocities[i];
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The same workload with 100k GameObjects and a virtual
+    /// update method.
+    ////////////////////////////////////////////////////////////
+    class MovingObject : public GameObject
+    {
+    public:
+        explicit MovingObject(sf::Vector2f const & velocity)
+            :
+            velocity_(velocity)
+        {}
+
+        void update(sf::Time elapsed_time) override
+        {
+            set_position(get_position() + elapsed_time.asSeconds() * velocity_);
+        }
+
+    protected:
+        void render_impl(sf::RenderTarget &) const override
+        {}
+
+    private:
+        sf::Vector2f velocity_;
+    };
+
+    bench::Registration update_game_objects("GameObject/update", [](bench::State & state)
+    {
+        std::mt19937 rand_engine(42);
+        std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+        std::vector<std::unique_ptr<GameObject> > objects;
+        for (std::size_t i = 0; i < object_count; ++i)
+            objects.push_back(std::make_unique<MovingObject>(sf::Vector2f(speed(rand_engine), speed(rand_engine))));
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            auto const dt = sf::microseconds(16667);
+            for (auto & obj : objects)
+                obj->update(dt);
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Create and destroy objects with a component. After the
+    /// warm up, this must not allocate.
+    ////////////////////////////////////////////////////////////
+    bench::Registration create_destroy("ObjectStore/create_destroy", [](bench::State & state)
+    {
+        ObjectStore store;
+        std::vector<ObjectId> ids(1000);
+
+        state.set_items_per_iteration(ids.size());
+        state.run([&]()
+        {
+            for (auto & id : ids)
+            {
+                id = store.create();
+                store.add_component(id, Velocity{ { 1.0f, 0.0f } });
+            }
+            for (auto const id : ids)
+                store.destroy(id);
+        });
+    });
+}
@@ -0,0 +1,63 @@
+#include "benchmark.hxx"
+
+#include <SFE/profiler.hxx>
+
+#include <stdexcept>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const zone_count = 100000;
+
+    ////////////////////////////////////////////////////////////
+    /// Open and close nested zones. ProfileZone is used directly
+    /// so the bench does not depend on SFE_PROFILING.
+    ////////////////////////////////////////////////////////////
+    void nested_zones()
+    {
+        for (std::size_t i = 0; i < zone_count / 2; ++i)
+        {
+            ProfileZone outer("outer");
+            ProfileZone inner("inner");
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// The cost of a zone while the profiler is disabled.
+    ////////////////////////////////////////////////////////////
+    bench::Registration zone_disabled("Profiler/zone_disabled", [](bench::State & state)
+    {
+        Profiler::global().set_enabled(false);
+
+        state.set_items_per_iteration(zone_count);
+        state.run([&]()
+        {
+            nested_zones();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The cost of recording a zone.
+    ////////////////////////////////////////////////////////////
+    bench::Registration zone_enabled("Profiler/zone_enabled", [](bench::State & state)
+    {
+        auto & profiler = Profiler::global();
+        auto const capacity = profiler.get_capacity();
+        profiler.set_capacity(zone_count);
+        profiler.set_enabled(true);
+
+        state.set_items_per_iteration(zone_count);
+        state.run([&]()
+        {
+            nested_zones();
+            profiler.end_frame();
+        });
+        profiler.set_enabled(false);
+
+        auto const frame = profiler.get_last_frame();
+        if (frame.zones.size() != 2 || frame.zones[1].depth != 1 || frame.zones[0].calls != zone_count / 2)
+            throw std::runtime_error("The profiler summarized a wrong frame.");
+        profiler.set_capacity(capacity);
+    });
+}
@@ -0,0 +1,78 @@
+#include "benchmark.hxx"
+
+#include <SFE/resource_manager.hxx>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const image_count = 64;
+
+    ////////////////////////////////////////////////////////////
+    /// Small image files in the working directory that are
+    /// removed again when the benchmark ends.
+    ////////////////////////////////////////////////////////////
+    struct ImageFiles
+    {
+        ImageFiles()
+        {
+            sf::Image image;
+            image.create(16, 16, sf::Color::White);
+            for (std::size_t i = 0; i < image_count; ++i)
+            {
+                names.push_back("sfe_bench_image_" + std::to_string(i) + ".png");
+                if (!image.saveToFile(names.back()))
+                    throw std::runtime_error("Could not write " + names.back() + ".");
+            }
+        }
+
+        ~ImageFiles()
+        {
+            for (auto const & name : names)
+                std::remove(name.c_str());
+        }
+
+        std::vector<std::string> names;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Look up textures that are already loaded.
+    ////////////////////////////////////////////////////////////
+    bench::Registration get_texture("ResourceManager/get_texture", [](bench::State & state)
+    {
+        ImageFiles files;
+        ResourceManager resources;
+
+        state.set_items_per_iteration(image_count);
+        state.run([&]()
+        {
+            for (auto const & name : files.names)
+                resources.get_texture(name);
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Look up the regions of images in the texture atlas.
+    ////////////////////////////////////////////////////////////
+    bench::Registration get_texture_region("ResourceManager/get_texture_region", [](bench::State & state)
+    {
+        ImageFiles files;
+        ResourceManager resources;
+        resources.build_atlas(files.names);
+
+        state.set_items_per_iteration(image_count);
+        state.run([&]()
+        {
+            for (auto const & name : files.names)
+                resources.get_texture_region(name);
+        });
+
+        if (!resources.get_atlas().contains(files.names.front()))
+            throw std::runtime_error("The image was not packed into the atlas.");
+    });
+}
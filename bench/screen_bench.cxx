@@ -0,0 +1,269 @@
+#include "benchmark.hxx"
+
+#include <SFE/event_manager.hxx>
+#include <SFE/game_object.hxx>
+#include <SFE/screen.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const object_count = 10000;
+
+    ////////////////////////////////////////////////////////////
+    /// A game object without logic that draws nothing.
+    ////////////////////////////////////////////////////////////
+    class EmptyObject : public GameObject
+    {
+    protected:
+        void render_impl(sf::RenderTarget &) const override
+        {}
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// A game object that moves on a circle and spends some
+    /// arithmetic on it.
+    ////////////////////////////////////////////////////////////
+    class OrbitObject : public EmptyObject
+    {
+    public:
+        void update(sf::Time elapsed_time) override
+        {
+            angle_ += elapsed_time.asSeconds();
+            auto r = 0.0f;
+            for (int k = 1; k <= 50; ++k)
+                r += std::sin(k * angle_) / k;
+            set_position(100.0f * std::cos(angle_) + r, 100.0f * std::sin(angle_) + r);
+        }
+
+    private:
+        float angle_ = 0.0f;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Create a screen with orbiting game objects.
+    ////////////////////////////////////////////////////////////
+    std::unique_ptr<Screen> make_orbit_screen(bool parallel)
+    {
+        auto screen = std::make_unique<Screen>(sf::View(), std::make_shared<EventManager>(), nullptr);
+        for (std::size_t i = 0; i < object_count; ++i)
+        {
+            auto obj = std::make_unique<OrbitObject>();
+            obj->set_size(20.0f, 20.0f);
+            obj->set_parallel_update(parallel);
+            screen->add_game_object(std::move(obj));
+        }
+        return screen;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Create a screen with game objects on a few layers, spread
+    /// over a large world.
+    ////////////////////////////////////////////////////////////
+    std::unique_ptr<Screen> make_screen(std::vector<GameObject*> & objects)
+    {
+        auto screen = std::make_unique<Screen>(sf::View(), std::make_shared<EventManager>(), nullptr);
+        std::mt19937 rand_engine(42);
+        std::uniform_int_distribution<int> layer(0, 9);
+        std::uniform_real_distribution<float> pos(0.0f, 5000.0f);
+        for (std::size_t i = 0; i < object_count; ++i)
+        {
+            auto obj = std::make_unique<EmptyObject>();
+            obj->set_z_index(layer(rand_engine));
+            obj->set_position(pos(rand_engine), pos(rand_engine));
+            obj->set_size(20.0f, 20.0f);
+            objects.push_back(obj.get());
+            screen->add_game_object(std::move(obj));
+        }
+        return screen;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Update a screen whose game objects do not change their
+    /// z-index. Ordering must cost next to nothing.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_static("Screen/update_static", [](bench::State & state)
+    {
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        sf::RenderWindow window;
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            screen->update(window, sf::microseconds(16667));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Update a screen where a few game objects change their
+    /// z-index every frame.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_moving("Screen/update_moving", [](bench::State & state)
+    {
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        sf::RenderWindow window;
+        std::size_t next = 0;
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            for (int i = 0; i < 10; ++i)
+            {
+                auto const obj = objects[next++ % objects.size()];
+                obj->set_z_index((obj->get_z_index() + 1) % 10);
+            }
+            screen->update(window, sf::microseconds(16667));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Update game objects with some logic one after the other.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_orbit("Screen/update_orbit", [](bench::State & state)
+    {
+        auto const screen = make_orbit_screen(false);
+        sf::RenderWindow window;
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            screen->update(window, sf::microseconds(16667));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Update the same game objects on the job system.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_orbit_parallel("Screen/update_orbit_parallel", [](bench::State & state)
+    {
+        auto const screen = make_orbit_screen(true);
+        sf::RenderWindow window;
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            screen->update(window, sf::microseconds(16667));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Remove a tenth of the game objects by their handles, add
+    /// them again and update the screen once, like a frame in
+    /// which many objects die and spawn.
+    ////////////////////////////////////////////////////////////
+    bench::Registration remove_add("Screen/remove_add", [](bench::State & state)
+    {
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        sf::RenderWindow window;
+        std::vector<GameObjectHandle> handles;
+        for (auto obj : objects)
+            handles.push_back(obj->get_handle());
+        std::vector<std::unique_ptr<GameObject> > removed;
+        std::size_t next = 0;
+
+        state.set_items_per_iteration(object_count / 10);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < object_count / 10; ++i)
+            {
+                auto const k = (next + 10 * i) % handles.size();
+                removed.push_back(screen->remove_game_object(handles[k]));
+            }
+            for (std::size_t i = 0; i < object_count / 10; ++i)
+            {
+                auto const k = (next + 10 * i) % handles.size();
+                handles[k] = screen->add_game_object(std::move(removed[i]));
+            }
+            removed.clear();
+            ++next;
+            screen->update(window, sf::microseconds(16667));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Despawn and spawn game objects and a gui overlay every
+    /// frame, like the snake parts and the flash effects. Once
+    /// the pools and containers have grown, a frame must not
+    /// allocate.
+    ////////////////////////////////////////////////////////////
+    bench::Registration spawn_despawn("Screen/spawn_despawn", [](bench::State & state)
+    {
+        std::size_t const spawn_count = 100;
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        sf::RenderWindow window;
+        std::vector<GameObjectHandle> handles;
+        for (auto obj : objects)
+            handles.push_back(obj->get_handle());
+        std::size_t oldest = 0;
+        std::mt19937 rand_engine(42);
+        std::uniform_real_distribution<float> pos(0.0f, 5000.0f);
+        std::uniform_int_distribution<int> layer(0, 9);
+
+        auto const frame = [&]()
+        {
+            for (std::size_t i = 0; i < spawn_count; ++i)
+            {
+                // The handles are a ring buffer, oldest first.
+                screen->remove_game_object(handles[oldest]);
+
+                auto obj = std::make_unique<EmptyObject>();
+                obj->set_z_index(layer(rand_engine));
+                obj->set_position(pos(rand_engine), pos(rand_engine));
+                obj->set_size(20.0f, 20.0f);
+                handles[oldest] = screen->add_game_object(std::move(obj));
+                oldest = (oldest + 1) % handles.size();
+            }
+            auto const flash = screen->get_gui().add_widget(std::make_unique<ColorWidget>(sf::Color::White));
+            flash->remove_from_parent();
+            screen->update(window, sf::microseconds(16667));
+        };
+
+        // Warm up until the objects have visited every cell of the
+        // spatial index.
+        for (int i = 0; i < 5000; ++i)
+            frame();
+
+        state.set_items_per_iteration(spawn_count);
+        state.run(frame);
+
+        if (state.get_result().allocations_per_iteration != 0)
+            throw std::runtime_error("A frame allocated " + std::to_string(state.get_result().allocations_per_iteration) + " times.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The per-frame full sort that Screen::update did before.
+    ////////////////////////////////////////////////////////////
+    bench::Registration full_sort("Screen/full_sort", [](bench::State & state)
+    {
+        std::mt19937 rand_engine(42);
+        std::uniform_int_distribution<int> layer(0, 9);
+        std::vector<std::unique_ptr<GameObject> > objects;
+        for (std::size_t i = 0; i < object_count; ++i)
+        {
+            objects.push_back(std::make_unique<EmptyObject>());
+            objects.back()->set_z_index(layer(rand_engine));
+        }
+
+        state.set_items_per_iteration(object_count);
+        state.run([&]()
+        {
+            std::sort(objects.begin(), objects.end(),
+                [](auto && a, auto && b) {
+                    return a->get_z_index() < b->get_z_index();
+                }
+            );
+        });
+    });
+}
@@ -0,0 +1,131 @@
+#include "benchmark.hxx"
+
+#include <SFE/event_manager.hxx>
+#include <SFE/game_object.hxx>
+#include <SFE/screen.hxx>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const object_count = 10000;
+    std::size_t const query_count = 1000;
+
+    ////////////////////////////////////////////////////////////
+    /// A game object without logic that draws nothing.
+    ////////////////////////////////////////////////////////////
+    class EmptyObject : public GameObject
+    {
+    protected:
+        void render_impl(sf::RenderTarget &) const override
+        {}
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Create a screen with small game objects spread over a
+    /// large world.
+    ////////////////////////////////////////////////////////////
+    std::unique_ptr<Screen> make_screen(std::vector<GameObject*> & objects)
+    {
+        auto screen = std::make_unique<Screen>(sf::View(), std::make_shared<EventManager>(), nullptr);
+        std::mt19937 rand_engine(42);
+        std::uniform_real_distribution<float> pos(0.0f, 5000.0f);
+        std::uniform_real_distribution<float> size(10.0f, 50.0f);
+        for (std::size_t i = 0; i < object_count; ++i)
+        {
+            auto obj = std::make_unique<EmptyObject>();
+            obj->set_position(pos(rand_engine), pos(rand_engine));
+            obj->set_size(size(rand_engine), size(rand_engine));
+            objects.push_back(obj.get());
+            screen->add_game_object(std::move(obj));
+        }
+        return screen;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Return random query points.
+    ////////////////////////////////////////////////////////////
+    std::vector<sf::Vector2f> make_points()
+    {
+        std::mt19937 rand_engine(7);
+        std::uniform_real_distribution<float> pos(0.0f, 5000.0f);
+        std::vector<sf::Vector2f> points;
+        for (std::size_t i = 0; i < query_count; ++i)
+            points.emplace_back(pos(rand_engine), pos(rand_engine));
+        return points;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Find the objects under a point with the spatial index.
+    ////////////////////////////////////////////////////////////
+    bench::Registration point_query("SpatialIndex/point_query", [](bench::State & state)
+    {
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        auto const points = make_points();
+        std::vector<GameObject*> result;
+
+        state.set_items_per_iteration(query_count);
+        state.run([&]()
+        {
+            for (auto const & p : points)
+            {
+                result.clear();
+                screen->find_objects_at(p, result);
+            }
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Find the objects under a point by testing every object,
+    /// like the hit test without an index.
+    ////////////////////////////////////////////////////////////
+    bench::Registration point_scan("SpatialIndex/point_scan", [](bench::State & state)
+    {
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        auto const points = make_points();
+        std::vector<GameObject*> result;
+
+        state.set_items_per_iteration(query_count);
+        state.run([&]()
+        {
+            for (auto const & p : points)
+            {
+                result.clear();
+                for (auto obj : objects)
+                    if (obj->contains(p))
+                        result.push_back(obj);
+            }
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Move a tenth of the objects and update the index, as
+    /// happens every frame in a busy scene.
+    ////////////////////////////////////////////////////////////
+    bench::Registration move_objects("SpatialIndex/move", [](bench::State & state)
+    {
+        std::vector<GameObject*> objects;
+        auto const screen = make_screen(objects);
+        std::vector<GameObject*> result;
+        float step = 1.0f;
+
+        state.set_items_per_iteration(object_count / 10);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < objects.size(); i += 10)
+            {
+                auto const & p = objects[i]->get_position();
+                objects[i]->set_position(p.x + step, p.y);
+            }
+            step = -step;
+            result.clear();
+            screen->find_objects_at({ 0.0f, 0.0f }, result);
+        });
+    });
+}
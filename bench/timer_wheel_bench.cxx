@@ -0,0 +1,101 @@
+#include "benchmark.hxx"
+
+#include <SFE/event_manager.hxx>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const pending_timers = 10000;
+
+    ////////////////////////////////////////////////////////////
+    /// Advance thousands of repeating timers by one 60 fps frame
+    /// and dispatch the events that fired.
+    ////////////////////////////////////////////////////////////
+    bench::Registration advance_timers("EventManager/advance_timers", [](bench::State & state)
+    {
+        Event const tick("Tick");
+        EventManager event_manager;
+        event_manager.register_event("Tick");
+        std::size_t counter = 0;
+        auto const listener = event_manager.register_listener(tick, [&counter](Event const&) { ++counter; });
+        std::mt19937 rand_engine(42);
+        std::uniform_int_distribution<int> interval_ms(100, 5000);
+        for (std::size_t i = 0; i < pending_timers; ++i)
+            event_manager.enqueue_every(tick, sf::milliseconds(interval_ms(rand_engine)));
+
+        state.set_items_per_iteration(pending_timers);
+        state.run([&]()
+        {
+            event_manager.advance_timers(sf::microseconds(16667));
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// The same workload with one polled countdown per timer,
+    /// as the game objects did it before.
+    ////////////////////////////////////////////////////////////
+    bench::Registration poll_countdowns("Countdowns/poll", [](bench::State & state)
+    {
+        Event const tick("Tick");
+        EventManager event_manager;
+        event_manager.register_event("Tick");
+        std::size_t counter = 0;
+        auto const listener = event_manager.register_listener(tick, [&counter](Event const&) { ++counter; });
+        std::mt19937 rand_engine(42);
+        std::uniform_int_distribution<int> interval_ms(100, 5000);
+        struct Countdown
+        {
+            sf::Time remaining;
+            sf::Time interval;
+        };
+        std::vector<Countdown> countdowns;
+        for (std::size_t i = 0; i < pending_timers; ++i)
+        {
+            auto const interval = sf::milliseconds(interval_ms(rand_engine));
+            countdowns.push_back({ interval, interval });
+        }
+
+        state.set_items_per_iteration(pending_timers);
+        state.run([&]()
+        {
+            auto const elapsed_time = sf::microseconds(16667);
+            for (auto & c : countdowns)
+            {
+                c.remaining -= elapsed_time;
+                if (c.remaining <= sf::Time::Zero)
+                {
+                    c.remaining += c.interval;
+                    event_manager.enqueue(tick);
+                }
+            }
+            event_manager.dispatch();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Add and cancel one-shot timers.
+    ////////////////////////////////////////////////////////////
+    bench::Registration add_cancel_timers("EventManager/add_cancel_timers", [](bench::State & state)
+    {
+        Event const tick("Tick");
+        EventManager event_manager;
+        event_manager.register_event("Tick");
+        std::vector<TimerId> ids(1000);
+
+        state.set_items_per_iteration(ids.size());
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                ids[i] = event_manager.enqueue_after(tick, sf::milliseconds(static_cast<sf::Int32>(i * 97 % 100000)));
+            for (auto id : ids)
+                event_manager.cancel_timer(id);
+        });
+    });
+
+}
@@ -0,0 +1,253 @@
+#include "benchmark.hxx"
+
+#include <SFE/render_commands.hxx>
+#include <SFE/sprite_batch.hxx>
+#include <SFE/widget.hxx>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    using namespace sfe;
+
+    std::size_t const tree_depth = 6;
+    std::size_t const tree_fanout = 4;
+    std::size_t const mouse_points = 64;
+    std::size_t const wide_fanout = 100;
+    std::size_t const changes_per_frame = 16;
+
+    ////////////////////////////////////////////////////////////
+    /// Add fanout subwidgets side by side to the widget and
+    /// recurse until the depth is reached. The added widgets are
+    /// appended in depth-first order.
+    ////////////////////////////////////////////////////////////
+    void add_subtree(Widget & parent, std::size_t depth, std::size_t fanout, std::vector<Widget *> & widgets)
+    {
+        if (depth == 0)
+            return;
+        for (std::size_t i = 0; i < fanout; ++i)
+        {
+            auto w = std::make_unique<Widget>();
+            w->set_x(i / static_cast<float>(fanout));
+            w->set_y(0.1f);
+            w->set_width(1.0f / fanout);
+            w->set_height(0.8f);
+            w->set_z_index(static_cast<int>(i));
+            widgets.push_back(parent.add_widget(std::move(w)));
+            add_subtree(*widgets.back(), depth - 1, fanout, widgets);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// A widget tree with its render rectangles computed.
+    ////////////////////////////////////////////////////////////
+    struct WidgetTree
+    {
+        WidgetTree(std::size_t depth = tree_depth, std::size_t fanout = tree_fanout)
+            :
+            widgets{ &root }
+        {
+            add_subtree(root, depth, fanout, widgets);
+            size = widgets.size();
+            layout();
+        }
+
+        void layout()
+        {
+            commands.clear();
+            batch.begin(commands);
+            root.render(batch, { 0.0f, 0.0f, 1.0f, 1.0f });
+            batch.end();
+        }
+
+        Widget root;
+        std::vector<Widget *> widgets;
+        std::size_t size;
+        RenderCommands commands;
+        SpriteBatch batch;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Compute the render rectangles of all widgets.
+    ////////////////////////////////////////////////////////////
+    bench::Registration layout_deep("Widget/layout_deep", [](bench::State & state)
+    {
+        WidgetTree tree;
+
+        state.set_items_per_iteration(tree.size);
+        state.run([&]()
+        {
+            tree.layout();
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Lay out the tree without changes.
+    ////////////////////////////////////////////////////////////
+    bench::Registration layout_static("Widget/layout_static", [](bench::State & state)
+    {
+        WidgetTree tree;
+
+        state.set_items_per_iteration(tree.size);
+        state.run([&]()
+        {
+            tree.root.layout({ 0.0f, 0.0f, 1.0f, 1.0f });
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Lay out the tree after moving a widget below the root,
+    /// so its subtree must be recomputed.
+    ////////////////////////////////////////////////////////////
+    bench::Registration layout_moved("Widget/layout_moved", [](bench::State & state)
+    {
+        WidgetTree tree;
+        auto & w = *tree.widgets[1];
+        auto x = 0.0f;
+
+        state.set_items_per_iteration(tree.size);
+        state.run([&]()
+        {
+            x = 0.1f - x;
+            w.set_x(x);
+            tree.root.layout({ 0.0f, 0.0f, 1.0f, 1.0f });
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Move the mouse across the tree.
+    ////////////////////////////////////////////////////////////
+    bench::Registration hit_test_deep("Widget/hit_test_deep", [](bench::State & state)
+    {
+        WidgetTree tree;
+        std::vector<sf::Vector2f> points;
+        for (std::size_t i = 0; i < mouse_points; ++i)
+            points.emplace_back((i + 0.5f) / mouse_points, 0.5f);
+
+        state.set_items_per_iteration(mouse_points);
+        state.run([&]()
+        {
+            for (auto const & p : points)
+                tree.root.update_mouse(p.x, p.y);
+        });
+
+        if (!tree.root.get_mouseover())
+            throw std::runtime_error("The mouse is not over the root widget.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Move the mouse across a tree of 10101 widgets (depth 2,
+    /// fanout 100), where most subtrees are skipped by their
+    /// bounds.
+    ////////////////////////////////////////////////////////////
+    bench::Registration hit_test_wide("Widget/hit_test_10k", [](bench::State & state)
+    {
+        WidgetTree tree(2, wide_fanout);
+        std::vector<sf::Vector2f> points;
+        for (std::size_t i = 0; i < mouse_points; ++i)
+            points.emplace_back((i + 0.5f) / mouse_points, 0.5f);
+
+        state.set_items_per_iteration(mouse_points);
+        state.run([&]()
+        {
+            for (auto const & p : points)
+                tree.root.update_mouse(p.x, p.y);
+        });
+
+        if (!tree.root.get_mouseover())
+            throw std::runtime_error("The mouse is not over the root widget.");
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Show and hide an absorbing popup under the resting mouse.
+    /// Like Screen, the tree is rendered between the changes and
+    /// the hit test, which only runs if the tree changed.
+    ////////////////////////////////////////////////////////////
+    bench::Registration hit_test_changed("Widget/hit_test_changed", [](bench::State & state)
+    {
+        WidgetTree tree(2, wide_fanout);
+        sf::Vector2f const mouse(0.995f, 0.5f);
+        auto const covered = tree.widgets[1 + (wide_fanout - 1) * (wide_fanout + 1)];
+        tree.root.update_mouse(mouse.x, mouse.y);
+        Widget* popup = nullptr;
+
+        state.set_items_per_iteration(1);
+        state.run([&]()
+        {
+            if (popup)
+            {
+                tree.root.remove_widget(popup);
+                popup = nullptr;
+            }
+            else
+            {
+                auto w = std::make_unique<Widget>();
+                w->set_x(0.9f);
+                w->set_width(0.1f);
+                w->set_z_index(static_cast<int>(wide_fanout));
+                w->set_absorb_click(true);
+                popup = tree.root.add_widget(std::move(w));
+            }
+            tree.layout();
+            tree.root.layout({ 0.0f, 0.0f, 1.0f, 1.0f });
+            if (tree.root.needs_mouse_update())
+                tree.root.update_mouse(mouse.x, mouse.y);
+
+            if (covered->get_mouseover() == (popup != nullptr) || (popup && !popup->get_mouseover()))
+                throw std::runtime_error("The hover state is stale.");
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Update the logic of all widgets.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_deep("Widget/update_deep", [](bench::State & state)
+    {
+        WidgetTree tree;
+
+        state.set_items_per_iteration(tree.size);
+        state.run([&]()
+        {
+            tree.root.update(sf::seconds(1.0f / 60.0f));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Update a tree of 10101 widgets (depth 2, fanout 100)
+    /// without changes.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_wide("Widget/update_10k", [](bench::State & state)
+    {
+        WidgetTree tree(2, wide_fanout);
+
+        state.set_items_per_iteration(tree.size);
+        state.run([&]()
+        {
+            tree.root.update(sf::seconds(1.0f / 60.0f));
+        });
+    });
+
+    ////////////////////////////////////////////////////////////
+    /// Update the same tree after changing the z-index of some
+    /// widgets, so only their parents reorder their subwidgets.
+    ////////////////////////////////////////////////////////////
+    bench::Registration update_wide_reorder("Widget/update_10k_reorder", [](bench::State & state)
+    {
+        WidgetTree tree(2, wide_fanout);
+        std::size_t next = 1;
+        int z = 0;
+
+        state.set_items_per_iteration(tree.size);
+        state.run([&]()
+        {
+            for (std::size_t i = 0; i < changes_per_frame; ++i)
+            {
+                next = (next + 7919) % tree.size;
+                tree.widgets[next]->set_z_index(--z);
+            }
+            tree.root.update(sf::seconds(1.0f / 60.0f));
+        });
+    });
+}
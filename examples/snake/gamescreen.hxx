@@ -32,6 +32,16 @@ namespace snake
         return{ vx, vy };
     }
 
+    ////////////////////////////////////////////////////////////
+    /// The payload of the CollectedCoin event holds the field
+    /// coordinates of the coin.
+    ////////////////////////////////////////////////////////////
+    struct CollectedCoin
+    {
+        int x;
+        int y;
+    };
+
     ////////////////////////////////////////////////////////////
     /// The game screen.
     ////////////////////////////////////////////////////////////
@@ -50,21 +60,20 @@ namespace snake
     private:
 
         ////////////////////////////////////////////////////////////
-        /// A FieldObject holds the GameObject and the position of a
-        /// snake part.
+        /// A FieldObject holds the handle of the GameObject and the
+        /// position of a snake part.
         ////////////////////////////////////////////////////////////
         struct FieldObject
         {
             FieldObject()
                 :
                 x(0),
-                y(0),
-                obj(nullptr)
+                y(0)
             {}
 
             int x;
             int y;
-            sfe::GameObject* obj;
+            sfe::GameObjectHandle obj;
         };
 
         ////////////////////////////////////////////////////////////
@@ -120,10 +129,21 @@ namespace snake
         void create_gui();
 
         ////////////////////////////////////////////////////////////
-        /// Move the snake.
+        /// Read the user input and update the special effects.
         ////////////////////////////////////////////////////////////
         void update_impl(sf::Time elapsed_time);
 
+        ////////////////////////////////////////////////////////////
+        /// Move the snake by one field.
+        ////////////////////////////////////////////////////////////
+        void step();
+
+        ////////////////////////////////////////////////////////////
+        /// Start the step timer with the current step time. A
+        /// running step timer is cancelled.
+        ////////////////////////////////////////////////////////////
+        void restart_step_timer();
+
         ////////////////////////////////////////////////////////////
         /// Update the direction according to the user input.
         ////////////////////////////////////////////////////////////
@@ -190,7 +210,7 @@ namespace snake
         ////////////////////////////////////////////////////////////
         /// The food.
         ////////////////////////////////////////////////////////////
-        sfe::GameObject* food_;
+        sfe::GameObjectHandle food_;
 
         ////////////////////////////////////////////////////////////
         /// The random engine.
@@ -214,9 +234,10 @@ namespace snake
         sf::Time step_time_;
 
         ////////////////////////////////////////////////////////////
-        /// The time until the next snake step.
+        /// The timer that fires the Step events (0 if the snake is
+        /// not running).
         ////////////////////////////////////////////////////////////
-        sf::Time until_next_step_;
+        sfe::TimerId step_timer_;
 
         ////////////////////////////////////////////////////////////
         /// Whether the snake is currently running.
@@ -257,7 +278,7 @@ namespace snake
         /// The coins. Key is the (x, y) coordinate of the coin
         /// position in the field.
         ////////////////////////////////////////////////////////////
-        std::map<std::pair<int, int>, sfe::GameObject*> coins_;
+        std::map<std::pair<int, int>, sfe::GameObjectHandle> coins_;
 
     }; // class GameScreen
 
@@ -267,7 +288,8 @@ namespace snake
     )   :
         Screen(sf::View(), event_manager, resource_manager),
         fields_(num_fields_x, num_fields_y, FieldType::Empty),
-        rand_engine_(std::random_device()())
+        rand_engine_(std::random_device()()),
+        step_timer_(0)
     {
         init_ = [this]()
         {
@@ -296,7 +318,9 @@ namespace snake
         current_direction_ = Direction::Right;
         new_direction_ = Direction::Right;
         step_time_ = sf::seconds(0.4f);
-        until_next_step_ = step_time_;
+        if (step_timer_ != 0)
+            get_event_manager()->cancel_timer(step_timer_);
+        step_timer_ = 0;
         running_ = false;
         food_counter_ = 0;
         easymode_ = true;
@@ -313,14 +337,14 @@ namespace snake
 
         // Create the background image.
         auto const ratio = get_game_view().getSize().x / get_game_view().getSize().y;
-        auto camel_texture = get_resource_manager()->get_texture("img/camel_bg.jpg");
+        auto camel_texture = get_resource_manager()->get_texture_region("img/camel_bg.jpg");
         auto bg = std::make_unique<ImageObject>(camel_texture);
         bg->set_z_index(-2);
         bg->set_size(2 * ratio, 2);
         add_game_object(std::move(bg));
 
         // Create the borders of the game field.
-        auto frame_texture = get_resource_manager()->get_texture("img/frame.png");
+        auto frame_texture = get_resource_manager()->get_texture_region("img/frame.png");
         auto field_border = std::make_unique<ImageObject>(frame_texture);
         field_border->set_z_index(-1);
         field_border->set_size(game_field_width * 1.11286407767f, game_field_height * 1.16006884682f);
@@ -332,7 +356,7 @@ namespace snake
             create_body_part(snake_head_.x - 1 - i, snake_head_.y);
 
         // Spawn the first food item.
-        auto strawberry_texture = get_resource_manager()->get_texture("img/strawberry.png");
+        auto strawberry_texture = get_resource_manager()->get_texture_region("img/strawberry.png");
         auto food = std::make_unique<ImageObject>(strawberry_texture);
         food->set_size(field_width, field_height);
         food_ = add_game_object(std::move(food));
@@ -350,17 +374,22 @@ namespace snake
             throw GameException("The GameScreen needs an event manager.");
         }
         auto & event_manager = *event_manager_shared_ptr;
-        event_manager.register_event(Event("SelectEasyDifficulty"));
-        event_manager.register_event(Event("SelectHardDifficulty"));
-        event_manager.register_event(Event("StartGame"));
-        event_manager.register_event(Event("MovedSnake"));
-        event_manager.register_event(Event("CollectedFood"));
-        event_manager.register_event(Event("CollectedCoin"));
-        event_manager.register_event(Event("AddSpecialEffect"));
-        event_manager.register_event(Event("ClearSpecialEffects"));
-        event_manager.register_event(Event("GameOver"));
-        event_manager.register_event(Event("SoundOn"));
-        event_manager.register_event(Event("SoundOff"));
+        event_manager.register_event("SelectEasyDifficulty");
+        event_manager.register_event("SelectHardDifficulty");
+        event_manager.register_event("StartGame");
+        event_manager.register_event("Step");
+        event_manager.register_event("MovedSnake");
+        event_manager.register_event("CollectedFood");
+        event_manager.register_event("CollectedCoin");
+        event_manager.register_event("AddSpecialEffect");
+        event_manager.register_event("ClearSpecialEffects");
+        event_manager.register_event("GameOver");
+        event_manager.register_event("SoundOn");
+        event_manager.register_event("SoundOff");
+
+        // The step timer catches up after a stall. The snake moves at
+        // most one field per frame, so it cannot pass a wall unseen.
+        event_manager.set_coalesce_policy(SFE_EVENT("Step"), CoalescePolicy::DropDuplicates);
 
         auto create_and_register_listener = [&](Event const& event, Listener::Callback f)
         {
@@ -370,7 +399,7 @@ namespace snake
 
         // Select easy difficulty.
         create_and_register_listener(
-            Event("SelectEasyDifficulty"),
+            SFE_EVENT("SelectEasyDifficulty"),
             [this](Event const & event) {
                 easymode_ = true;
             }
@@ -378,7 +407,7 @@ namespace snake
 
         // Select hard difficulty.
         create_and_register_listener(
-            Event("SelectHardDifficulty"),
+            SFE_EVENT("SelectHardDifficulty"),
             [this](Event const & event) {
                 easymode_ = false;
             }
@@ -386,42 +415,54 @@ namespace snake
 
         // Start the game.
         create_and_register_listener(
-            Event("StartGame"),
+            SFE_EVENT("StartGame"),
             [this](Event const & event) {
                 if (!easymode_)
                     step_time_ = sf::seconds(0.1f);
                 running_ = true;
+                restart_step_timer();
+            }
+        );
+
+        // Move the snake.
+        create_and_register_listener(
+            SFE_EVENT("Step"),
+            [this](Event const & event) {
+                if (running_)
+                    step();
             }
         );
 
         // Collected food.
         create_and_register_listener(
-            Event("CollectedFood"),
+            SFE_EVENT("CollectedFood"),
             [this, &event_manager](Event const & event) {
                 // TODO: Add some points.
                 ++food_counter_;
                 ++event_counter_;
                 spawn_food();
                 step_time_ = 0.9f * (step_time_ - sf::seconds(0.04f)) + sf::seconds(0.04f);
+                restart_step_timer();
 
                 // In hard mode: Add or remove a special effect.
                 if (!easymode_)
                 {
                     if ((event_counter_ + 4) % 8 == 0)
-                        event_manager.enqueue(Event("AddSpecialEffect"));
+                        event_manager.enqueue(SFE_EVENT("AddSpecialEffect"));
                     if (event_counter_ > 0 && (event_counter_ + 8) % 8 == 0)
-                        event_manager.enqueue(Event("ClearSpecialEffects"));
+                        event_manager.enqueue(SFE_EVENT("ClearSpecialEffects"));
                 }
             }
         );
         
         // Collected coin.
         create_and_register_listener(
-            Event("CollectedCoin"),
+            SFE_EVENT("CollectedCoin"),
             [this](Event const & event) {
                 // TODO: Add some points.
-                // Remove the current selected coin.
-                auto it = coins_.find({ snake_head_.x, snake_head_.y });
+                // Remove the collected coin.
+                auto const & coin = event.get_payload<CollectedCoin>();
+                auto it = coins_.find({ coin.x, coin.y });
                 if (it != coins_.end())
                 {
                     remove_game_object(it->second);
@@ -439,7 +480,7 @@ namespace snake
 
         // Add special effect.
         create_and_register_listener(
-            Event("AddSpecialEffect"),
+            SFE_EVENT("AddSpecialEffect"),
             [this](Event const & event) {
                 add_special_effect();
             }
@@ -447,7 +488,7 @@ namespace snake
 
         // Clear special effects.
         create_and_register_listener(
-            Event("ClearSpecialEffects"),
+            SFE_EVENT("ClearSpecialEffects"),
             [this](Event const & event) {
                 clear_special_effects();
             }
@@ -455,7 +496,7 @@ namespace snake
 
         // Game over.
         create_and_register_listener(
-            Event("GameOver"),
+            SFE_EVENT("GameOver"),
             [this](Event const & event) {
                 std::cout << "Game over." << std::endl;
                 std::cout << "You collected " << food_counter_ << " food." << std::endl;
@@ -464,13 +505,13 @@ namespace snake
         );
 
         create_and_register_listener(
-            Event("SoundOn"),
+            SFE_EVENT("SoundOn"),
             [](Event const & event) {
                 std::cout << "Sound ON!" << std::endl;
             }
         );
         create_and_register_listener(
-            Event("SoundOff"),
+            SFE_EVENT("SoundOff"),
             [](Event const & event) {
                 std::cout << "Sound OFF!" << std::endl;
             }
@@ -494,7 +535,7 @@ namespace snake
         container_ptr->set_align_y(AlignY::Center);
         container_ptr->set_height(0.4f);
         auto difficulty_remover = event_manager.register_listener(
-            Event("StartGame"),
+            SFE_EVENT("StartGame"),
             [container_ptr](Event const& event)
         {
             container_ptr->remove_from_parent();
@@ -502,7 +543,7 @@ namespace snake
         container_ptr->add_listener(std::move(difficulty_remover));
 
         // Create the box for the currently selected item.
-        auto text_frame_texture = get_resource_manager()->get_texture("img/text_frame.png");
+        auto text_frame_texture = get_resource_manager()->get_texture_region("img/text_frame.png");
         auto text_frame = std::make_unique<ImageWidget>(text_frame_texture);
         auto frame_ptr = container_ptr->add_widget(std::move(text_frame));
         frame_ptr->set_align_x(AlignX::Center);
@@ -510,14 +551,14 @@ namespace snake
         frame_ptr->set_height(0.5f);
         frame_ptr->set_scale(Scale::X);
         auto frame_easy_selector = event_manager.register_listener(
-            Event("SelectEasyDifficulty"),
+            SFE_EVENT("SelectEasyDifficulty"),
             [frame_ptr](Event const& event)
         {
             frame_ptr->set_align_y(AlignY::Top);
         });
         frame_ptr->add_listener(std::move(frame_easy_selector));
         auto frame_hard_selector = event_manager.register_listener(
-            Event("SelectHardDifficulty"),
+            SFE_EVENT("SelectHardDifficulty"),
             [frame_ptr](Event const& event)
         {
             frame_ptr->set_align_y(AlignY::Bottom);
@@ -525,32 +566,32 @@ namespace snake
         frame_ptr->add_listener(std::move(frame_hard_selector));
 
         // Create the "easy" text.
-        auto easy_texture = get_resource_manager()->get_texture("img/easy.png");
+        auto easy_texture = get_resource_manager()->get_texture_region("img/easy.png");
         auto easy = std::make_unique<ImageWidget>(easy_texture);
         easy->set_align_x(AlignX::Center);
         easy->set_align_y(AlignY::Top);
         easy->set_height(0.5f);
         easy->set_scale(Scale::X);
         easy->add_mouse_enter_callback([frame_ptr, &event_manager](Widget & w) {
-            event_manager.enqueue(Event("SelectEasyDifficulty"));
+            event_manager.enqueue(SFE_EVENT("SelectEasyDifficulty"));
         });
         easy->add_click_end_callback([this, &event_manager](Widget & w) {
-            event_manager.enqueue(Event("StartGame"));
+            event_manager.enqueue(SFE_EVENT("StartGame"));
         });
         container_ptr->add_widget(std::move(easy));
 
         // Create the "hard" text.
-        auto hard_texture = get_resource_manager()->get_texture("img/hard.png");
+        auto hard_texture = get_resource_manager()->get_texture_region("img/hard.png");
         auto hard = std::make_unique<ImageWidget>(hard_texture);
         hard->set_align_x(AlignX::Center);
         hard->set_align_y(AlignY::Bottom);
         hard->set_height(0.5f);
         hard->set_scale(Scale::X);
         hard->add_mouse_enter_callback([&event_manager](Widget & w) {
-            event_manager.enqueue(Event("SelectHardDifficulty"));
+            event_manager.enqueue(SFE_EVENT("SelectHardDifficulty"));
         });
         hard->add_click_end_callback([&event_manager](Widget & w) {
-            event_manager.enqueue(Event("StartGame"));
+            event_manager.enqueue(SFE_EVENT("StartGame"));
         });
         container_ptr->add_widget(std::move(hard));
 
@@ -575,7 +616,7 @@ namespace snake
         for (int i = 0; i < 4; ++i)
         {
             // Create the sound widget.
-            auto sound_texture = get_resource_manager()->get_texture(sound_file[i]);
+            auto sound_texture = get_resource_manager()->get_texture_region(sound_file[i]);
             auto sound = std::make_unique<ImageWidget>(sound_texture);
             auto ptr = sound_container_ptr->add_widget(std::move(sound));
             sound_ptr.push_back(ptr);
@@ -599,12 +640,12 @@ namespace snake
                 ptr->set_visible(!ptr->get_visible());
             };
             auto sound_on_listener = event_manager.register_listener(
-                Event("SoundOn"),
+                SFE_EVENT("SoundOn"),
                 sound_toggle
             );
             ptr->add_listener(std::move(sound_on_listener));
             auto sound_off_listener = event_manager.register_listener(
-                Event("SoundOff"),
+                SFE_EVENT("SoundOff"),
                 sound_toggle
             );
             ptr->add_listener(std::move(sound_off_listener));
@@ -615,9 +656,9 @@ namespace snake
         // it is only added to one of the widgets.
         sound_ptr[0]->add_click_end_callback([sound_ptr, &event_manager](Widget & w) {
             if (sound_ptr[0]->get_visible())
-                event_manager.enqueue(Event("SoundOn"));
+                event_manager.enqueue(SFE_EVENT("SoundOn"));
             else
-                event_manager.enqueue(Event("SoundOff"));
+                event_manager.enqueue(SFE_EVENT("SoundOff"));
         });
 
         // By default, show the sound-on icons.
@@ -633,48 +674,51 @@ namespace snake
             // Update the direction according to the user input.
             update_direction();
 
-            // Make a step.
-            until_next_step_ -= elapsed_time;
-            if (until_next_step_ < sf::Time::Zero)
-            {
-                auto event_manager_shared_ptr = get_event_manager();
-                if (!event_manager_shared_ptr)
-                {
-                    throw sfe::GameException("The GameScreen needs an event manager.");
-                }
-                auto & event_manager = *event_manager_shared_ptr;
-
-                // Check if the snake collides with itself or the boundary.
-                auto const new_head = get_new_head();
-                if (new_head.x < 0 || new_head.x >= num_fields_x ||
-                    new_head.y < 0 || new_head.y >= num_fields_y ||
-                    fields_(new_head.x, new_head.y) == FieldType::Snake)
-                {
-                    event_manager.enqueue(sfe::Event("GameOver"));
-                }
-                else
-                {
-                    // Move the snake and spawn an additional body part if food was collected.
-                    bool const got_food = fields_(new_head.x, new_head.y) == FieldType::Food;
-                    bool const got_coin = fields_(new_head.x, new_head.y) == FieldType::Coin;
-                    move_snake(got_food || got_coin, new_head);
-                    if (got_food)
-                        event_manager.enqueue(sfe::Event("CollectedFood"));
-                    else if (got_coin)
-                        event_manager.enqueue(sfe::Event("CollectedCoin"));
-                    else
-                        event_manager.enqueue(sfe::Event("MovedSnake"));
-                }
-
-                // Update the step time.
-                until_next_step_ += step_time_;
-            }
-
             // Update the special effects.
             update_special_effects(elapsed_time);
         }
     }
 
+    inline void GameScreen::step()
+    {
+        auto event_manager_shared_ptr = get_event_manager();
+        if (!event_manager_shared_ptr)
+        {
+            throw sfe::GameException("The GameScreen needs an event manager.");
+        }
+        auto & event_manager = *event_manager_shared_ptr;
+
+        // Check if the snake collides with itself or the boundary.
+        auto const new_head = get_new_head();
+        if (new_head.x < 0 || new_head.x >= num_fields_x ||
+            new_head.y < 0 || new_head.y >= num_fields_y ||
+            fields_(new_head.x, new_head.y) == FieldType::Snake)
+        {
+            event_manager.enqueue(SFE_EVENT("GameOver"));
+        }
+        else
+        {
+            // Move the snake and spawn an additional body part if food was collected.
+            bool const got_food = fields_(new_head.x, new_head.y) == FieldType::Food;
+            bool const got_coin = fields_(new_head.x, new_head.y) == FieldType::Coin;
+            move_snake(got_food || got_coin, new_head);
+            if (got_food)
+                event_manager.enqueue(SFE_EVENT("CollectedFood"));
+            else if (got_coin)
+                event_manager.enqueue(SFE_EVENT("CollectedCoin"), CollectedCoin{ new_head.x, new_head.y });
+            else
+                event_manager.enqueue(SFE_EVENT("MovedSnake"));
+        }
+    }
+
+    inline void GameScreen::restart_step_timer()
+    {
+        auto & event_manager = *get_event_manager();
+        if (step_timer_ != 0)
+            event_manager.cancel_timer(step_timer_);
+        step_timer_ = event_manager.enqueue_every(SFE_EVENT("Step"), step_time_);
+    }
+
     inline void GameScreen::update_direction()
     {
         // Read the user input and change the direction variable.
@@ -691,7 +735,7 @@ namespace snake
             new_direction_ = Direction::Left;
 
         // Change the direction of the snake head image.
-        auto head_ptr = dynamic_cast<sfe::ImageObject*>(snake_head_.obj);
+        auto head_ptr = dynamic_cast<sfe::ImageObject*>(get_game_object(snake_head_.obj));
         if (new_direction_ == Direction::Left)
         {
             head_ptr->set_rotation(0);
@@ -735,7 +779,7 @@ namespace snake
 
         // Create the game object and add it to the screen.
         auto const pos = field_to_view(x, y);
-        auto snake_head_texture = get_resource_manager()->get_texture("img/snake_head.png");
+        auto snake_head_texture = get_resource_manager()->get_texture_region("img/snake_head.png");
         auto head = std::make_unique<sfe::ImageObject>(snake_head_texture);
         head->set_size(field_width, field_height);
         head->set_position(pos);
@@ -752,7 +796,7 @@ namespace snake
 
         // Create the game object and add it to the screen.
         auto const pos = field_to_view(x, y);
-        auto snake_body_texture = get_resource_manager()->get_texture("img/snake_body.png");
+        auto snake_body_texture = get_resource_manager()->get_texture_region("img/snake_body.png");
         auto body = std::make_unique<sfe::ImageObject>(snake_body_texture);
         body->set_size(field_width, field_height);
         body->set_position(pos);
@@ -798,7 +842,7 @@ namespace snake
             fields_(back.x, back.y) = FieldType::Empty;
             back.x = snake_head_.x;
             back.y = snake_head_.y;
-            back.obj->set_position(field_to_view(back.x, back.y));
+            get_game_object(back.obj)->set_position(field_to_view(back.x, back.y));
             snake_body_.push_front(back);
         }
 
@@ -806,7 +850,7 @@ namespace snake
         fields_(new_head_pos.x, new_head_pos.y) = FieldType::Snake;
         snake_head_.x = new_head_pos.x;
         snake_head_.y = new_head_pos.y;
-        snake_head_.obj->set_position(field_to_view(new_head_pos.x, new_head_pos.y));
+        get_game_object(snake_head_.obj)->set_position(field_to_view(new_head_pos.x, new_head_pos.y));
     }
 
     inline void GameScreen::spawn_food()
@@ -829,8 +873,9 @@ namespace snake
                 if (i == pos)
                 {
                     fields_(x, y) = FieldType::Food;
-                    food_->set_position(field_to_view(x, y));
-                    food_->set_visible(true);
+                    auto const food = get_game_object(food_);
+                    food->set_position(field_to_view(x, y));
+                    food->set_visible(true);
                     return;
                 }
                 ++i;
@@ -870,7 +915,7 @@ namespace snake
             for (auto & f : fields_)
                 if (f == FieldType::Food)
                     f = FieldType::Empty;
-            food_->set_visible(false);
+            get_game_object(food_)->set_visible(false);
 
             // Spawn the coins.
             while (snake_body_.size() > 1)
@@ -878,12 +923,12 @@ namespace snake
                 auto const part = snake_body_.back();
                 snake_body_.pop_back();
                 fields_(part.x, part.y) = FieldType::Coin;
-                auto part_ptr = dynamic_cast<ImageObject*>(part.obj);
+                auto part_ptr = dynamic_cast<ImageObject*>(get_game_object(part.obj));
                 if (part_ptr == nullptr)
                     throw ScreenException("GameScreen::add_special_effect(): Failed to cast snake body part to ImageObject*.");
-                auto coin_texture = get_resource_manager()->get_texture("img/coin.png");
+                auto coin_texture = get_resource_manager()->get_texture_region("img/coin.png");
                 part_ptr->set_texture(coin_texture);
-                coins_[{part.x, part.y}] = part_ptr;
+                coins_[{part.x, part.y}] = part.obj;
             }
 
         }
@@ -13,6 +13,21 @@ int main()
 
 void snake::SnakeGame::init_impl()
 {
+    // Pack the small images into one texture, so the scene needs only a few texture switches.
+    get_resource_manager()->build_atlas({
+        "img/coin.png",
+        "img/easy.png",
+        "img/frame.png",
+        "img/hard.png",
+        "img/snake_body.png",
+        "img/snake_head.png",
+        "img/sound_off.png",
+        "img/sound_off_glow.png",
+        "img/sound_on.png",
+        "img/sound_on_glow.png",
+        "img/strawberry.png",
+        "img/text_frame.png"
+    });
     load_screen(std::make_unique<GameScreen>(get_event_manager(), get_resource_manager()));
 }
 
@@ -0,0 +1,79 @@
+#ifndef SFE_ARENA_HXX
+#define SFE_ARENA_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// The arena is a bump allocator for short-lived data. The
+    /// memory is handed out from large blocks and released all
+    /// at once by reset(). The blocks are kept, so an arena that
+    /// is reset once per frame stops allocating after the first
+    /// frames. The arena does not call any destructors.
+    ////////////////////////////////////////////////////////////
+    class SFE_API Arena
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an arena that allocates blocks of the given size.
+        ////////////////////////////////////////////////////////////
+        explicit Arena(std::size_t block_size = 64 * 1024);
+
+        ////////////////////////////////////////////////////////////
+        /// Return memory of the given size and alignment. The
+        /// memory stays valid until the next call to reset().
+        ////////////////////////////////////////////////////////////
+        void* allocate(std::size_t size, std::size_t alignment);
+
+        ////////////////////////////////////////////////////////////
+        /// Release all memory that was handed out.
+        ////////////////////////////////////////////////////////////
+        void reset();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the total size of the allocated blocks.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_capacity() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// A memory block.
+        ////////////////////////////////////////////////////////////
+        struct Block
+        {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The default block size.
+        ////////////////////////////////////////////////////////////
+        std::size_t block_size_;
+
+        ////////////////////////////////////////////////////////////
+        /// The memory blocks.
+        ////////////////////////////////////////////////////////////
+        std::vector<Block> blocks_;
+
+        ////////////////////////////////////////////////////////////
+        /// The index of the block that is currently used.
+        ////////////////////////////////////////////////////////////
+        std::size_t current_block_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of used bytes in the current block.
+        ////////////////////////////////////////////////////////////
+        std::size_t offset_;
+
+    }; // class Arena
+
+} // namespace sfe
+
+#endif
@@ -3,42 +3,260 @@
 
 #include <SFE/sfestd.hxx>
 #include <SFE/propagate_const.hxx>
+#include <SFE/event_stats.hxx>
 
+#include <SFML/System/Time.hpp>
+
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////
+/// SFE_EVENT(name) creates the event with the given name,
+/// which must be a string literal, and always hashes the name
+/// at compile time. Event(name) may hash it at run time.
+////////////////////////////////////////////////////////////
+#define SFE_EVENT(name) ::sfe::Event::from_id(std::integral_constant< ::sfe::EventId, ::sfe::hash_event_name(name)>::value)
 
 namespace sfe
 {
     ////////////////////////////////////////////////////////////
-    /// The event class is a wrapper around std::string.
+    /// The type of the hashed event names.
+    ////////////////////////////////////////////////////////////
+    typedef std::uint64_t EventId;
+
+    ////////////////////////////////////////////////////////////
+    /// Compute the id of the event name with the given length
+    /// (64 bit FNV-1a hash).
+    ////////////////////////////////////////////////////////////
+    constexpr EventId hash_event_name(char const* name, std::size_t length)
+    {
+        EventId h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            h ^= static_cast<unsigned char>(name[i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Compute the id of the given null-terminated event name.
+    ////////////////////////////////////////////////////////////
+    constexpr EventId hash_event_name(char const* name)
+    {
+        std::size_t length = 0;
+        while (name[length] != '\0')
+            ++length;
+        return hash_event_name(name, length);
+    }
+
+    namespace detail
+    {
+        ////////////////////////////////////////////////////////////
+        /// The address of PayloadType<T>::id identifies the payload
+        /// type T.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        struct PayloadType
+        {
+            static char const id;
+        };
+
+        template <typename T>
+        char const PayloadType<T>::id = 0;
+
+    } // namespace detail
+
+    ////////////////////////////////////////////////////////////
+    /// The event class is a wrapper around the hashed event
+    /// name. Creating, copying and comparing events never
+    /// allocates. The constructor is constexpr, so names are
+    /// hashed at compile time in constant expressions and by
+    /// SFE_EVENT.
+    ///
+    /// An event that was enqueued with a payload carries a
+    /// pointer to the payload. The payload is only valid while
+    /// the event is dispatched.
     ////////////////////////////////////////////////////////////
     class SFE_API Event
     {
     public:
 
+        ////////////////////////////////////////////////////////////
+        /// Create an event with the given name.
+        ////////////////////////////////////////////////////////////
+        constexpr explicit Event(char const* name)
+            :
+            id_{ hash_event_name(name) },
+            payload_{ nullptr },
+            payload_type_{ nullptr }
+        {}
+
         ////////////////////////////////////////////////////////////
         /// Create an event with the given name.
         ////////////////////////////////////////////////////////////
         explicit Event(std::string const& name);
 
         ////////////////////////////////////////////////////////////
-        /// Compare the event names.
+        /// Create the event with the given id.
+        ////////////////////////////////////////////////////////////
+        static constexpr Event from_id(EventId id)
+        {
+            return Event(id, nullptr);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return the event id.
+        ////////////////////////////////////////////////////////////
+        constexpr EventId get_id() const
+        {
+            return id_;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the event carries a payload of type T.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        bool has_payload() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the payload. Throws an EventException if the
+        /// event does not carry a payload of type T.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        T const & get_payload() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Compare the event ids.
         ////////////////////////////////////////////////////////////
-        bool operator<(Event const& other) const;
+        constexpr bool operator<(Event const& other) const
+        {
+            return id_ < other.id_;
+        }
 
         ////////////////////////////////////////////////////////////
-        /// Compare the event names.
+        /// Compare the event ids.
         ////////////////////////////////////////////////////////////
-        bool operator==(Event const& other) const;
+        constexpr bool operator==(Event const& other) const
+        {
+            return id_ == other.id_;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Compare the event ids.
+        ////////////////////////////////////////////////////////////
+        constexpr bool operator!=(Event const& other) const
+        {
+            return id_ != other.id_;
+        }
 
     private:
 
+        // The event manager attaches the payloads.
+        friend class EventManager;
+
         ////////////////////////////////////////////////////////////
-        /// The event name.
+        /// Create the event with the given id. The second parameter
+        /// distinguishes this constructor from Event(char const*).
         ////////////////////////////////////////////////////////////
-        std::string name_;
+        constexpr Event(EventId id, std::nullptr_t)
+            :
+            id_{ id },
+            payload_{ nullptr },
+            payload_type_{ nullptr }
+        {}
 
-    };
+        ////////////////////////////////////////////////////////////
+        /// The hashed event name.
+        ////////////////////////////////////////////////////////////
+        EventId id_;
+
+        ////////////////////////////////////////////////////////////
+        /// The payload.
+        ////////////////////////////////////////////////////////////
+        void const* payload_;
+
+        ////////////////////////////////////////////////////////////
+        /// Identifies the payload type.
+        ////////////////////////////////////////////////////////////
+        void const* payload_type_;
+
+    }; // class Event
+
+    ////////////////////////////////////////////////////////////
+    /// A contiguous range of events of the same type.
+    ////////////////////////////////////////////////////////////
+    class SFE_API EventSpan
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create a span over the given events.
+        ////////////////////////////////////////////////////////////
+        EventSpan(Event const* events, std::size_t size)
+            :
+            events_(events),
+            size_(size)
+        {}
+
+        ////////////////////////////////////////////////////////////
+        /// Return a pointer to the first event.
+        ////////////////////////////////////////////////////////////
+        Event const* begin() const
+        {
+            return events_;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return a pointer behind the last event.
+        ////////////////////////////////////////////////////////////
+        Event const* end() const
+        {
+            return events_ + size_;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of events.
+        ////////////////////////////////////////////////////////////
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the span is empty.
+        ////////////////////////////////////////////////////////////
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Access the i-th event.
+        ////////////////////////////////////////////////////////////
+        Event const& operator[](std::size_t i) const
+        {
+            return events_[i];
+        }
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The first event.
+        ////////////////////////////////////////////////////////////
+        Event const* events_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of events.
+        ////////////////////////////////////////////////////////////
+        std::size_t size_;
+
+    }; // class EventSpan
 
     ////////////////////////////////////////////////////////////
     /// Event listener that can react to events.
@@ -52,21 +270,41 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         typedef std::function<void(Event const&)> Callback;
 
+        ////////////////////////////////////////////////////////////
+        /// The callback function type of batch listeners.
+        ////////////////////////////////////////////////////////////
+        typedef std::function<void(EventSpan const&)> BatchCallback;
+
         ////////////////////////////////////////////////////////////
         /// Create a listener that uses the given callback.
         ////////////////////////////////////////////////////////////
         Listener(Callback const& f);
 
+        ////////////////////////////////////////////////////////////
+        /// Create a batch listener that uses the given callback.
+        ////////////////////////////////////////////////////////////
+        Listener(BatchCallback const& f);
+
         ////////////////////////////////////////////////////////////
         /// Set the callback.
         ////////////////////////////////////////////////////////////
         void set_callback(Callback const& f);
 
+        ////////////////////////////////////////////////////////////
+        /// Set the batch callback.
+        ////////////////////////////////////////////////////////////
+        void set_callback(BatchCallback const& f);
+
         ////////////////////////////////////////////////////////////
         /// Fire the callback.
         ////////////////////////////////////////////////////////////
         void notify(Event const& event) const;
 
+        ////////////////////////////////////////////////////////////
+        /// Fire the batch callback.
+        ////////////////////////////////////////////////////////////
+        void notify(EventSpan const& events) const;
+
     private:
 
         ////////////////////////////////////////////////////////////
@@ -74,11 +312,133 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         Callback callback_;
 
+        ////////////////////////////////////////////////////////////
+        /// The batch notify callback.
+        ////////////////////////////////////////////////////////////
+        BatchCallback batch_callback_;
+
     }; // class Listener
 
+    namespace detail
+    {
+        class ListenerRegistry;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Owns the registration of a listener. The listener is
+    /// unregistered when the handle is reset or destroyed, which
+    /// must happen on the dispatching thread. The handle may
+    /// outlive the event manager.
+    ////////////////////////////////////////////////////////////
+    class SFE_API ListenerHandle
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create a handle that owns no listener.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle();
+
+        ////////////////////////////////////////////////////////////
+        /// Unregister the listener.
+        ////////////////////////////////////////////////////////////
+        ~ListenerHandle();
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy constructor.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle(ListenerHandle const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Enable move constructor.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle(ListenerHandle && other) noexcept;
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy assignment.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle & operator=(ListenerHandle const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Enable move assignment. The listener that was owned
+        /// before is unregistered.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle & operator=(ListenerHandle && other);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the listener is still registered.
+        ////////////////////////////////////////////////////////////
+        bool is_registered() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Unregister the listener.
+        ////////////////////////////////////////////////////////////
+        void reset();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the id of the listener (0 if the handle was
+        /// reset). The id is used in ListenerStats.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t get_id() const;
+
+    private:
+
+        friend class EventManager;
+
+        ////////////////////////////////////////////////////////////
+        /// Create a handle that owns the listener with the given
+        /// id.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle(std::weak_ptr<detail::ListenerRegistry> registry, std::uint64_t id);
+
+        ////////////////////////////////////////////////////////////
+        /// The registry of the event manager.
+        ////////////////////////////////////////////////////////////
+        std::weak_ptr<detail::ListenerRegistry> registry_;
+
+        ////////////////////////////////////////////////////////////
+        /// The slot index (lower 32 bits) and the generation (upper
+        /// 32 bits) of the listener in the registry.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t id_;
+
+    }; // class ListenerHandle
+
+    ////////////////////////////////////////////////////////////
+    /// Determines what happens if an event is enqueued while
+    /// another event of the same type waits for delivery.
+    ////////////////////////////////////////////////////////////
+    enum class CoalescePolicy
+    {
+        None,           // deliver every event
+        DropDuplicates, // keep the first event and drop the new one
+        KeepLast,       // replace the waiting event by the new one
+        Count           // deliver once with an EventCount payload
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// The payload of events with the Count coalesce policy.
+    ////////////////////////////////////////////////////////////
+    struct EventCount
+    {
+        std::size_t count;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Identifies a timer of the event manager. The id 0 never
+    /// refers to a timer.
+    ////////////////////////////////////////////////////////////
+    typedef std::uint64_t TimerId;
+
     ////////////////////////////////////////////////////////////
     /// The event manager can receive events and distribute them
     /// to registered listeners.
+    ///
+    /// Events are dispatched on the thread that calls
+    /// dispatch(). Other threads may enqueue events at any time.
+    /// Their events are collected in per-thread staging buffers
+    /// and delivered in the next call to dispatch(). All other
+    /// methods must only be called from the dispatching thread.
     ////////////////////////////////////////////////////////////
     class SFE_API EventManager
     {
@@ -115,18 +475,77 @@ namespace sfe
         EventManager & operator=(EventManager && other);
 
         ////////////////////////////////////////////////////////////
-        /// Register a new listener to the event and return it.
+        /// Register a new listener to the event. The listener stays
+        /// registered as long as the returned handle exists.
         ////////////////////////////////////////////////////////////
-        std::shared_ptr<Listener> register_listener(
+        ListenerHandle register_listener(
             Event const & event,
             Listener::Callback const& callback
         );
 
+        ////////////////////////////////////////////////////////////
+        /// Register a batch listener to the event and return its
+        /// handle.
+        /// Instead of being notified once per event, the batch
+        /// listener receives all events of the type that were
+        /// delivered in one round of dispatch(). It is notified
+        /// after the ordinary listeners of these events.
+        ////////////////////////////////////////////////////////////
+        ListenerHandle register_batch_listener(
+            Event const & event,
+            Listener::BatchCallback const& callback
+        );
+
+        ////////////////////////////////////////////////////////////
+        /// Set how multiple events of the given type that wait for
+        /// delivery are coalesced. A coalesced event is delivered
+        /// at the position of the first of these events.
+        ////////////////////////////////////////////////////////////
+        void set_coalesce_policy(Event const & event, CoalescePolicy policy);
+
         ////////////////////////////////////////////////////////////
         /// Add a new event to the queue.
         ////////////////////////////////////////////////////////////
         void enqueue(Event const& event);
 
+        ////////////////////////////////////////////////////////////
+        /// Add a new event with the given payload to the queue.
+        /// The payload is copied into an arena that is reset after
+        /// dispatch(), so it must be trivially destructible. The
+        /// listeners can read it with Event::get_payload<T>().
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        void enqueue(Event const& event, T const& payload);
+
+        ////////////////////////////////////////////////////////////
+        /// Enqueue the event once the given delay has passed. The
+        /// payload of the event is not kept.
+        ////////////////////////////////////////////////////////////
+        TimerId enqueue_after(Event const& event, sf::Time delay);
+
+        ////////////////////////////////////////////////////////////
+        /// Enqueue the event repeatedly with the given interval
+        /// until the timer is cancelled. The payload of the event
+        /// is not kept. If a frame takes longer than the interval,
+        /// e. g. after a stall, all missed events are enqueued in
+        /// the same frame. Use CoalescePolicy::DropDuplicates to
+        /// deliver at most one of them per dispatch.
+        ////////////////////////////////////////////////////////////
+        TimerId enqueue_every(Event const& event, sf::Time interval);
+
+        ////////////////////////////////////////////////////////////
+        /// Cancel the timer. Returns false if the timer already
+        /// fired or was cancelled.
+        ////////////////////////////////////////////////////////////
+        bool cancel_timer(TimerId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Advance the timers and enqueue the events of the timers
+        /// that fired. The timers have a resolution of one
+        /// millisecond.
+        ////////////////////////////////////////////////////////////
+        void advance_timers(sf::Time elapsed_time);
+
         ////////////////////////////////////////////////////////////
         /// Broadcast all events to the listeners.
         ////////////////////////////////////////////////////////////
@@ -137,8 +556,71 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         void register_event(Event const & event);
 
+        ////////////////////////////////////////////////////////////
+        /// Register the event with the given name. The name is
+        /// stored for debugging purposes and hash collisions
+        /// between different names are reported.
+        ////////////////////////////////////////////////////////////
+        void register_event(std::string const & name);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the name of the given event. If the event was
+        /// not registered by name, the hexadecimal id is returned.
+        ////////////////////////////////////////////////////////////
+        std::string get_event_name(Event const & event) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Enable or disable the instrumentation. While enabled,
+        /// the event manager records the number of enqueued and
+        /// delivered events per type, the peak queue depth and the
+        /// callback times of the listeners. The instrumentation is
+        /// only compiled in if SFE_EVENT_STATS is defined, so this
+        /// has no effect otherwise.
+        ////////////////////////////////////////////////////////////
+        void set_stats_enabled(bool enabled);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the instrumentation is enabled.
+        ////////////////////////////////////////////////////////////
+        bool get_stats_enabled() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the numbers recorded since the last call to
+        /// reset_stats().
+        ////////////////////////////////////////////////////////////
+        EventManagerStats get_stats() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Reset the recorded numbers.
+        ////////////////////////////////////////////////////////////
+        void reset_stats();
+
     private:
 
+        ////////////////////////////////////////////////////////////
+        /// Function that copy constructs a payload at the given
+        /// address.
+        ////////////////////////////////////////////////////////////
+        typedef void(*PayloadConstructor)(void*, void const*);
+
+        ////////////////////////////////////////////////////////////
+        /// Copy the payload into memory that is valid until the end
+        /// of the next dispatch() and enqueue the event.
+        ////////////////////////////////////////////////////////////
+        void enqueue_payload(
+            Event const& event,
+            std::size_t size,
+            std::size_t alignment,
+            void const* payload,
+            void const* payload_type,
+            PayloadConstructor construct
+        );
+
+        ////////////////////////////////////////////////////////////
+        /// Attach the payload to the event.
+        ////////////////////////////////////////////////////////////
+        static void attach_payload(Event & event, void const* payload, void const* payload_type);
+
         class impl;
         sfe::propagate_const<std::unique_ptr<impl>> impl_;
 
@@ -149,6 +631,46 @@ namespace sfe
     ////////////////////////////////////////////////////////////
     DECLARE_EXCEPTION(EventException);
 
+    template <typename T>
+    bool Event::has_payload() const
+    {
+        return payload_type_ == &detail::PayloadType<T>::id;
+    }
+
+    template <typename T>
+    T const & Event::get_payload() const
+    {
+        if (!has_payload<T>())
+            throw EventException("Event::get_payload(): The event does not carry a payload of the requested type.");
+        return *static_cast<T const*>(payload_);
+    }
+
+    template <typename T>
+    void EventManager::enqueue(Event const& event, T const& payload)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "EventManager::enqueue(): The payload must be trivially destructible.");
+        enqueue_payload(event, sizeof(T), alignof(T), &payload, &detail::PayloadType<T>::id, [](void* dst, void const* src)
+        {
+            new (dst) T(*static_cast<T const*>(src));
+        });
+    }
+
 } // namespace sfe
 
+namespace std
+{
+    ////////////////////////////////////////////////////////////
+    /// The event id already is a hash, so it can be used as is.
+    ////////////////////////////////////////////////////////////
+    template <>
+    struct hash<sfe::Event>
+    {
+        size_t operator()(sfe::Event const& event) const
+        {
+            return static_cast<size_t>(event.get_id());
+        }
+    };
+
+} // namespace std
+
 #endif
@@ -0,0 +1,65 @@
+#ifndef SFE_EVENT_STATS_HXX
+#define SFE_EVENT_STATS_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// The recorded numbers of one event type.
+    ////////////////////////////////////////////////////////////
+    struct EventTypeStats
+    {
+        std::uint64_t event_id;
+        std::string name;
+        std::uint64_t enqueued;  // including the coalesced events
+        std::uint64_t delivered;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// The recorded callback times of one listener.
+    ////////////////////////////////////////////////////////////
+    struct ListenerStats
+    {
+        std::uint64_t event_id;
+        std::string event_name;
+        std::uint64_t listener_id; // see ListenerHandle::get_id()
+        bool batch;
+        std::uint64_t calls;
+        std::int64_t total_ns;
+        std::int64_t max_ns;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// A snapshot of the instrumentation of an event manager.
+    ////////////////////////////////////////////////////////////
+    struct SFE_API EventManagerStats
+    {
+        ////////////////////////////////////////////////////////////
+        /// Write one line per event type and per listener with the
+        /// columns kind, event_id, event_name, listener, enqueued,
+        /// delivered, calls, total_ns and max_ns. Columns that do
+        /// not apply to the kind are left empty.
+        ////////////////////////////////////////////////////////////
+        void write_csv(std::ostream & out) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Write the snapshot as a JSON object.
+        ////////////////////////////////////////////////////////////
+        void write_json(std::ostream & out) const;
+
+        std::uint64_t dispatches;
+        std::size_t peak_queue_depth;
+        std::vector<EventTypeStats> events;
+        std::vector<ListenerStats> listeners;
+    };
+
+} // namespace sfe
+
+#endif
@@ -7,10 +7,12 @@
 #include <SFML/Config.hpp>
 #include <SFML/Window/WindowStyle.hpp>
 
+#include <cstddef>
 #include <memory>
 
 namespace sf
 {
+    class RenderTexture;
     class RenderWindow;
     class Time;
 }
@@ -21,6 +23,16 @@ namespace sfe
     class ResourceManager;
     class Screen;
 
+    ////////////////////////////////////////////////////////////
+    /// Where a game renders to.
+    ////////////////////////////////////////////////////////////
+    enum class GameBackend
+    {
+        Window,     // a window with user input
+        Offscreen,  // a texture, without window and input
+        Null        // nothing, the game is only simulated
+    };
+
     ////////////////////////////////////////////////////////////
     /// Base class for all game applications.
     ////////////////////////////////////////////////////////////
@@ -38,26 +50,132 @@ namespace sfe
             sf::Uint32 const style = sf::Style::Default
         );
 
+        ////////////////////////////////////////////////////////////
+        /// Initialize a game with the given backend and viewport
+        /// size. The window of the Window backend has no title.
+        /// Headless backends advance every frame by 1/60 second
+        /// instead of the measured time, see set_frame_time().
+        ////////////////////////////////////////////////////////////
+        Game(
+            unsigned int const width,
+            unsigned int const height,
+            GameBackend const backend
+        );
+
         ////////////////////////////////////////////////////////////
         /// Default destructor.
         ////////////////////////////////////////////////////////////
         ~Game();
 
         ////////////////////////////////////////////////////////////
-        /// Run the game loop.
+        /// Run the game loop until the window is closed, quit() is
+        /// called or the maximum number of frames is reached.
         ////////////////////////////////////////////////////////////
         void run();
 
         ////////////////////////////////////////////////////////////
-        /// Return the render window.
+        /// Let run() return after the current frame.
+        ////////////////////////////////////////////////////////////
+        void quit();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the backend.
+        ////////////////////////////////////////////////////////////
+        GameBackend get_backend() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the synthetic frame time or zero if the frames
+        /// advance by the measured time.
+        ////////////////////////////////////////////////////////////
+        sf::Time get_frame_time() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the synthetic frame time. If it is not zero, every
+        /// frame advances the game by this time instead of the
+        /// measured time, so a simulation runs as fast as the CPU
+        /// allows and is reproducible.
+        ////////////////////////////////////////////////////////////
+        void set_frame_time(sf::Time const& frame_time);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the maximum number of frames of run() or 0.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_max_frames() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the maximum number of frames of run(). 0 (the
+        /// default) runs until the game quits.
+        ////////////////////////////////////////////////////////////
+        void set_max_frames(std::size_t max_frames);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of frames since run() was called.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_frame_count() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of fixed simulation ticks per second
+        /// or 0 if the simulation advances by the frame time.
+        ////////////////////////////////////////////////////////////
+        unsigned int get_tick_rate() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the number of fixed simulation ticks per second. The
+        /// screen and update_impl() are then updated with the fixed
+        /// time step as often as the elapsed time requires, and the
+        /// game objects are rendered between their transforms of
+        /// the last two ticks. 0 (the default) updates once per
+        /// frame with the frame time.
+        ////////////////////////////////////////////////////////////
+        void set_tick_rate(unsigned int tick_rate);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the maximum number of ticks per frame.
+        ////////////////////////////////////////////////////////////
+        unsigned int get_max_ticks() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the maximum number of ticks per frame. If a frame
+        /// takes longer than that many ticks, the remaining time is
+        /// dropped and the simulation slows down, instead of
+        /// taking ever more ticks per frame to catch up.
+        ////////////////////////////////////////////////////////////
+        void set_max_ticks(unsigned int max_ticks);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the game renders on a separate thread.
+        ////////////////////////////////////////////////////////////
+        bool get_render_thread() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set whether the game renders on a separate thread. The
+        /// screen is then recorded into render commands after the
+        /// update, and a render thread draws them while the next
+        /// frame is updated. The window must not be drawn to from
+        /// the update, and textures must live one frame longer
+        /// than the objects that use them. Takes effect when run()
+        /// is called.
+        ////////////////////////////////////////////////////////////
+        void set_render_thread(bool b);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the render window. Throws a GameException if the
+        /// game has no window.
         ////////////////////////////////////////////////////////////
         sf::RenderWindow & get_window();
 
         ////////////////////////////////////////////////////////////
-        /// Return the render window.
+        /// Return the render window. Throws a GameException if the
+        /// game has no window.
         ////////////////////////////////////////////////////////////
         sf::RenderWindow const & get_window() const;
 
+        ////////////////////////////////////////////////////////////
+        /// Return the texture of the Offscreen backend. Throws a
+        /// GameException for the other backends.
+        ////////////////////////////////////////////////////////////
+        sf::RenderTexture & get_render_texture();
+
         ////////////////////////////////////////////////////////////
         /// Load the given screen.
         ////////////////////////////////////////////////////////////
@@ -90,7 +208,7 @@ namespace sfe
 
         ////////////////////////////////////////////////////////////
         /// The concrete update of the derived class, which is
-        /// called once per frame.
+        /// called once per frame or once per tick.
         ////////////////////////////////////////////////////////////
         virtual void update_impl(sf::Time const& elapsed_time) = 0;
 
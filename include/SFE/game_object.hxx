@@ -2,13 +2,73 @@
 #define SFE_GAME_OBJECT_HXX
 
 #include <SFE/sfestd.hxx>
+#include <SFE/sprite_batch.hxx>
+#include <SFE/texture_atlas.hxx>
 
 #include <SFML/Graphics.hpp>
 
+#include <cstdint>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <new>
+#include <vector>
 
 namespace sfe
 {
+    class Screen;
+
+    ////////////////////////////////////////////////////////////
+    /// Refers to a game object of a screen. The handle contains
+    /// the slot (lower 32 bits) and the generation (upper 32 bits)
+    /// of the object, so the screen detects handles of removed
+    /// objects. The default handle refers to no object.
+    ////////////////////////////////////////////////////////////
+    class SFE_API GameObjectHandle
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create a handle that refers to no object.
+        ////////////////////////////////////////////////////////////
+        GameObjectHandle();
+
+        ////////////////////////////////////////////////////////////
+        /// Create a handle with the given id.
+        ////////////////////////////////////////////////////////////
+        explicit GameObjectHandle(std::uint64_t id);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the id of the handle (0 if it refers to no
+        /// object).
+        ////////////////////////////////////////////////////////////
+        std::uint64_t get_id() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the handle was returned by a screen. It
+        /// may still refer to an object that was removed.
+        ////////////////////////////////////////////////////////////
+        explicit operator bool() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Compare the handles.
+        ////////////////////////////////////////////////////////////
+        bool operator==(GameObjectHandle const & other) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Compare the handles.
+        ////////////////////////////////////////////////////////////
+        bool operator!=(GameObjectHandle const & other) const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The id.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t id_;
+
+    }; // class GameObjectHandle
+
     ////////////////////////////////////////////////////////////
     /// The base class for all game objects.
     ////////////////////////////////////////////////////////////
@@ -16,17 +76,67 @@ namespace sfe
     {
     public:
 
+        ////////////////////////////////////////////////////////////
+        /// The callback function type.
+        ////////////////////////////////////////////////////////////
+        typedef std::function<void(GameObject &)> CallbackFunction;
+
         ////////////////////////////////////////////////////////////
         /// The default constructor creates the game object at
         /// (0, 0) with size (1, 1).
         ////////////////////////////////////////////////////////////
         GameObject();
 
+        ////////////////////////////////////////////////////////////
+        /// Copy the properties of the game object. The copy does
+        /// not belong to a screen and has no callbacks.
+        ////////////////////////////////////////////////////////////
+        GameObject(GameObject const& other);
+
+        ////////////////////////////////////////////////////////////
+        /// Copy the properties of the game object, but keep the
+        /// screen and the callbacks of this object.
+        ////////////////////////////////////////////////////////////
+        GameObject & operator=(GameObject const& other);
+
         ////////////////////////////////////////////////////////////
         /// Virtual default destructor.
         ////////////////////////////////////////////////////////////
         virtual ~GameObject() = default;
 
+        ////////////////////////////////////////////////////////////
+        /// Allocate the object from the global object pool, so
+        /// creating and destroying game objects reuses memory.
+        ////////////////////////////////////////////////////////////
+        static void* operator new(std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the memory of the object to the global object
+        /// pool.
+        ////////////////////////////////////////////////////////////
+        static void operator delete(void* p, std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Placement new, which the class-scope operator new would
+        /// hide otherwise.
+        ////////////////////////////////////////////////////////////
+        static void* operator new(std::size_t, void* p) noexcept
+        {
+            return p;
+        }
+
+        static void operator delete(void*, void*) noexcept
+        {}
+
+#ifdef __cpp_aligned_new
+        ////////////////////////////////////////////////////////////
+        /// The pool only aligns like operator new, so over-aligned
+        /// subclasses are allocated with the global aligned forms.
+        ////////////////////////////////////////////////////////////
+        static void* operator new(std::size_t size, std::align_val_t alignment);
+        static void operator delete(void* p, std::size_t size, std::align_val_t alignment);
+#endif
+
         ////////////////////////////////////////////////////////////
         /// Update the game object.
         ////////////////////////////////////////////////////////////
@@ -37,6 +147,11 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         void render(sf::RenderTarget & target) const;
 
+        ////////////////////////////////////////////////////////////
+        /// Render the game object into the sprite batch.
+        ////////////////////////////////////////////////////////////
+        void render(SpriteBatch & batch) const;
+
         ////////////////////////////////////////////////////////////
         /// Return the position.
         ////////////////////////////////////////////////////////////
@@ -82,13 +197,29 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         void rotate(float angle);
 
+        ////////////////////////////////////////////////////////////
+        /// Return the position at which the object is rendered. If
+        /// the screen interpolates between two ticks, it lies
+        /// between the position of the previous tick and the
+        /// current position.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f get_render_position() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the rotation with which the object is rendered.
+        /// It is interpolated like the position.
+        ////////////////////////////////////////////////////////////
+        float get_render_rotation() const;
+
         ////////////////////////////////////////////////////////////
         /// Return the z-index.
         ////////////////////////////////////////////////////////////
         int get_z_index() const;
 
         ////////////////////////////////////////////////////////////
-        /// Set the z-index.
+        /// Set the z-index. If the object belongs to a screen, the
+        /// screen moves it to its new place in the draw order on
+        /// the next update.
         ////////////////////////////////////////////////////////////
         void set_z_index(int z_index);
 
@@ -102,13 +233,103 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         void set_visible(bool b);
 
+        ////////////////////////////////////////////////////////////
+        /// Return whether update() may run in parallel with the
+        /// updates of other game objects.
+        ////////////////////////////////////////////////////////////
+        bool get_parallel_update() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set whether update() may run in parallel with the
+        /// updates of other game objects. The screen updates these
+        /// objects on the job system after the other objects. Their
+        /// update() may change the object itself, but must not
+        /// touch other game objects, the screen or the gui, e. g.
+        /// it must not add or remove game objects.
+        ////////////////////////////////////////////////////////////
+        void set_parallel_update(bool b);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the axis-aligned bounding box of the rotated
+        /// object. The position is the center of the object.
+        ////////////////////////////////////////////////////////////
+        sf::FloatRect get_bounds() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the rotated object contains the point.
+        ////////////////////////////////////////////////////////////
+        bool contains(sf::Vector2f const & point) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the mouse is over the object.
+        ////////////////////////////////////////////////////////////
+        bool get_mouseover() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the handle of the object on its screen. If the
+        /// object does not belong to a screen, the handle refers to
+        /// no object.
+        ////////////////////////////////////////////////////////////
+        GameObjectHandle get_handle() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Add a callback for the mouse enter event.
+        ////////////////////////////////////////////////////////////
+        void add_mouse_enter_callback(CallbackFunction && f);
+
+        ////////////////////////////////////////////////////////////
+        /// Add a callback for the mouse leave event.
+        ////////////////////////////////////////////////////////////
+        void add_mouse_leave_callback(CallbackFunction && f);
+
+        ////////////////////////////////////////////////////////////
+        /// Add a callback for the click begin event. Only the top
+        /// most object under the mouse receives the click.
+        ////////////////////////////////////////////////////////////
+        void add_click_begin_callback(CallbackFunction && f);
+
+        ////////////////////////////////////////////////////////////
+        /// Add a callback for the click end event.
+        ////////////////////////////////////////////////////////////
+        void add_click_end_callback(CallbackFunction && f);
+
+        ////////////////////////////////////////////////////////////
+        /// Clear the callbacks for the mouse enter event.
+        ////////////////////////////////////////////////////////////
+        void clear_mouse_enter_callbacks();
+
+        ////////////////////////////////////////////////////////////
+        /// Clear the callbacks for the mouse leave event.
+        ////////////////////////////////////////////////////////////
+        void clear_mouse_leave_callbacks();
+
+        ////////////////////////////////////////////////////////////
+        /// Clear the callbacks for the click begin event.
+        ////////////////////////////////////////////////////////////
+        void clear_click_begin_callbacks();
+
+        ////////////////////////////////////////////////////////////
+        /// Clear the callbacks for the click end event.
+        ////////////////////////////////////////////////////////////
+        void clear_click_end_callbacks();
+
     protected:
 
         ////////////////////////////////////////////////////////////
         /// The concrete render method.
         ////////////////////////////////////////////////////////////
         virtual void render_impl(sf::RenderTarget & target) const = 0;
-        
+
+        ////////////////////////////////////////////////////////////
+        /// The concrete render method for sprite batches. The
+        /// default implementation flushes the batch and calls
+        /// render_impl() with the target of the batch. If the batch
+        /// records render commands, it throws a GameException, so
+        /// objects that should be drawn by a render thread must
+        /// override this method.
+        ////////////////////////////////////////////////////////////
+        virtual void render_batch_impl(SpriteBatch & batch) const;
+
     private:
 
         ////////////////////////////////////////////////////////////
@@ -126,6 +347,20 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         float rotation_;
 
+        ////////////////////////////////////////////////////////////
+        /// Position and rotation at the previous tick, for the
+        /// interpolation when rendering.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f previous_position_;
+        float previous_rotation_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the transforms of the previous tick are stored.
+        /// Objects that were added in the current tick are rendered
+        /// at their current transforms.
+        ////////////////////////////////////////////////////////////
+        bool previous_stored_;
+
         ////////////////////////////////////////////////////////////
         /// The z-index.
         ////////////////////////////////////////////////////////////
@@ -136,6 +371,71 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         bool visible_;
 
+        ////////////////////////////////////////////////////////////
+        /// Whether the object may be updated in parallel.
+        ////////////////////////////////////////////////////////////
+        bool parallel_update_;
+
+        ////////////////////////////////////////////////////////////
+        /// Notify the screen that the bounds changed.
+        ////////////////////////////////////////////////////////////
+        void bounds_changed();
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the z-index changed since the screen ordered
+        /// the object.
+        ////////////////////////////////////////////////////////////
+        bool z_index_changed_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the bounds changed since the screen indexed the
+        /// object.
+        ////////////////////////////////////////////////////////////
+        bool bounds_changed_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the mouse is over the object.
+        ////////////////////////////////////////////////////////////
+        bool mouseover_;
+
+        ////////////////////////////////////////////////////////////
+        /// Equals the render stamp of the screen if the object is
+        /// inside the view.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t cull_stamp_;
+
+        ////////////////////////////////////////////////////////////
+        /// The screen that owns the object or nullptr.
+        ////////////////////////////////////////////////////////////
+        Screen * screen_;
+
+        ////////////////////////////////////////////////////////////
+        /// The handle of the object on its screen.
+        ////////////////////////////////////////////////////////////
+        GameObjectHandle handle_;
+
+        ////////////////////////////////////////////////////////////
+        /// The callbacks for the mouse enter event.
+        ////////////////////////////////////////////////////////////
+        std::vector<CallbackFunction> mouse_enter_callbacks_;
+
+        ////////////////////////////////////////////////////////////
+        /// The callbacks for the mouse leave event.
+        ////////////////////////////////////////////////////////////
+        std::vector<CallbackFunction> mouse_leave_callbacks_;
+
+        ////////////////////////////////////////////////////////////
+        /// The callbacks for the click begin event.
+        ////////////////////////////////////////////////////////////
+        std::vector<CallbackFunction> click_begin_callbacks_;
+
+        ////////////////////////////////////////////////////////////
+        /// The callbacks for the click end event.
+        ////////////////////////////////////////////////////////////
+        std::vector<CallbackFunction> click_end_callbacks_;
+
+        friend class Screen;
+
     }; // class GameObject
 
     ////////////////////////////////////////////////////////////
@@ -150,6 +450,11 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         ImageObject(std::shared_ptr<sf::Texture> const& texture);
 
+        ////////////////////////////////////////////////////////////
+        /// Create an image object from the given texture region.
+        ////////////////////////////////////////////////////////////
+        ImageObject(TextureRegion const& region);
+
         ////////////////////////////////////////////////////////////
         /// Return the mirror-x property.
         ////////////////////////////////////////////////////////////
@@ -175,6 +480,11 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         void set_texture(std::shared_ptr<sf::Texture> const& texture);
 
+        ////////////////////////////////////////////////////////////
+        /// Set the texture region.
+        ////////////////////////////////////////////////////////////
+        void set_texture(TextureRegion const& region);
+
     private:
 
         ////////////////////////////////////////////////////////////
@@ -183,9 +493,14 @@ namespace sfe
         virtual void render_impl(sf::RenderTarget & target) const override;
 
         ////////////////////////////////////////////////////////////
-        /// The texture.
+        /// Add the image to the sprite batch.
+        ////////////////////////////////////////////////////////////
+        virtual void render_batch_impl(SpriteBatch & batch) const override;
+
+        ////////////////////////////////////////////////////////////
+        /// The texture region.
         ////////////////////////////////////////////////////////////
-        std::shared_ptr<sf::Texture> texture_;
+        TextureRegion region_;
 
         ////////////////////////////////////////////////////////////
         /// Mirror the image in x-direction.
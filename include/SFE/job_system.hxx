@@ -0,0 +1,267 @@
+#ifndef SFE_JOB_SYSTEM_HXX
+#define SFE_JOB_SYSTEM_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sfe
+{
+    class JobSystem;
+
+    ////////////////////////////////////////////////////////////
+    /// A group of jobs that is waited for together. The group
+    /// must outlive its jobs, so JobSystem::wait() must be called
+    /// before it is destroyed.
+    ////////////////////////////////////////////////////////////
+    class SFE_API JobGroup
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an empty group.
+        ////////////////////////////////////////////////////////////
+        JobGroup();
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy constructor.
+        ////////////////////////////////////////////////////////////
+        JobGroup(JobGroup const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy assignment.
+        ////////////////////////////////////////////////////////////
+        JobGroup & operator=(JobGroup const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether all jobs of the group are finished.
+        ////////////////////////////////////////////////////////////
+        bool is_done() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// Remember the exception of a failed job. Only the first
+        /// exception is kept.
+        ////////////////////////////////////////////////////////////
+        void fail(std::exception_ptr e);
+
+        ////////////////////////////////////////////////////////////
+        /// The number of jobs that are not finished.
+        ////////////////////////////////////////////////////////////
+        std::atomic<std::size_t> pending_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether a job threw an exception.
+        ////////////////////////////////////////////////////////////
+        std::atomic<bool> failed_;
+
+        ////////////////////////////////////////////////////////////
+        /// The exception of the first failed job.
+        ////////////////////////////////////////////////////////////
+        std::exception_ptr exception_;
+
+        friend class JobSystem;
+
+    }; // class JobGroup
+
+    ////////////////////////////////////////////////////////////
+    /// The job system runs jobs on a pool of worker threads.
+    /// Each thread has its own queue. A thread takes the newest
+    /// job of its own queue and steals the oldest job of another
+    /// queue when its own queue is empty, so recursively split
+    /// work spreads over the threads in large pieces.
+    ///
+    /// A thread that waits for a group runs jobs itself instead
+    /// of blocking. Threads that are not workers share one queue,
+    /// so parallel_for() may be called from any thread, e. g.
+    /// by the resource loading or the layout of the gui.
+    ////////////////////////////////////////////////////////////
+    class SFE_API JobSystem
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Start the worker threads. The thread count includes the
+        /// thread that waits for the jobs, so thread_count - 1
+        /// workers are started. 0 uses one thread per core.
+        ////////////////////////////////////////////////////////////
+        explicit JobSystem(std::size_t thread_count = 0);
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy constructor.
+        ////////////////////////////////////////////////////////////
+        JobSystem(JobSystem const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy assignment.
+        ////////////////////////////////////////////////////////////
+        JobSystem & operator=(JobSystem const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Stop the worker threads. All groups must be waited for.
+        ////////////////////////////////////////////////////////////
+        ~JobSystem();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the job system that is used by the engine. It is
+        /// never destroyed, so its workers keep running until the
+        /// process exits.
+        ////////////////////////////////////////////////////////////
+        static JobSystem & global();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of threads, including the waiting
+        /// thread.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_thread_count() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the index of the calling thread. Workers have the
+        /// indices 1 to get_thread_count() - 1, all other threads
+        /// have the index 0. Several threads may run jobs with the
+        /// index 0 at the same time, so it does not identify a
+        /// thread.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_thread_index() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Add the job to the group.
+        ////////////////////////////////////////////////////////////
+        void run(JobGroup & group, std::function<void()> job);
+
+        ////////////////////////////////////////////////////////////
+        /// Run jobs until all jobs of the group are finished. If a
+        /// job threw an exception, it is rethrown.
+        ////////////////////////////////////////////////////////////
+        void wait(JobGroup & group);
+
+        ////////////////////////////////////////////////////////////
+        /// Call f(i) for all i in [begin, end) and wait for the
+        /// calls. The range is split in halves until the pieces
+        /// have at most grain indices, so idle threads can steal
+        /// them. f must be safe to call from several threads.
+        ////////////////////////////////////////////////////////////
+        template <typename F>
+        void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F const & f);
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// A job calls fn(context, begin, end). Jobs with more than
+        /// grain indices are split before they are called.
+        ////////////////////////////////////////////////////////////
+        struct Job
+        {
+            void (*fn)(void const * context, std::size_t begin, std::size_t end);
+            void const * context;
+            std::size_t begin;
+            std::size_t end;
+            std::size_t grain;
+            JobGroup * group;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The queue of a thread, a ring buffer that grows when it
+        /// is full.
+        ////////////////////////////////////////////////////////////
+        struct Queue
+        {
+            std::mutex mutex;
+            std::vector<Job> jobs;
+            std::size_t head;
+            std::size_t size;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Add the job to the queue of the calling thread.
+        ////////////////////////////////////////////////////////////
+        void push(Job const & job);
+
+        ////////////////////////////////////////////////////////////
+        /// Take a job from the queue of the thread or steal one
+        /// from another queue. Return false if all queues are
+        /// empty.
+        ////////////////////////////////////////////////////////////
+        bool pop(std::size_t thread_index, Job & job);
+
+        ////////////////////////////////////////////////////////////
+        /// Split the job until it is small enough, call it and
+        /// finish it in its group.
+        ////////////////////////////////////////////////////////////
+        void execute(Job job);
+
+        ////////////////////////////////////////////////////////////
+        /// Split the range into jobs and wait for them.
+        ////////////////////////////////////////////////////////////
+        void parallel_for_impl(
+            std::size_t begin,
+            std::size_t end,
+            std::size_t grain,
+            void (*fn)(void const * context, std::size_t begin, std::size_t end),
+            void const * context
+        );
+
+        ////////////////////////////////////////////////////////////
+        /// The loop of the worker with the given index.
+        ////////////////////////////////////////////////////////////
+        void work(std::size_t thread_index);
+
+        ////////////////////////////////////////////////////////////
+        /// The queues, one for each thread.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::unique_ptr<Queue> > queues_;
+
+        ////////////////////////////////////////////////////////////
+        /// The worker threads.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::thread> workers_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of jobs in all queues.
+        ////////////////////////////////////////////////////////////
+        std::atomic<std::size_t> queued_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of workers that wait for jobs.
+        ////////////////////////////////////////////////////////////
+        std::atomic<std::size_t> sleeping_;
+
+        ////////////////////////////////////////////////////////////
+        /// Idle workers sleep on wake_.
+        ////////////////////////////////////////////////////////////
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the workers should stop.
+        ////////////////////////////////////////////////////////////
+        bool stop_;
+
+    }; // class JobSystem
+
+    template <typename F>
+    void JobSystem::parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F const & f)
+    {
+        parallel_for_impl(begin, end, grain,
+            [](void const * context, std::size_t b, std::size_t e)
+            {
+                auto const & f = *static_cast<F const *>(context);
+                for (auto i = b; i < e; ++i)
+                    f(i);
+            },
+            &f
+        );
+    }
+
+} // namespace sfe
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef SFE_OBJECT_POOL_HXX
+#define SFE_OBJECT_POOL_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// The object pool hands out small memory blocks. Blocks of
+    /// the same size class are kept in a free list, so freed
+    /// blocks are reused by the next object of a similar size
+    /// instead of going back to the heap. Memory is taken from
+    /// the heap in large chunks and only released when the pool
+    /// is destroyed. Larger blocks are passed to the heap.
+    ///
+    /// GameObject and Widget allocate from the global pool, so
+    /// spawning and despawning objects stops allocating once the
+    /// pool has grown to the peak number of objects.
+    ////////////////////////////////////////////////////////////
+    class SFE_API ObjectPool
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create a pool that takes chunks of the given size from
+        /// the heap.
+        ////////////////////////////////////////////////////////////
+        explicit ObjectPool(std::size_t chunk_size = 64 * 1024);
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy constructor.
+        ////////////////////////////////////////////////////////////
+        ObjectPool(ObjectPool const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Disable copy assignment.
+        ////////////////////////////////////////////////////////////
+        ObjectPool & operator=(ObjectPool const& other) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the pool that is used by the game objects and
+        /// the widgets. It is never destroyed, so objects may be
+        /// freed during static destruction.
+        ////////////////////////////////////////////////////////////
+        static ObjectPool & global();
+
+        ////////////////////////////////////////////////////////////
+        /// Return a block of the given size. The block is aligned
+        /// like memory from operator new.
+        ////////////////////////////////////////////////////////////
+        void* allocate(std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the block to the pool. The size must be the size
+        /// the block was allocated with.
+        ////////////////////////////////////////////////////////////
+        void deallocate(void* p, std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Make sure that count blocks of the given size can be
+        /// allocated without taking memory from the heap.
+        ////////////////////////////////////////////////////////////
+        void reserve(std::size_t size, std::size_t count);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the total size of the chunks.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_capacity() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// A block in a free list.
+        ////////////////////////////////////////////////////////////
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The block sizes are multiples of granularity.
+        ////////////////////////////////////////////////////////////
+        static std::size_t const granularity = 16;
+
+        ////////////////////////////////////////////////////////////
+        /// Larger blocks are taken from the heap.
+        ////////////////////////////////////////////////////////////
+        static std::size_t const max_block_size = 512;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the size class of the block size.
+        ////////////////////////////////////////////////////////////
+        static std::size_t size_class(std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Take a new chunk from the heap and put at least count
+        /// blocks of the size class into the free list.
+        ////////////////////////////////////////////////////////////
+        void grow(std::size_t size_class, std::size_t count);
+
+        ////////////////////////////////////////////////////////////
+        /// The chunk size.
+        ////////////////////////////////////////////////////////////
+        std::size_t chunk_size_;
+
+        ////////////////////////////////////////////////////////////
+        /// The free lists of the size classes.
+        ////////////////////////////////////////////////////////////
+        std::array<FreeBlock*, max_block_size / granularity> free_;
+
+        ////////////////////////////////////////////////////////////
+        /// The free blocks of each size class.
+        ////////////////////////////////////////////////////////////
+        std::array<std::size_t, max_block_size / granularity> free_count_;
+
+        ////////////////////////////////////////////////////////////
+        /// The chunks and their sizes.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::pair<std::unique_ptr<char[]>, std::size_t> > chunks_;
+
+        ////////////////////////////////////////////////////////////
+        /// Objects may be created and destroyed on other threads,
+        /// e. g. while loading a screen.
+        ////////////////////////////////////////////////////////////
+        mutable std::mutex mutex_;
+
+    }; // class ObjectPool
+
+} // namespace sfe
+
+#endif
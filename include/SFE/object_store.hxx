@@ -0,0 +1,568 @@
+#ifndef SFE_OBJECT_STORE_HXX
+#define SFE_OBJECT_STORE_HXX
+
+#include <SFE/sfestd.hxx>
+#include <SFE/sprite_batch.hxx>
+#include <SFE/texture_atlas.hxx>
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// Identifies an object of an object store. The id 0 never
+    /// refers to an object.
+    ////////////////////////////////////////////////////////////
+    typedef std::uint64_t ObjectId;
+
+    namespace detail
+    {
+        ////////////////////////////////////////////////////////////
+        /// The type-independent interface of the component pools.
+        ////////////////////////////////////////////////////////////
+        class ComponentPoolBase
+        {
+        public:
+
+            virtual ~ComponentPoolBase() = default;
+
+            ////////////////////////////////////////////////////////////
+            /// Remove the component of the object in the given slot.
+            ////////////////////////////////////////////////////////////
+            virtual void remove_slot(std::uint32_t slot) = 0;
+
+            ////////////////////////////////////////////////////////////
+            /// Remove all components.
+            ////////////////////////////////////////////////////////////
+            virtual void clear() = 0;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The address of id is unique for each component type.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        struct ComponentType
+        {
+            static char const id;
+        };
+
+        template <typename T>
+        char const ComponentType<T>::id = 0;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the slot index of the object id.
+        ////////////////////////////////////////////////////////////
+        inline std::uint32_t object_slot(ObjectId id)
+        {
+            return static_cast<std::uint32_t>(id & 0xffffffffu);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Stores one component of type T for some of the objects of
+    /// an object store. The components are packed into one
+    /// array, so iterating over them is linear in memory. Adding
+    /// and removing is O(1), removing moves the last component
+    /// into the gap.
+    ////////////////////////////////////////////////////////////
+    template <typename T>
+    class ComponentPool : public detail::ComponentPoolBase
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Add the component to the object or replace its
+        /// component.
+        ////////////////////////////////////////////////////////////
+        T & add(ObjectId id, T value);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the component of the object or nullptr if it has
+        /// none.
+        ////////////////////////////////////////////////////////////
+        T * get(ObjectId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the component of the object or nullptr if it has
+        /// none.
+        ////////////////////////////////////////////////////////////
+        T const * get(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Remove the component of the object.
+        ////////////////////////////////////////////////////////////
+        void remove(ObjectId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of components.
+        ////////////////////////////////////////////////////////////
+        std::size_t size() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Call f(id, component) for each component.
+        ////////////////////////////////////////////////////////////
+        template <typename F>
+        void for_each(F f);
+
+        virtual void remove_slot(std::uint32_t slot) override;
+
+        virtual void clear() override;
+
+    private:
+
+        static std::uint32_t const npos = 0xffffffffu;
+
+        ////////////////////////////////////////////////////////////
+        /// The packed components.
+        ////////////////////////////////////////////////////////////
+        std::vector<T> components_;
+
+        ////////////////////////////////////////////////////////////
+        /// The object of each component.
+        ////////////////////////////////////////////////////////////
+        std::vector<ObjectId> owners_;
+
+        ////////////////////////////////////////////////////////////
+        /// Maps the object slots to the component indices.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::uint32_t> indices_;
+
+    }; // class ComponentPool
+
+    ////////////////////////////////////////////////////////////
+    /// Objects with this component are drawn as image by the
+    /// object store, like an ImageObject.
+    ////////////////////////////////////////////////////////////
+    struct SpriteComponent
+    {
+        TextureRegion region;
+        bool mirror_x;
+        bool mirror_y;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// Data-oriented storage for many simple game objects. The
+    /// common properties are stored as structure of arrays, all
+    /// other data in typed component pools. The objects have no
+    /// virtual update method: The logic iterates linearly over
+    /// the arrays or pools instead.
+    ///
+    /// The arrays are packed, so the index of an object changes
+    /// when another object is destroyed. Objects are referenced
+    /// by their ObjectId, which detects destroyed objects.
+    ////////////////////////////////////////////////////////////
+    class SFE_API ObjectStore
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an empty store.
+        ////////////////////////////////////////////////////////////
+        ObjectStore();
+
+        ////////////////////////////////////////////////////////////
+        /// Create an object at (0, 0) with size (1, 1).
+        ////////////////////////////////////////////////////////////
+        ObjectId create();
+
+        ////////////////////////////////////////////////////////////
+        /// Destroy the object and its components. Unknown ids are
+        /// ignored.
+        ////////////////////////////////////////////////////////////
+        void destroy(ObjectId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Destroy all objects.
+        ////////////////////////////////////////////////////////////
+        void clear();
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the object exists.
+        ////////////////////////////////////////////////////////////
+        bool contains(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of objects.
+        ////////////////////////////////////////////////////////////
+        std::size_t size() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the array index of the object. The index is valid
+        /// until an object is destroyed.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_index(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the ids of the objects.
+        ////////////////////////////////////////////////////////////
+        ObjectId const * get_ids() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the positions of the objects.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f * get_positions();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the positions of the objects.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f const * get_positions() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the sizes of the objects.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f * get_sizes();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the sizes of the objects.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f const * get_sizes() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the rotations of the objects.
+        ////////////////////////////////////////////////////////////
+        float * get_rotations();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the rotations of the objects.
+        ////////////////////////////////////////////////////////////
+        float const * get_rotations() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the z-indices of the objects. They can only be
+        /// changed with set_z_index(), so the draw order is kept.
+        ////////////////////////////////////////////////////////////
+        int const * get_z_indices() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the objects will be rendered (0 or 1).
+        ////////////////////////////////////////////////////////////
+        std::uint8_t * get_visible();
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the objects will be rendered (0 or 1).
+        ////////////////////////////////////////////////////////////
+        std::uint8_t const * get_visible() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the position of the object.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f const & get_position(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the position of the object.
+        ////////////////////////////////////////////////////////////
+        void set_position(ObjectId id, sf::Vector2f const & position);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the size of the object.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f const & get_size(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the size of the object.
+        ////////////////////////////////////////////////////////////
+        void set_size(ObjectId id, sf::Vector2f const & size);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the rotation of the object.
+        ////////////////////////////////////////////////////////////
+        float get_rotation(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the rotation of the object.
+        ////////////////////////////////////////////////////////////
+        void set_rotation(ObjectId id, float angle);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the z-index of the object.
+        ////////////////////////////////////////////////////////////
+        int get_z_index(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the z-index of the object.
+        ////////////////////////////////////////////////////////////
+        void set_z_index(ObjectId id, int z_index);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the object will be rendered.
+        ////////////////////////////////////////////////////////////
+        bool get_visible(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set whether the object will be rendered.
+        ////////////////////////////////////////////////////////////
+        void set_visible(ObjectId id, bool b);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the pool of the component type.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        ComponentPool<T> & get_pool();
+
+        ////////////////////////////////////////////////////////////
+        /// Add the component to the object or replace its
+        /// component.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        T & add_component(ObjectId id, T value);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the component of the object or nullptr if it has
+        /// none.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        T * get_component(ObjectId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Remove the component from the object.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        void remove_component(ObjectId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Call f(index, component) for each component of the type,
+        /// where index is the array index of the object.
+        ////////////////////////////////////////////////////////////
+        template <typename T, typename F>
+        void for_each(F f);
+
+        ////////////////////////////////////////////////////////////
+        /// Render the objects in the order of their z-index,
+        /// starting at the given position of that order and
+        /// stopping before the first object with a z-index of at
+        /// least end_z_index. Return the position where rendering
+        /// stopped. This way, the objects can be interleaved with
+        /// other drawables.
+        ///
+        /// Objects with a SpriteComponent are added to the sprite
+        /// batch.
+        ////////////////////////////////////////////////////////////
+        std::size_t render(SpriteBatch & batch, std::size_t first, int end_z_index) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Render all objects, starting at the given position of
+        /// the z-index order.
+        ////////////////////////////////////////////////////////////
+        void render(SpriteBatch & batch, std::size_t first = 0) const;
+
+    private:
+
+        static std::uint32_t const npos = 0xffffffffu;
+
+        ////////////////////////////////////////////////////////////
+        /// Each object id refers to a slot that holds the array
+        /// index of the object. Free slots are chained by index.
+        ////////////////////////////////////////////////////////////
+        struct Slot
+        {
+            std::uint32_t generation;
+            std::uint32_t index;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Return the pool of the component type or nullptr if no
+        /// component of that type was added yet.
+        ////////////////////////////////////////////////////////////
+        template <typename T>
+        ComponentPool<T> const * find_pool() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the array index of the object and throw if the
+        /// object does not exist.
+        ////////////////////////////////////////////////////////////
+        std::size_t checked_index(ObjectId id) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Sort the render order if it is outdated.
+        ////////////////////////////////////////////////////////////
+        void update_order() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Render the objects between the given positions of the
+        /// z-index order.
+        ////////////////////////////////////////////////////////////
+        void render_range(SpriteBatch & batch, std::size_t first, std::size_t last) const;
+
+        std::vector<Slot> slots_;
+        std::uint32_t free_;
+
+        ////////////////////////////////////////////////////////////
+        /// The properties of the objects (structure of arrays).
+        ////////////////////////////////////////////////////////////
+        std::vector<ObjectId> ids_;
+        std::vector<sf::Vector2f> positions_;
+        std::vector<sf::Vector2f> sizes_;
+        std::vector<float> rotations_;
+        std::vector<int> z_indices_;
+        std::vector<std::uint8_t> visible_;
+
+        ////////////////////////////////////////////////////////////
+        /// The creation sequence numbers of the objects. Objects with
+        /// the same z-index are rendered in creation order.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::uint64_t> sequences_;
+        std::uint64_t next_sequence_;
+
+        ////////////////////////////////////////////////////////////
+        /// The component pools by component type.
+        ////////////////////////////////////////////////////////////
+        std::unordered_map<void const*, std::unique_ptr<detail::ComponentPoolBase>> pools_;
+
+        ////////////////////////////////////////////////////////////
+        /// The array indices sorted by z-index.
+        ////////////////////////////////////////////////////////////
+        mutable std::vector<std::uint32_t> order_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the order must be sorted again.
+        ////////////////////////////////////////////////////////////
+        mutable bool order_dirty_;
+
+    }; // class ObjectStore
+
+    ////////////////////////////////////////////////////////////
+    /// Exception class for all object store exceptions.
+    ////////////////////////////////////////////////////////////
+    DECLARE_EXCEPTION(ObjectStoreException);
+
+    template <typename T>
+    std::uint32_t const ComponentPool<T>::npos;
+
+    template <typename T>
+    T & ComponentPool<T>::add(ObjectId id, T value)
+    {
+        auto const slot = detail::object_slot(id);
+        if (slot >= indices_.size())
+            indices_.resize(slot + 1, npos);
+        auto & index = indices_[slot];
+        if (index != npos)
+        {
+            components_[index] = std::move(value);
+            return components_[index];
+        }
+        index = static_cast<std::uint32_t>(components_.size());
+        components_.push_back(std::move(value));
+        owners_.push_back(id);
+        return components_.back();
+    }
+
+    template <typename T>
+    T * ComponentPool<T>::get(ObjectId id)
+    {
+        auto const slot = detail::object_slot(id);
+        if (slot >= indices_.size() || indices_[slot] == npos || owners_[indices_[slot]] != id)
+            return nullptr;
+        return &components_[indices_[slot]];
+    }
+
+    template <typename T>
+    T const * ComponentPool<T>::get(ObjectId id) const
+    {
+        return const_cast<ComponentPool<T> *>(this)->get(id);
+    }
+
+    template <typename T>
+    void ComponentPool<T>::remove(ObjectId id)
+    {
+        if (get(id))
+            remove_slot(detail::object_slot(id));
+    }
+
+    template <typename T>
+    std::size_t ComponentPool<T>::size() const
+    {
+        return components_.size();
+    }
+
+    template <typename T>
+    template <typename F>
+    void ComponentPool<T>::for_each(F f)
+    {
+        for (std::size_t i = 0; i < components_.size(); ++i)
+            f(owners_[i], components_[i]);
+    }
+
+    template <typename T>
+    void ComponentPool<T>::remove_slot(std::uint32_t slot)
+    {
+        if (slot >= indices_.size() || indices_[slot] == npos)
+            return;
+
+        // Move the last component into the gap.
+        auto const index = indices_[slot];
+        auto const last = static_cast<std::uint32_t>(components_.size() - 1);
+        if (index != last)
+        {
+            components_[index] = std::move(components_[last]);
+            owners_[index] = owners_[last];
+            indices_[detail::object_slot(owners_[index])] = index;
+        }
+        components_.pop_back();
+        owners_.pop_back();
+        indices_[slot] = npos;
+    }
+
+    template <typename T>
+    void ComponentPool<T>::clear()
+    {
+        components_.clear();
+        owners_.clear();
+        indices_.clear();
+    }
+
+    template <typename T>
+    ComponentPool<T> & ObjectStore::get_pool()
+    {
+        auto & pool = pools_[&detail::ComponentType<T>::id];
+        if (!pool)
+            pool = std::make_unique<ComponentPool<T>>();
+        return static_cast<ComponentPool<T> &>(*pool);
+    }
+
+    template <typename T>
+    ComponentPool<T> const * ObjectStore::find_pool() const
+    {
+        auto const it = pools_.find(&detail::ComponentType<T>::id);
+        if (it == pools_.end())
+            return nullptr;
+        return static_cast<ComponentPool<T> const *>(it->second.get());
+    }
+
+    template <typename T, typename F>
+    void ObjectStore::for_each(F f)
+    {
+        get_pool<T>().for_each([this, &f](ObjectId id, T & component)
+        {
+            f(static_cast<std::size_t>(slots_[detail::object_slot(id)].index), component);
+        });
+    }
+
+    template <typename T>
+    T & ObjectStore::add_component(ObjectId id, T value)
+    {
+        checked_index(id);
+        return get_pool<T>().add(id, std::move(value));
+    }
+
+    template <typename T>
+    T * ObjectStore::get_component(ObjectId id)
+    {
+        return get_pool<T>().get(id);
+    }
+
+    template <typename T>
+    void ObjectStore::remove_component(ObjectId id)
+    {
+        get_pool<T>().remove(id);
+    }
+
+} // namespace sfe
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef SFE_PROFILER_HXX
+#define SFE_PROFILER_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+/// SFE_PROFILE_ZONE(name) times the rest of the enclosing
+/// scope, SFE_PROFILE_FRAME() ends a frame of the profiler and
+/// SFE_PROFILE_THREAD(name) names the calling thread. They are
+/// only compiled in if SFE_PROFILING is defined. The names must
+/// be string literals or outlive the profiler.
+////////////////////////////////////////////////////////////
+#ifdef SFE_PROFILING
+    #define SFE_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define SFE_PROFILE_CONCAT(a, b) SFE_PROFILE_CONCAT_IMPL(a, b)
+    #define SFE_PROFILE_ZONE(name) ::sfe::ProfileZone SFE_PROFILE_CONCAT(sfe_profile_zone_, __LINE__)(name)
+    #define SFE_PROFILE_FRAME() ::sfe::Profiler::global().end_frame()
+    #define SFE_PROFILE_THREAD(name) ::sfe::Profiler::global().set_thread_name(name)
+#else
+    #define SFE_PROFILE_ZONE(name) ((void)0)
+    #define SFE_PROFILE_FRAME() ((void)0)
+    #define SFE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// The recorded times of the zones with the same name and
+    /// the same parent zone.
+    ////////////////////////////////////////////////////////////
+    struct ProfileZoneStats
+    {
+        std::string name;
+        std::size_t depth;      // 0 for zones without parent
+        std::uint64_t calls;
+        std::int64_t total_ns;
+        std::int64_t self_ns;   // total_ns without the child zones
+        std::int64_t max_ns;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// The zones of one frame of all threads.
+    ////////////////////////////////////////////////////////////
+    struct SFE_API ProfileFrame
+    {
+        ////////////////////////////////////////////////////////////
+        /// Write one line per zone, indented by the depth.
+        ////////////////////////////////////////////////////////////
+        void write_text(std::ostream & out) const;
+
+        std::uint64_t frame;
+        std::int64_t duration_ns;
+        std::vector<ProfileZoneStats> zones; // depth-first order
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// A scoped-timer profiler. Each thread records its zones in
+    /// its own ring buffer, which keeps the newest zones, so
+    /// recording takes no lock that other threads contend for.
+    /// The recorded zones can be summarized per frame or
+    /// exported as Chrome trace events.
+    ///
+    /// The profiler is disabled until set_enabled(true) is
+    /// called. Use the SFE_PROFILE_* macros to instrument code so
+    /// that the instrumentation can be compiled out.
+    ////////////////////////////////////////////////////////////
+    class SFE_API Profiler
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Return the profiler. It is never destroyed, so zones
+        /// can be recorded until the program exits.
+        ////////////////////////////////////////////////////////////
+        static Profiler & global();
+
+        Profiler(Profiler const &) = delete;
+        Profiler & operator=(Profiler const &) = delete;
+
+        ////////////////////////////////////////////////////////////
+        /// Enable or disable recording.
+        ////////////////////////////////////////////////////////////
+        void set_enabled(bool enabled);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether zones are recorded.
+        ////////////////////////////////////////////////////////////
+        bool is_enabled() const
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Set the number of zones each thread keeps. This drops
+        /// the recorded zones.
+        ////////////////////////////////////////////////////////////
+        void set_capacity(std::size_t capacity);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of zones each thread keeps.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_capacity() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Drop the recorded zones.
+        ////////////////////////////////////////////////////////////
+        void clear();
+
+        ////////////////////////////////////////////////////////////
+        /// Name the calling thread in the exported trace.
+        ////////////////////////////////////////////////////////////
+        void set_thread_name(char const * name);
+
+        ////////////////////////////////////////////////////////////
+        /// Record a zone of the calling thread. The times are in
+        /// nanoseconds of now_ns().
+        ////////////////////////////////////////////////////////////
+        void record(char const * name, std::int64_t begin, std::int64_t end, std::size_t depth);
+
+        ////////////////////////////////////////////////////////////
+        /// End the current frame and begin the next one.
+        ////////////////////////////////////////////////////////////
+        void end_frame();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of ended frames.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t get_frame_count() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Summarize the zones that began in the last ended frame.
+        /// Zones that were still open or were dropped by the ring
+        /// buffers are missing.
+        ////////////////////////////////////////////////////////////
+        ProfileFrame get_last_frame() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Write the recorded zones as Chrome trace-event JSON,
+        /// which trace viewers like chrome://tracing or Perfetto
+        /// can open.
+        ////////////////////////////////////////////////////////////
+        void write_chrome_trace(std::ostream & out) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the time since the profiler was created in
+        /// nanoseconds.
+        ////////////////////////////////////////////////////////////
+        std::int64_t now_ns() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// A recorded zone.
+        ////////////////////////////////////////////////////////////
+        struct Zone
+        {
+            char const * name;
+            std::int64_t begin;
+            std::int64_t end;
+            std::size_t depth;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The ring buffer of a thread. Only the owning thread
+        /// writes to it, the mutex is only contended while the
+        /// zones are read. The ring is allocated on the first
+        /// record. When the owning thread exits, the buffer is
+        /// released and reused by the next thread that needs one.
+        ////////////////////////////////////////////////////////////
+        struct ThreadBuffer
+        {
+            std::mutex mutex;
+            std::size_t id;
+            std::string name;
+            std::vector<Zone> zones;
+            std::size_t written = 0;
+            bool released = false; // guarded by the profiler mutex
+        };
+
+        Profiler();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the buffer of the calling thread and take a
+        /// released one or create it on first use.
+        ////////////////////////////////////////////////////////////
+        ThreadBuffer & get_buffer();
+
+        ////////////////////////////////////////////////////////////
+        /// Copy the kept zones of the buffer in recording order.
+        ////////////////////////////////////////////////////////////
+        static std::vector<Zone> copy_zones(ThreadBuffer & buffer);
+
+        ////////////////////////////////////////////////////////////
+        /// Whether zones are recorded.
+        ////////////////////////////////////////////////////////////
+        std::atomic<bool> enabled_;
+
+        ////////////////////////////////////////////////////////////
+        /// The time of the creation of the profiler.
+        ////////////////////////////////////////////////////////////
+        std::int64_t epoch_;
+
+        ////////////////////////////////////////////////////////////
+        /// Guards the members below.
+        ////////////////////////////////////////////////////////////
+        mutable std::mutex mutex_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of zones each thread keeps.
+        ////////////////////////////////////////////////////////////
+        std::size_t capacity_;
+
+        ////////////////////////////////////////////////////////////
+        /// The buffers of all threads that recorded a zone. The
+        /// buffers of exited threads are kept for the export until
+        /// another thread reuses them.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of ended frames.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t frame_count_;
+
+        ////////////////////////////////////////////////////////////
+        /// The begin of the current frame and the bounds of the
+        /// last ended frame.
+        ////////////////////////////////////////////////////////////
+        std::int64_t frame_begin_;
+        std::int64_t last_frame_begin_;
+        std::int64_t last_frame_end_;
+
+    }; // class Profiler
+
+    ////////////////////////////////////////////////////////////
+    /// Records a zone from its construction to its destruction
+    /// if the profiler is enabled.
+    ////////////////////////////////////////////////////////////
+    class SFE_API ProfileZone
+    {
+    public:
+
+        explicit ProfileZone(char const * name);
+
+        ~ProfileZone();
+
+        ProfileZone(ProfileZone const &) = delete;
+        ProfileZone & operator=(ProfileZone const &) = delete;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The name or nullptr if the profiler was disabled.
+        ////////////////////////////////////////////////////////////
+        char const * name_;
+
+        ////////////////////////////////////////////////////////////
+        /// The begin of the zone.
+        ////////////////////////////////////////////////////////////
+        std::int64_t begin_;
+
+    }; // class ProfileZone
+
+} // namespace sfe
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SFE_RENDER_COMMANDS_HXX
+#define SFE_RENDER_COMMANDS_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// A recorded list of draw calls that is executed later,
+    /// possibly on another thread. The vertices are copied, but
+    /// textures, shaders and fonts are referenced, so they must
+    /// stay alive until the list was executed.
+    ///
+    /// Consecutive draws of triangles with the same render states
+    /// and view are merged into one draw call.
+    ////////////////////////////////////////////////////////////
+    class SFE_API RenderCommands
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an empty list.
+        ////////////////////////////////////////////////////////////
+        RenderCommands();
+
+        ////////////////////////////////////////////////////////////
+        /// Remove all commands. The memory is kept for the next
+        /// frame.
+        ////////////////////////////////////////////////////////////
+        void clear();
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the list has no commands.
+        ////////////////////////////////////////////////////////////
+        bool empty() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Record setting the view of the target.
+        ////////////////////////////////////////////////////////////
+        void set_view(sf::View const & view);
+
+        ////////////////////////////////////////////////////////////
+        /// Record drawing the vertices.
+        ////////////////////////////////////////////////////////////
+        void draw(
+            sf::Vertex const * vertices,
+            std::size_t count,
+            sf::PrimitiveType type,
+            sf::RenderStates const & states = sf::RenderStates::Default
+        );
+
+        ////////////////////////////////////////////////////////////
+        /// Execute the commands on the target.
+        ////////////////////////////////////////////////////////////
+        void execute(sf::RenderTarget & target) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of draw calls of the list.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_draw_calls() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// A draw call of the vertices [first, first + count) with
+        /// the view that was set last. Commands before the first
+        /// view keep the view of the target.
+        ////////////////////////////////////////////////////////////
+        struct Command
+        {
+            std::size_t view;
+            std::size_t first;
+            std::size_t count;
+            sf::PrimitiveType type;
+            sf::RenderStates states;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The recorded views.
+        ////////////////////////////////////////////////////////////
+        std::vector<sf::View> views_;
+
+        ////////////////////////////////////////////////////////////
+        /// The vertices of all draw calls.
+        ////////////////////////////////////////////////////////////
+        std::vector<sf::Vertex> vertices_;
+
+        ////////////////////////////////////////////////////////////
+        /// The draw calls.
+        ////////////////////////////////////////////////////////////
+        std::vector<Command> commands_;
+
+    }; // class RenderCommands
+
+} // namespace sfe
+
+#endif
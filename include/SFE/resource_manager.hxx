@@ -2,12 +2,14 @@
 #define SFE_RESOURCE_MANAGER_HXX
 
 #include <SFE/sfestd.hxx>
+#include <SFE/texture_atlas.hxx>
 
 #include <SFML/Graphics.hpp>
 
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace sfe
 {
@@ -26,8 +28,32 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         std::shared_ptr<sf::Texture> get_texture(std::string const & name);
 
+        ////////////////////////////////////////////////////////////
+        /// If the image with the given name was packed into the
+        /// texture atlas, its region is returned. Otherwise, the
+        /// region covers the whole texture from get_texture().
+        ////////////////////////////////////////////////////////////
+        TextureRegion get_texture_region(std::string const & name);
+
+        ////////////////////////////////////////////////////////////
+        /// Load the images from the files with the given names and
+        /// pack them into the texture atlas. Images that are
+        /// already in the atlas are skipped.
+        ////////////////////////////////////////////////////////////
+        void build_atlas(std::vector<std::string> const & names);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the texture atlas.
+        ////////////////////////////////////////////////////////////
+        TextureAtlas const & get_atlas() const;
+
     private:
-        
+
+        ////////////////////////////////////////////////////////////
+        /// The texture atlas.
+        ////////////////////////////////////////////////////////////
+        TextureAtlas atlas_;
+
         ////////////////////////////////////////////////////////////
         /// The texture storage.
         ////////////////////////////////////////////////////////////
@@ -2,16 +2,23 @@
 #define SFE_SCREEN_HXX
 
 #include <SFE/sfestd.hxx>
+#include <SFE/event_manager.hxx>
 #include <SFE/game_object.hxx>
+#include <SFE/object_store.hxx>
+#include <SFE/render_commands.hxx>
+#include <SFE/spatial_index.hxx>
+#include <SFE/sprite_batch.hxx>
 #include <SFE/widget.hxx>
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace sfe
 {
-    class EventManager;
-    class Listener;
     class ResourceManager;
 
     ////////////////////////////////////////////////////////////
@@ -37,15 +44,34 @@ namespace sfe
         virtual ~Screen();
 
         ////////////////////////////////////////////////////////////
-        /// Update the gui and the game objects.
+        /// Update the gui and the game objects. The game objects
+        /// that allow a parallel update are updated on the global
+        /// job system after the other game objects.
         ////////////////////////////////////////////////////////////
         void update(sf::RenderWindow const & window, sf::Time elapsed_time);
 
         ////////////////////////////////////////////////////////////
-        /// Render the gui and the game objects.
+        /// Update the gui and the game objects without user input,
+        /// e. g. in a headless game. The hover states and the
+        /// viewport ratio of the widgets are left unchanged.
+        ////////////////////////////////////////////////////////////
+        void update(sf::Time elapsed_time);
+
+        ////////////////////////////////////////////////////////////
+        /// Render the gui and the game objects. If culling is
+        /// enabled, only the game objects whose bounds intersect
+        /// the (possibly rotated) game view are rendered.
         ////////////////////////////////////////////////////////////
         void render(sf::RenderTarget & target) const;
 
+        ////////////////////////////////////////////////////////////
+        /// Record the rendering of the gui and the game objects, so
+        /// it can be executed later, e. g. on a render thread. Game
+        /// objects and widgets that do not override their batch
+        /// render method are not recorded.
+        ////////////////////////////////////////////////////////////
+        void render(RenderCommands & commands) const;
+
         ////////////////////////////////////////////////////////////
         /// Return the gui widget.
         ////////////////////////////////////////////////////////////
@@ -57,22 +83,125 @@ namespace sfe
         Widget const & get_gui() const;
 
         ////////////////////////////////////////////////////////////
-        /// Add a game object to the screen.
+        /// Add a game object to the screen and return its handle.
         ////////////////////////////////////////////////////////////
-        GameObject* add_game_object(std::unique_ptr<GameObject> obj);
+        GameObjectHandle add_game_object(std::unique_ptr<GameObject> obj);
 
         ////////////////////////////////////////////////////////////
-        /// Remove a game object from the screen.
+        /// Return the game object of the handle or nullptr if the
+        /// object was removed.
+        ////////////////////////////////////////////////////////////
+        GameObject* get_game_object(GameObjectHandle handle) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Remove a game object from the screen in O(1). The gap in
+        /// the draw order is closed once per frame.
         /// For convenience, the object is returned so it can be
-        /// reused.
+        /// reused. If the object was already removed, nullptr is
+        /// returned.
+        ////////////////////////////////////////////////////////////
+        std::unique_ptr<GameObject> remove_game_object(GameObjectHandle handle);
+
+        ////////////////////////////////////////////////////////////
+        /// Remove a game object from the screen in O(1). If the
+        /// object does not belong to this screen, nullptr is
+        /// returned.
         ////////////////////////////////////////////////////////////
         std::unique_ptr<GameObject> remove_game_object(GameObject* obj);
 
         ////////////////////////////////////////////////////////////
-        /// Clear all game objects.
+        /// Clear all game objects, including the objects of the
+        /// object store.
         ////////////////////////////////////////////////////////////
         void clear_game_objects();
 
+        ////////////////////////////////////////////////////////////
+        /// Append the game objects that contain the point (in
+        /// game view coordinates).
+        ////////////////////////////////////////////////////////////
+        void find_objects_at(sf::Vector2f const & point, std::vector<GameObject*> & result);
+
+        ////////////////////////////////////////////////////////////
+        /// Append the game objects whose bounding boxes intersect
+        /// the rectangle.
+        ////////////////////////////////////////////////////////////
+        void find_objects_in(sf::FloatRect const & rect, std::vector<GameObject*> & result);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the game object whose bounding box is closest to
+        /// the point and not farther away than max_distance, or
+        /// nullptr.
+        ////////////////////////////////////////////////////////////
+        GameObject* find_nearest_object(
+            sf::Vector2f const & point,
+            float max_distance = std::numeric_limits<float>::infinity()
+        );
+
+        ////////////////////////////////////////////////////////////
+        /// Set the cell size of the spatial index of the game
+        /// objects. By default (0), it is chosen from the object
+        /// sizes.
+        ////////////////////////////////////////////////////////////
+        void set_spatial_cell_size(float cell_size);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether game objects outside the game view are
+        /// skipped when rendering.
+        ////////////////////////////////////////////////////////////
+        bool get_culling() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set whether game objects outside the game view are
+        /// skipped when rendering. Culling is enabled by default.
+        /// Disable it if game objects draw outside their bounds.
+        ////////////////////////////////////////////////////////////
+        void set_culling(bool culling);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of visible game objects that were
+        /// rendered in the last frame.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_drawn_objects() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of visible game objects that were
+        /// culled in the last frame.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_culled_objects() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the interpolation factor between the previous and
+        /// the current tick.
+        ////////////////////////////////////////////////////////////
+        float get_interpolation() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the interpolation factor between the previous and
+        /// the current tick. The game objects are rendered at
+        /// previous + alpha * (current - previous). The default 1
+        /// renders the current transforms.
+        ////////////////////////////////////////////////////////////
+        void set_interpolation(float alpha);
+
+        ////////////////////////////////////////////////////////////
+        /// Remember the transforms of the game objects as those of
+        /// the previous tick. A fixed timestep loop calls this
+        /// before each update.
+        ////////////////////////////////////////////////////////////
+        void store_transforms();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the store for simple objects. They are rendered
+        /// together with the game objects. At equal z-index, the
+        /// game objects are drawn first.
+        ////////////////////////////////////////////////////////////
+        ObjectStore & get_object_store();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the store for simple objects.
+        ////////////////////////////////////////////////////////////
+        ObjectStore const & get_object_store() const;
+
         ////////////////////////////////////////////////////////////
         /// Return the game view.
         ////////////////////////////////////////////////////////////
@@ -101,7 +230,7 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         /// Add an event listener.
         ////////////////////////////////////////////////////////////
-        void add_listener(std::shared_ptr<Listener> listener);
+        void add_listener(ListenerHandle listener);
 
         ////////////////////////////////////////////////////////////
         /// Remove all event listeners.
@@ -120,6 +249,95 @@ namespace sfe
 
     private:
 
+        ////////////////////////////////////////////////////////////
+        /// A slot of a game object handle.
+        ////////////////////////////////////////////////////////////
+        struct Slot
+        {
+            std::uint32_t generation;
+            std::uint32_t index;    // position in the draw order or next free slot
+            std::uint32_t entry;    // entry in the spatial index
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// The changes that the game objects reported on one thread
+        /// while they were updated in parallel.
+        ////////////////////////////////////////////////////////////
+        struct ThreadChanges
+        {
+            std::vector<GameObjectHandle> moved_objects;
+            bool order_dirty = false;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Return the changes buffer of the calling thread for the
+        /// current parallel update and assign one on first use.
+        ////////////////////////////////////////////////////////////
+        ThreadChanges & get_thread_changes();
+
+        ////////////////////////////////////////////////////////////
+        /// Update the game objects that allow a parallel update on
+        /// the job system and apply the changes they reported.
+        ////////////////////////////////////////////////////////////
+        void update_parallel(sf::Time elapsed_time);
+
+        ////////////////////////////////////////////////////////////
+        /// Move the game objects whose z-index changed to their new
+        /// place in the draw order and close the gaps of removed
+        /// objects. Objects with equal z-index keep their relative
+        /// order.
+        ////////////////////////////////////////////////////////////
+        void update_order();
+
+        ////////////////////////////////////////////////////////////
+        /// Store the position of the game object in the draw order.
+        ////////////////////////////////////////////////////////////
+        void set_draw_index(GameObject const & obj, std::size_t index);
+
+        ////////////////////////////////////////////////////////////
+        /// Called by a game object when its z-index changed.
+        ////////////////////////////////////////////////////////////
+        void order_changed(GameObject & obj);
+
+        ////////////////////////////////////////////////////////////
+        /// Called by a game object when its bounds changed.
+        ////////////////////////////////////////////////////////////
+        void bounds_changed(GameObject & obj);
+
+        ////////////////////////////////////////////////////////////
+        /// Move the game objects whose bounds changed to their new
+        /// place in the spatial index.
+        ////////////////////////////////////////////////////////////
+        void update_index() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Render the game objects and the gui into the batch.
+        ////////////////////////////////////////////////////////////
+        void render_batch() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Mark the game objects inside the game view with a new
+        /// render stamp.
+        ////////////////////////////////////////////////////////////
+        void cull_objects() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Update the hover states of the game objects and forward
+        /// the clicks. If the mouse is over the gui, no object is
+        /// hovered.
+        ////////////////////////////////////////////////////////////
+        void update_mouse(sf::Vector2f const & point, bool over_gui);
+
+        ////////////////////////////////////////////////////////////
+        /// Call the mouse callbacks of the game object. The
+        /// callbacks may remove and destroy the object, then the
+        /// remaining callbacks are skipped.
+        ////////////////////////////////////////////////////////////
+        void call_mouse_callbacks(
+            GameObject* obj,
+            std::vector<GameObject::CallbackFunction> GameObject::* callbacks
+        );
+
         ////////////////////////////////////////////////////////////
         /// The game view.
         ////////////////////////////////////////////////////////////
@@ -136,19 +354,155 @@ namespace sfe
         std::shared_ptr<ResourceManager> resource_manager_;
 
         ////////////////////////////////////////////////////////////
-        /// The game objects.
+        /// The game objects in draw order. Removed objects leave a
+        /// nullptr until the order is updated.
         ////////////////////////////////////////////////////////////
         std::vector<std::unique_ptr<GameObject> > game_objects_;
 
+        ////////////////////////////////////////////////////////////
+        /// The number of nullptr gaps in game_objects_.
+        ////////////////////////////////////////////////////////////
+        std::size_t removed_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The slots of the game object handles.
+        ////////////////////////////////////////////////////////////
+        std::vector<Slot> slots_;
+
+        ////////////////////////////////////////////////////////////
+        /// The first free slot.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t free_slot_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the z-index of a game object changed since the
+        /// game objects were ordered.
+        ////////////////////////////////////////////////////////////
+        bool order_dirty_;
+
+        ////////////////////////////////////////////////////////////
+        /// Buffer for the game objects that are reordered.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::unique_ptr<GameObject> > changed_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The spatial index of the game objects. It is updated
+        /// lazily, also when rendering.
+        ////////////////////////////////////////////////////////////
+        mutable SpatialIndex index_;
+
+        ////////////////////////////////////////////////////////////
+        /// The game objects whose bounds changed since the index
+        /// was updated.
+        ////////////////////////////////////////////////////////////
+        mutable std::vector<GameObjectHandle> moved_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// Buffer for the game objects that are updated in
+        /// parallel.
+        ////////////////////////////////////////////////////////////
+        std::vector<GameObject*> parallel_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the game objects are updated in parallel. The
+        /// changes are then collected per thread.
+        ////////////////////////////////////////////////////////////
+        bool updating_parallel_;
+
+        ////////////////////////////////////////////////////////////
+        /// The changes buffers of the threads. Each thread that
+        /// reports a change gets its own buffer, whether it is a
+        /// worker or another thread that helps while it waits.
+        /// Only the first used_thread_changes_ buffers are in use.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::unique_ptr<ThreadChanges> > thread_changes_;
+        std::size_t used_thread_changes_;
+
+        ////////////////////////////////////////////////////////////
+        /// Identifies the current parallel update, so threads know
+        /// whether their cached buffer belongs to it.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t parallel_update_id_;
+
+        ////////////////////////////////////////////////////////////
+        /// Guards the assignment of the changes buffers.
+        ////////////////////////////////////////////////////////////
+        std::mutex thread_changes_mutex_;
+
+        ////////////////////////////////////////////////////////////
+        /// The game objects under the mouse.
+        ////////////////////////////////////////////////////////////
+        std::vector<GameObject*> hovered_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The game objects whose callbacks are about to be called.
+        /// Removed objects are replaced by nullptr.
+        ////////////////////////////////////////////////////////////
+        std::vector<GameObject*> pending_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The game object that received the click begin event.
+        ////////////////////////////////////////////////////////////
+        GameObject* pressed_object_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether game objects outside the view are culled.
+        ////////////////////////////////////////////////////////////
+        bool culling_;
+
+        ////////////////////////////////////////////////////////////
+        /// The stamp of the game objects inside the view in the
+        /// current frame.
+        ////////////////////////////////////////////////////////////
+        mutable std::uint32_t render_stamp_;
+
+        ////////////////////////////////////////////////////////////
+        /// Buffer for the game objects near the view.
+        ////////////////////////////////////////////////////////////
+        mutable std::vector<GameObject*> view_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of game objects that were rendered and culled
+        /// in the last frame.
+        ////////////////////////////////////////////////////////////
+        mutable std::size_t drawn_objects_;
+        mutable std::size_t culled_objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The interpolation factor between the previous and the
+        /// current tick.
+        ////////////////////////////////////////////////////////////
+        float interpolation_;
+
+        ////////////////////////////////////////////////////////////
+        /// The data-oriented objects.
+        ////////////////////////////////////////////////////////////
+        ObjectStore objects_;
+
+        ////////////////////////////////////////////////////////////
+        /// The sprite batch for rendering the game objects.
+        ////////////////////////////////////////////////////////////
+        mutable SpriteBatch batch_;
+
         ////////////////////////////////////////////////////////////
         /// The gui widget.
         ////////////////////////////////////////////////////////////
         Widget gui_;
 
+        ////////////////////////////////////////////////////////////
+        /// The mouse position of the last gui hit test and whether
+        /// a widget absorbed the mouse. The hit test only runs
+        /// again if the mouse, its buttons or the gui changed.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2f gui_mouse_;
+        bool gui_handled_;
+
         ////////////////////////////////////////////////////////////
         /// A container for event listeners.
         ////////////////////////////////////////////////////////////
-        std::vector<std::shared_ptr<Listener> > listeners_;
+        std::vector<ListenerHandle> listeners_;
+
+        friend class GameObject;
 
     }; // class Screen
 
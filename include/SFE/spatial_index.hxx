@@ -0,0 +1,234 @@
+#ifndef SFE_SPATIAL_INDEX_HXX
+#define SFE_SPATIAL_INDEX_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace sfe
+{
+    class GameObject;
+
+    ////////////////////////////////////////////////////////////
+    /// A uniform hash grid over the bounding boxes of game
+    /// objects. Objects are stored in every cell their bounds
+    /// overlap, so point queries only look at a single cell.
+    /// Objects that overlap very many cells (e. g. backgrounds)
+    /// are kept in a separate list instead.
+    ///
+    /// If no cell size is set, it is chosen from the object
+    /// sizes when the first objects are inserted.
+    ///
+    /// The caller keeps the entry that insert() returns and uses
+    /// it to update and remove the object.
+    ////////////////////////////////////////////////////////////
+    class SFE_API SpatialIndex
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an empty index.
+        ////////////////////////////////////////////////////////////
+        SpatialIndex();
+
+        ////////////////////////////////////////////////////////////
+        /// Insert the object with the given bounds and return the
+        /// entry of the object. Entries of removed objects are
+        /// reused.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t insert(GameObject * obj, sf::FloatRect const & bounds);
+
+        ////////////////////////////////////////////////////////////
+        /// Update the bounds of the object with the given entry.
+        ////////////////////////////////////////////////////////////
+        void update(std::uint32_t entry, sf::FloatRect const & bounds);
+
+        ////////////////////////////////////////////////////////////
+        /// Remove the object with the given entry.
+        ////////////////////////////////////////////////////////////
+        void remove(std::uint32_t entry);
+
+        ////////////////////////////////////////////////////////////
+        /// Remove all objects.
+        ////////////////////////////////////////////////////////////
+        void clear();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of objects.
+        ////////////////////////////////////////////////////////////
+        std::size_t size() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the cell size or 0 if it is not chosen yet.
+        ////////////////////////////////////////////////////////////
+        float get_cell_size() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Set the cell size and rebuild the grid. A cell size of
+        /// 0 lets the index choose it.
+        ////////////////////////////////////////////////////////////
+        void set_cell_size(float cell_size);
+
+        ////////////////////////////////////////////////////////////
+        /// Append the objects whose bounds contain the point.
+        ////////////////////////////////////////////////////////////
+        void query_point(sf::Vector2f const & point, std::vector<GameObject*> & result) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Append the objects whose bounds intersect the rectangle.
+        ////////////////////////////////////////////////////////////
+        void query_rect(sf::FloatRect const & rect, std::vector<GameObject*> & result) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the object whose bounds are closest to the point
+        /// and not farther away than max_distance, or nullptr.
+        ////////////////////////////////////////////////////////////
+        GameObject * query_nearest(
+            sf::Vector2f const & point,
+            float max_distance = std::numeric_limits<float>::infinity()
+        ) const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The range of cells an object overlaps.
+        ////////////////////////////////////////////////////////////
+        struct CellRange
+        {
+            std::int32_t x0;
+            std::int32_t y0;
+            std::int32_t x1;
+            std::int32_t y1;
+
+            bool operator==(CellRange const & other) const;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// An indexed object. obj is nullptr if the entry is free.
+        ////////////////////////////////////////////////////////////
+        struct Entry
+        {
+            GameObject * obj;
+            sf::FloatRect bounds;
+            CellRange cells;
+            bool large;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// A node in the list of entries of a cell. Free links are
+        /// chained through next.
+        ////////////////////////////////////////////////////////////
+        struct Link
+        {
+            std::uint32_t entry;
+            std::uint32_t next;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Return the cell range of the bounds.
+        ////////////////////////////////////////////////////////////
+        CellRange get_cells(sf::FloatRect const & bounds) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the key of the cell.
+        ////////////////////////////////////////////////////////////
+        static std::uint64_t cell_key(std::int32_t x, std::int32_t y);
+
+        ////////////////////////////////////////////////////////////
+        /// Add the entry to its cells.
+        ////////////////////////////////////////////////////////////
+        void link(std::uint32_t entry);
+
+        ////////////////////////////////////////////////////////////
+        /// Remove the entry from its cells.
+        ////////////////////////////////////////////////////////////
+        void unlink(std::uint32_t entry);
+
+        ////////////////////////////////////////////////////////////
+        /// Rebuild the cells, e. g. after the cell size changed.
+        ////////////////////////////////////////////////////////////
+        void rebuild();
+
+        ////////////////////////////////////////////////////////////
+        /// Recompute the extent if an entry left its border.
+        ////////////////////////////////////////////////////////////
+        void update_extent() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Start a query. Return the stamp that marks the entries
+        /// that were already visited.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t next_stamp() const;
+
+        ////////////////////////////////////////////////////////////
+        /// The maximum number of cells of an object that is stored
+        /// in the cells.
+        ////////////////////////////////////////////////////////////
+        static std::int64_t const max_cells = 16;
+
+        ////////////////////////////////////////////////////////////
+        /// The cell size.
+        ////////////////////////////////////////////////////////////
+        float cell_size_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the cell size is chosen automatically.
+        ////////////////////////////////////////////////////////////
+        bool auto_cell_size_;
+
+        ////////////////////////////////////////////////////////////
+        /// The entries. Removed entries have no object and are
+        /// reused by later insertions.
+        ////////////////////////////////////////////////////////////
+        std::vector<Entry> entries_;
+
+        ////////////////////////////////////////////////////////////
+        /// The removed entries.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::uint32_t> free_entries_;
+
+        ////////////////////////////////////////////////////////////
+        /// The first link of each cell.
+        ////////////////////////////////////////////////////////////
+        std::unordered_map<std::uint64_t, std::uint32_t> cells_;
+
+        ////////////////////////////////////////////////////////////
+        /// The links of all cells.
+        ////////////////////////////////////////////////////////////
+        std::vector<Link> links_;
+
+        ////////////////////////////////////////////////////////////
+        /// The first free link.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t free_link_;
+
+        ////////////////////////////////////////////////////////////
+        /// The entries that are too large for the cells.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::uint32_t> large_;
+
+        ////////////////////////////////////////////////////////////
+        /// The bounding range of all occupied cells. It is shrunk
+        /// lazily after an entry on its border was removed or moved.
+        ////////////////////////////////////////////////////////////
+        mutable CellRange extent_;
+        mutable bool extent_dirty_;
+
+        ////////////////////////////////////////////////////////////
+        /// Visit stamps of the entries, so queries report each
+        /// entry only once.
+        ////////////////////////////////////////////////////////////
+        mutable std::vector<std::uint32_t> stamps_;
+        mutable std::uint32_t stamp_;
+
+    }; // class SpatialIndex
+
+} // namespace sfe
+
+#endif
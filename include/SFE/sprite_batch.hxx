@@ -0,0 +1,131 @@
+#ifndef SFE_SPRITE_BATCH_HXX
+#define SFE_SPRITE_BATCH_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+
+namespace sfe
+{
+    class RenderCommands;
+
+    ////////////////////////////////////////////////////////////
+    /// Collects textured quads and draws consecutive quads with
+    /// the same texture in a single draw call. The quads are drawn
+    /// in the order they are added, so the batch is flushed
+    /// whenever the texture changes.
+    ///
+    /// Instead of drawing to a target, the batch can record its
+    /// draw calls into render commands.
+    ////////////////////////////////////////////////////////////
+    class SFE_API SpriteBatch
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create a batch without target.
+        ////////////////////////////////////////////////////////////
+        SpriteBatch();
+
+        ////////////////////////////////////////////////////////////
+        /// Start drawing to the given target and reset the draw
+        /// call counter.
+        ////////////////////////////////////////////////////////////
+        void begin(sf::RenderTarget & target);
+
+        ////////////////////////////////////////////////////////////
+        /// Start recording into the given commands and reset the
+        /// draw call counter.
+        ////////////////////////////////////////////////////////////
+        void begin(RenderCommands & commands);
+
+        ////////////////////////////////////////////////////////////
+        /// Draw the remaining quads.
+        ////////////////////////////////////////////////////////////
+        void end();
+
+        ////////////////////////////////////////////////////////////
+        /// Add a quad with its center at the given position,
+        /// rotated by the given angle in degrees around its center,
+        /// like an sf::Sprite with the origin in its center.
+        /// Mirroring swaps the texture coordinates of the given
+        /// texture rectangle.
+        ////////////////////////////////////////////////////////////
+        void draw(
+            sf::Texture const & texture,
+            sf::IntRect const & texture_rect,
+            sf::Vector2f const & position,
+            sf::Vector2f const & size,
+            float rotation,
+            bool mirror_x = false,
+            bool mirror_y = false
+        );
+
+        ////////////////////////////////////////////////////////////
+        /// Add an untextured axis-aligned rectangle.
+        ////////////////////////////////////////////////////////////
+        void draw(sf::FloatRect const & rect, sf::Color const & color);
+
+        ////////////////////////////////////////////////////////////
+        /// Draw the collected quads and set the view of the target.
+        ////////////////////////////////////////////////////////////
+        void set_view(sf::View const & view);
+
+        ////////////////////////////////////////////////////////////
+        /// Draw the collected quads. Must be called before drawing
+        /// to the target without the batch.
+        ////////////////////////////////////////////////////////////
+        void flush();
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the batch records into render commands
+        /// instead of drawing to a target.
+        ////////////////////////////////////////////////////////////
+        bool is_recording() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the target. Must not be called while recording.
+        ////////////////////////////////////////////////////////////
+        sf::RenderTarget & get_target() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of draw calls since begin().
+        ////////////////////////////////////////////////////////////
+        std::size_t get_draw_calls() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The render target.
+        ////////////////////////////////////////////////////////////
+        sf::RenderTarget * target_;
+
+        ////////////////////////////////////////////////////////////
+        /// The render commands while recording.
+        ////////////////////////////////////////////////////////////
+        RenderCommands * commands_;
+
+        ////////////////////////////////////////////////////////////
+        /// The texture of the collected quads or nullptr for
+        /// untextured quads.
+        ////////////////////////////////////////////////////////////
+        sf::Texture const * texture_;
+
+        ////////////////////////////////////////////////////////////
+        /// The collected quads as triangles. The array is reused,
+        /// so it does not allocate once it is large enough.
+        ////////////////////////////////////////////////////////////
+        sf::VertexArray vertices_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of draw calls since begin().
+        ////////////////////////////////////////////////////////////
+        std::size_t draw_calls_;
+
+    }; // class SpriteBatch
+
+} // namespace sfe
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef SFE_TEXTURE_ATLAS_HXX
+#define SFE_TEXTURE_ATLAS_HXX
+
+#include <SFE/sfestd.hxx>
+
+#include <SFML/Graphics.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// A rectangle of a texture. Images that are packed into a
+    /// texture atlas are referenced by their region in an atlas
+    /// page.
+    ////////////////////////////////////////////////////////////
+    struct SFE_API TextureRegion
+    {
+        ////////////////////////////////////////////////////////////
+        /// Create an empty region without texture.
+        ////////////////////////////////////////////////////////////
+        TextureRegion();
+
+        ////////////////////////////////////////////////////////////
+        /// Create a region that covers the whole texture.
+        ////////////////////////////////////////////////////////////
+        explicit TextureRegion(std::shared_ptr<sf::Texture> const& texture);
+
+        ////////////////////////////////////////////////////////////
+        /// Create a region that covers the given rectangle of the
+        /// texture.
+        ////////////////////////////////////////////////////////////
+        TextureRegion(std::shared_ptr<sf::Texture> const& texture, sf::IntRect const& rect);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the size of the region.
+        ////////////////////////////////////////////////////////////
+        sf::Vector2i get_size() const;
+
+        ////////////////////////////////////////////////////////////
+        /// The texture.
+        ////////////////////////////////////////////////////////////
+        std::shared_ptr<sf::Texture> texture;
+
+        ////////////////////////////////////////////////////////////
+        /// The rectangle in texture coordinates.
+        ////////////////////////////////////////////////////////////
+        sf::IntRect rect;
+
+    }; // struct TextureRegion
+
+    ////////////////////////////////////////////////////////////
+    /// Packs many small images into a few large textures (pages),
+    /// so sprites with different images can be drawn in one
+    /// call. The images are placed with the skyline bottom-left
+    /// algorithm. Each image is surrounded by a copy of its
+    /// border pixels, so smoothing does not pick up the
+    /// neighbouring images.
+    ////////////////////////////////////////////////////////////
+    class SFE_API TextureAtlas
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an empty atlas whose pages have at most the given
+        /// size. The size is limited to the maximum texture size.
+        ////////////////////////////////////////////////////////////
+        explicit TextureAtlas(unsigned int page_size = 2048);
+
+        ////////////////////////////////////////////////////////////
+        /// Add an image that will be packed by the next call to
+        /// build(). Images larger than a page get a page of their
+        /// own.
+        ////////////////////////////////////////////////////////////
+        void add(std::string const & name, sf::Image const & image);
+
+        ////////////////////////////////////////////////////////////
+        /// Pack the added images and create the page textures.
+        /// Regions of previous builds stay valid.
+        ////////////////////////////////////////////////////////////
+        void build(bool smooth = true);
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the atlas contains the image.
+        ////////////////////////////////////////////////////////////
+        bool contains(std::string const & name) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the region of the image. Throws if the image was
+        /// not packed.
+        ////////////////////////////////////////////////////////////
+        TextureRegion const & get_region(std::string const & name) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the page textures.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::shared_ptr<sf::Texture>> const & get_pages() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// A horizontal segment of the skyline of a page.
+        ////////////////////////////////////////////////////////////
+        struct Segment
+        {
+            unsigned int x;
+            unsigned int y;
+            unsigned int width;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// A page that is being packed.
+        ////////////////////////////////////////////////////////////
+        struct Page
+        {
+            unsigned int width;
+            unsigned int height;
+            std::vector<Segment> skyline;
+            std::vector<std::size_t> images;
+            std::vector<sf::Vector2u> positions;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Find the lowest position in the page where a rectangle
+        /// of the given size fits. Return false if it does not fit.
+        ////////////////////////////////////////////////////////////
+        static bool find_position(Page const & page, sf::Vector2u const & size, std::size_t & segment, sf::Vector2u & pos);
+
+        ////////////////////////////////////////////////////////////
+        /// Place a rectangle at the position found by
+        /// find_position().
+        ////////////////////////////////////////////////////////////
+        static void place(Page & page, std::size_t segment, sf::Vector2u const & pos, sf::Vector2u const & size);
+
+        ////////////////////////////////////////////////////////////
+        /// The maximum page size.
+        ////////////////////////////////////////////////////////////
+        unsigned int page_size_;
+
+        ////////////////////////////////////////////////////////////
+        /// The images that are added but not yet packed.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::pair<std::string, sf::Image>> pending_;
+
+        ////////////////////////////////////////////////////////////
+        /// The page textures.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::shared_ptr<sf::Texture>> pages_;
+
+        ////////////////////////////////////////////////////////////
+        /// The regions of the packed images.
+        ////////////////////////////////////////////////////////////
+        std::map<std::string, TextureRegion> regions_;
+
+    }; // class TextureAtlas
+
+} // namespace sfe
+
+#endif
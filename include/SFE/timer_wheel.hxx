@@ -0,0 +1,150 @@
+#ifndef SFE_TIMER_WHEEL_HXX
+#define SFE_TIMER_WHEEL_HXX
+
+#include <SFE/sfestd.hxx>
+#include <SFE/event_manager.hxx>
+
+#include <SFML/System/Time.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace sfe
+{
+    ////////////////////////////////////////////////////////////
+    /// The timer wheel stores delayed and repeating events. It
+    /// is a hierarchical wheel with a resolution of one
+    /// millisecond: Timers that are due within the next 256
+    /// ticks are stored in the slots of the first level, later
+    /// timers in the coarser slots of the higher levels, from
+    /// where they are moved down as time advances. Adding and
+    /// cancelling a timer is O(1) and advancing the wheel costs
+    /// O(1) per tick plus the work for the timers that fire.
+    ////////////////////////////////////////////////////////////
+    class SFE_API TimerWheel
+    {
+    public:
+
+        ////////////////////////////////////////////////////////////
+        /// Create an empty timer wheel.
+        ////////////////////////////////////////////////////////////
+        TimerWheel();
+
+        ////////////////////////////////////////////////////////////
+        /// Add a timer that fires the event after the given delay.
+        /// If the interval is greater than zero, the timer fires
+        /// repeatedly with the given interval until it is
+        /// cancelled.
+        ////////////////////////////////////////////////////////////
+        TimerId add(Event const& event, sf::Time delay, sf::Time interval);
+
+        ////////////////////////////////////////////////////////////
+        /// Cancel the timer. Returns false if the timer already
+        /// fired or was cancelled.
+        ////////////////////////////////////////////////////////////
+        bool cancel(TimerId id);
+
+        ////////////////////////////////////////////////////////////
+        /// Advance the time and append the events of the timers
+        /// that fired to the given vector.
+        ////////////////////////////////////////////////////////////
+        void advance(sf::Time elapsed_time, std::vector<Event> & fired);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the number of active timers.
+        ////////////////////////////////////////////////////////////
+        std::size_t size() const;
+
+    private:
+
+        ////////////////////////////////////////////////////////////
+        /// The number of levels.
+        ////////////////////////////////////////////////////////////
+        static int const num_levels = 4;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of bits of the slot index per level.
+        ////////////////////////////////////////////////////////////
+        static int const slot_bits = 8;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of slots per level.
+        ////////////////////////////////////////////////////////////
+        static std::uint32_t const num_slots = 1u << slot_bits;
+
+        ////////////////////////////////////////////////////////////
+        /// Marks the end of a timer list.
+        ////////////////////////////////////////////////////////////
+        static std::uint32_t const npos = 0xffffffffu;
+
+        ////////////////////////////////////////////////////////////
+        /// A timer. Unused timers are chained in the free list.
+        ////////////////////////////////////////////////////////////
+        struct Timer
+        {
+            Event event;
+            std::uint64_t expiry;
+            std::uint64_t interval;
+            std::uint32_t generation;
+            std::uint32_t prev;
+            std::uint32_t next;
+            std::uint32_t slot; // the slot that contains the timer
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Put the timer into the slot that matches its expiry.
+        ////////////////////////////////////////////////////////////
+        void insert(std::uint32_t index);
+
+        ////////////////////////////////////////////////////////////
+        /// Remove the timer from its slot.
+        ////////////////////////////////////////////////////////////
+        void unlink(std::uint32_t index);
+
+        ////////////////////////////////////////////////////////////
+        /// Move the timers of the given slot to the lower levels.
+        ////////////////////////////////////////////////////////////
+        void cascade(int level, std::uint32_t slot);
+
+        ////////////////////////////////////////////////////////////
+        /// Process the next tick.
+        ////////////////////////////////////////////////////////////
+        void tick(std::vector<Event> & fired);
+
+        ////////////////////////////////////////////////////////////
+        /// The timer storage.
+        ////////////////////////////////////////////////////////////
+        std::vector<Timer> timers_;
+
+        ////////////////////////////////////////////////////////////
+        /// The first unused timer.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t free_;
+
+        ////////////////////////////////////////////////////////////
+        /// The first timer of each slot. The slots of level l start
+        /// at index l * num_slots.
+        ////////////////////////////////////////////////////////////
+        std::array<std::uint32_t, num_levels * num_slots> slots_;
+
+        ////////////////////////////////////////////////////////////
+        /// The last processed tick.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t current_tick_;
+
+        ////////////////////////////////////////////////////////////
+        /// The elapsed time that did not yet make up a full tick.
+        ////////////////////////////////////////////////////////////
+        sf::Int64 remainder_us_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of active timers.
+        ////////////////////////////////////////////////////////////
+        std::size_t size_;
+
+    }; // class TimerWheel
+
+} // namespace sfe
+
+#endif
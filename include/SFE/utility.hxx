@@ -1,6 +1,9 @@
 #ifndef SFE_UTILITY_HXX
 #define SFE_UTILITY_HXX
 
+#include <SFE/sfestd.hxx>
+
+#include <iosfwd>
 #include <string>
 
 namespace sfe
@@ -11,6 +14,11 @@ namespace sfe
     ////////////////////////////////////////////////////////////
     std::string current_path();
 
+    ////////////////////////////////////////////////////////////
+    /// Write the string as JSON string.
+    ////////////////////////////////////////////////////////////
+    SFE_API void write_json_string(std::ostream & out, std::string const & s);
+
 } // namespace sfe
 
 #endif
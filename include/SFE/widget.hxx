@@ -2,16 +2,19 @@
 #define SFE_WIDGET_HXX
 
 #include <SFE/sfestd.hxx>
+#include <SFE/event_manager.hxx>
+#include <SFE/sprite_batch.hxx>
+#include <SFE/texture_atlas.hxx>
 
 #include <SFML/Graphics.hpp>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <new>
 
 namespace sfe
 {
-    class Listener;
-
     ////////////////////////////////////////////////////////////
     /// Horizontal alignment.
     ////////////////////////////////////////////////////////////
@@ -76,20 +79,54 @@ namespace sfe
         Widget& operator=(Widget const& other) = delete;
 
         ////////////////////////////////////////////////////////////
-        /// Enable move constructor.
+        /// Move constructor. The subwidgets are moved to the new
+        /// widget, which has no parent.
         ////////////////////////////////////////////////////////////
-        Widget(Widget && other) = default;
+        Widget(Widget && other);
 
         ////////////////////////////////////////////////////////////
-        /// Enable move assignment.
+        /// Move assignment. The widget keeps its parent.
         ////////////////////////////////////////////////////////////
-        Widget& operator=(Widget && other) = default;
+        Widget& operator=(Widget && other);
         
         ////////////////////////////////////////////////////////////
         /// Virtual default destructor.
         ////////////////////////////////////////////////////////////
         virtual ~Widget();
 
+        ////////////////////////////////////////////////////////////
+        /// Allocate the object from the global object pool, so
+        /// creating and destroying widgets reuses memory.
+        ////////////////////////////////////////////////////////////
+        static void* operator new(std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Return the memory of the object to the global object
+        /// pool.
+        ////////////////////////////////////////////////////////////
+        static void operator delete(void* p, std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// Placement new, which the class-scope operator new would
+        /// hide otherwise.
+        ////////////////////////////////////////////////////////////
+        static void* operator new(std::size_t, void* p) noexcept
+        {
+            return p;
+        }
+
+        static void operator delete(void*, void*) noexcept
+        {}
+
+#ifdef __cpp_aligned_new
+        ////////////////////////////////////////////////////////////
+        /// The pool only aligns like operator new, so over-aligned
+        /// subclasses are allocated with the global aligned forms.
+        ////////////////////////////////////////////////////////////
+        static void* operator new(std::size_t size, std::align_val_t alignment);
+        static void operator delete(void* p, std::size_t size, std::align_val_t alignment);
+#endif
+
         ////////////////////////////////////////////////////////////
         /// Add the given widget as subwidget.
         /// For convenience, a non-owning widget pointer to the
@@ -117,19 +154,44 @@ namespace sfe
 
         ////////////////////////////////////////////////////////////
         /// Update the mouse and raise mouseover and click events.
+        /// The subwidgets are tested from the topmost one down, and
+        /// the widgets below an absorbing widget do not see the
+        /// mouse. Subtrees whose bounds do not contain the mouse
+        /// are skipped. Return whether the click was absorbed.
         ////////////////////////////////////////////////////////////
         bool update_mouse(float x, float y);
 
+        ////////////////////////////////////////////////////////////
+        /// Return whether the widget tree changed since the last
+        /// update_mouse() call on this root widget, so the mouse
+        /// must be tested again even if it did not move.
+        ////////////////////////////////////////////////////////////
+        bool needs_mouse_update() const;
+
         ////////////////////////////////////////////////////////////
         /// Update the widget and all subwidgets.
         ////////////////////////////////////////////////////////////
         void update(sf::Time elapsed_time);
 
         ////////////////////////////////////////////////////////////
-        /// Render the widget and all subwidgets.
+        /// Compute the render rectangles of the widget and all
+        /// subwidgets. Only the subtrees whose geometry, parent
+        /// rectangle or viewport ratio changed since the last call
+        /// are recomputed, so static widgets cost nothing.
+        ////////////////////////////////////////////////////////////
+        void layout(sf::FloatRect const & parent_render_rect) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Lay out and render the widget and all subwidgets.
         ////////////////////////////////////////////////////////////
         void render(sf::RenderTarget & target, sf::FloatRect const & parent_render_rect) const;
 
+        ////////////////////////////////////////////////////////////
+        /// Lay out and render the widget and all subwidgets into
+        /// the sprite batch.
+        ////////////////////////////////////////////////////////////
+        void render(SpriteBatch & batch, sf::FloatRect const & parent_render_rect) const;
+
         ////////////////////////////////////////////////////////////
         /// Return the x-coordinate.
         ////////////////////////////////////////////////////////////
@@ -176,7 +238,8 @@ namespace sfe
         bool get_visible() const;
 
         ////////////////////////////////////////////////////////////
-        /// Set whether the widget is visible.
+        /// Set whether the widget is visible. Hidden widgets and
+        /// their subwidgets ignore the mouse.
         ////////////////////////////////////////////////////////////
         void set_visible(bool b);
 
@@ -186,7 +249,8 @@ namespace sfe
         int get_z_index() const;
 
         ////////////////////////////////////////////////////////////
-        /// Set the z-index.
+        /// Set the z-index. The parent reorders its subwidgets in
+        /// its next update.
         ////////////////////////////////////////////////////////////
         void set_z_index(int z_index);
 
@@ -250,7 +314,8 @@ namespace sfe
         void set_absorb_click(bool absorb_click);
 
         ////////////////////////////////////////////////////////////
-        /// Return the rectangle that is used for rendering.
+        /// Return the rectangle that is used for rendering, as
+        /// computed by the last layout.
         ////////////////////////////////////////////////////////////
         sf::FloatRect const & get_render_rect() const;
 
@@ -296,7 +361,7 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         /// Add an event listener.
         ////////////////////////////////////////////////////////////
-        void add_listener(std::shared_ptr<Listener> listener);
+        void add_listener(ListenerHandle listener);
 
     protected:
 
@@ -312,6 +377,16 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         virtual void render_impl(sf::RenderTarget & target) const;
 
+        ////////////////////////////////////////////////////////////
+        /// Concrete render method for sprite batches. The default
+        /// implementation flushes the batch and calls render_impl()
+        /// with the target of the batch. If the batch records
+        /// render commands, it throws a GameException unless the
+        /// widget is a plain Widget, so widgets that should be drawn
+        /// by a render thread must override this method.
+        ////////////////////////////////////////////////////////////
+        virtual void render_batch_impl(SpriteBatch & batch) const;
+
     private:
 
         ////////////////////////////////////////////////////////////
@@ -321,7 +396,42 @@ namespace sfe
         sf::FloatRect compute_render_rect(sf::FloatRect const & parent_render_rect) const;
 
         ////////////////////////////////////////////////////////////
-        /// Sort the subwidgets by ascending z-index.
+        /// Update the mouse like update_mouse(x, y). If occluded is
+        /// true, an absorbing widget above hides the mouse.
+        ////////////////////////////////////////////////////////////
+        bool update_mouse(float x, float y, bool occluded);
+
+        ////////////////////////////////////////////////////////////
+        /// Lay out like layout() and return whether a render
+        /// rectangle or the subwidgets changed.
+        ////////////////////////////////////////////////////////////
+        bool layout_subtree(sf::FloatRect const & parent_render_rect) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Mark the root widget for a new hit test.
+        ////////////////////////////////////////////////////////////
+        void mark_mouse_dirty() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Mark the render rectangle for recomputation and the
+        /// parent widgets for a visit by the next layout.
+        ////////////////////////////////////////////////////////////
+        void mark_layout_dirty();
+
+        ////////////////////////////////////////////////////////////
+        /// Render the widget and all subwidgets without layout.
+        ////////////////////////////////////////////////////////////
+        void render_tree(sf::RenderTarget & target) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Render the widget and all subwidgets into the sprite
+        /// batch without layout.
+        ////////////////////////////////////////////////////////////
+        void render_tree(SpriteBatch & batch) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Sort the subwidgets by ascending z-index. Subwidgets
+        /// with the same z-index keep their order.
         ////////////////////////////////////////////////////////////
         void sort_widgets();
         
@@ -331,8 +441,8 @@ namespace sfe
         sf::FloatRect rect_;
 
         ////////////////////////////////////////////////////////////
-        /// The actual rectangle that was used in the last render()
-        /// method. Opposed to rect_, the render_rect_ is computed
+        /// The actual rectangle that was computed by the last
+        /// layout. Opposed to rect_, the render_rect_ is computed
         /// with respect to scale and alignment.
         ////////////////////////////////////////////////////////////
         mutable sf::FloatRect render_rect_;
@@ -391,6 +501,17 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         bool remove_this_;
 
+        ////////////////////////////////////////////////////////////
+        /// Whether the z-index of a subwidget changed since the
+        /// subwidgets were sorted.
+        ////////////////////////////////////////////////////////////
+        bool order_dirty_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether a subwidget is marked for removal.
+        ////////////////////////////////////////////////////////////
+        bool removal_pending_;
+
         ////////////////////////////////////////////////////////////
         /// The subwidgets.
         ////////////////////////////////////////////////////////////
@@ -419,7 +540,47 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         /// A container for event listeners.
         ////////////////////////////////////////////////////////////
-        std::vector<std::shared_ptr<Listener> > listeners_;
+        std::vector<ListenerHandle> listeners_;
+
+        ////////////////////////////////////////////////////////////
+        /// The parent rectangle and the viewport ratio that
+        /// render_rect_ was computed with.
+        ////////////////////////////////////////////////////////////
+        mutable sf::FloatRect layout_parent_rect_;
+        mutable float layout_ratio_;
+
+        ////////////////////////////////////////////////////////////
+        /// The union of the render rectangles of the widget and all
+        /// subwidgets.
+        ////////////////////////////////////////////////////////////
+        mutable sf::FloatRect bounds_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the widget or a subwidget is hovered or pressed,
+        /// so the subtree must be updated when the mouse leaves.
+        ////////////////////////////////////////////////////////////
+        bool mouse_active_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the geometry changed since the last layout.
+        ////////////////////////////////////////////////////////////
+        mutable bool layout_dirty_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether a subwidget needs a layout.
+        ////////////////////////////////////////////////////////////
+        mutable bool subtree_dirty_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the tree changed since the last hit test. Only
+        /// the flag of the root widget is used.
+        ////////////////////////////////////////////////////////////
+        mutable bool mouse_dirty_;
+
+        ////////////////////////////////////////////////////////////
+        /// The parent widget or nullptr.
+        ////////////////////////////////////////////////////////////
+        Widget * parent_;
 
     }; // class Widget
 
@@ -452,6 +613,11 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         virtual void render_impl(sf::RenderTarget & target) const override;
 
+        ////////////////////////////////////////////////////////////
+        /// Add a rectangle of the stored color to the batch.
+        ////////////////////////////////////////////////////////////
+        virtual void render_batch_impl(SpriteBatch & batch) const override;
+
     private:
 
         ////////////////////////////////////////////////////////////
@@ -473,11 +639,21 @@ namespace sfe
         ////////////////////////////////////////////////////////////
         ImageWidget(std::shared_ptr<sf::Texture> const& texture);
 
+        ////////////////////////////////////////////////////////////
+        /// Create an image widget from the given texture region.
+        ////////////////////////////////////////////////////////////
+        ImageWidget(TextureRegion const& region);
+
         ////////////////////////////////////////////////////////////
         /// Set the texture.
         ////////////////////////////////////////////////////////////
         void set_texture(std::shared_ptr<sf::Texture> const& texture);
 
+        ////////////////////////////////////////////////////////////
+        /// Set the texture region.
+        ////////////////////////////////////////////////////////////
+        void set_texture(TextureRegion const& region);
+
     protected:
 
         ////////////////////////////////////////////////////////////
@@ -486,9 +662,14 @@ namespace sfe
         virtual void render_impl(sf::RenderTarget & target) const override;
 
         ////////////////////////////////////////////////////////////
-        /// The texture.
+        /// Add the image to the batch.
+        ////////////////////////////////////////////////////////////
+        virtual void render_batch_impl(SpriteBatch & batch) const override;
+
+        ////////////////////////////////////////////////////////////
+        /// The texture region.
         ////////////////////////////////////////////////////////////
-        std::shared_ptr<sf::Texture> texture_;
+        TextureRegion region_;
 
     }; // class ImageWidget
 
@@ -0,0 +1,54 @@
+#include <SFE/arena.hxx>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sfe
+{
+
+    Arena::Arena(std::size_t block_size)
+        :
+        block_size_(block_size),
+        current_block_(0),
+        offset_(0)
+    {}
+
+    void* Arena::allocate(std::size_t size, std::size_t alignment)
+    {
+        // Try the current block first, then the following ones. Blocks that
+        // are too small are skipped until the next reset.
+        for (; current_block_ < blocks_.size(); ++current_block_, offset_ = 0)
+        {
+            auto & block = blocks_[current_block_];
+            auto const base = reinterpret_cast<std::uintptr_t>(block.data.get());
+            auto const aligned = (base + offset_ + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+            auto const end = aligned - base + size;
+            if (end <= block.size)
+            {
+                offset_ = end;
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+
+        // Append a new block that is large enough for the request.
+        auto const block_size = std::max(block_size_, size + alignment);
+        blocks_.push_back(Block{ std::unique_ptr<char[]>(new char[block_size]), block_size });
+        offset_ = 0;
+        return allocate(size, alignment);
+    }
+
+    void Arena::reset()
+    {
+        current_block_ = 0;
+        offset_ = 0;
+    }
+
+    std::size_t Arena::get_capacity() const
+    {
+        std::size_t capacity = 0;
+        for (auto const & block : blocks_)
+            capacity += block.size;
+        return capacity;
+    }
+
+} // namespace sfe
@@ -1,76 +1,786 @@
 #include <SFE/event_manager.hxx>
+#include <SFE/arena.hxx>
+#include <SFE/timer_wheel.hxx>
 
 #include <algorithm>
-#include <map>
-#include <queue>
-#include <set>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace sfe
 {
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// Used to give each event manager a unique id, so the
+        /// threads can cache their staging buffer.
+        ////////////////////////////////////////////////////////////
+        std::atomic<std::uint64_t> next_event_manager_id(1);
+    }
 
     Event::Event(std::string const& name)
         :
-        name_{ name }
+        id_{ hash_event_name(name.data(), name.size()) },
+        payload_{ nullptr },
+        payload_type_{ nullptr }
     {}
 
-    bool Event::operator<(Event const& other) const
-    {
-        return name_ < other.name_;
-    }
-
-    bool Event::operator==(Event const& other) const
-    {
-        return name_ == other.name_;
-    }
-
     Listener::Listener(Callback const& f)
         :
         callback_{ f }
     {}
 
+    Listener::Listener(BatchCallback const& f)
+        :
+        batch_callback_{ f }
+    {}
+
     void Listener::set_callback(Callback const& f)
     {
         callback_ = f;
     }
 
+    void Listener::set_callback(BatchCallback const& f)
+    {
+        batch_callback_ = f;
+    }
+
     void Listener::notify(Event const& event) const
     {
         if (callback_)
             callback_(event);
     }
 
+    void Listener::notify(EventSpan const& events) const
+    {
+        if (batch_callback_)
+            batch_callback_(events);
+    }
+
+    namespace detail
+    {
+        ////////////////////////////////////////////////////////////
+        /// Stores the listeners of an event manager in a slot map.
+        /// The listeners of each event are kept contiguously in
+        /// registration order. Unregistered listeners are only
+        /// marked and erased once they make up half of their list,
+        /// so unregistering is O(1) amortized. While the listeners
+        /// are notified, new listeners are kept aside and marked
+        /// listeners are not destroyed, so the lists never change
+        /// during iteration.
+        ////////////////////////////////////////////////////////////
+        class ListenerRegistry
+        {
+        public:
+
+            ListenerRegistry();
+
+            ////////////////////////////////////////////////////////////
+            /// Add the listener to the given list and return its id.
+            ////////////////////////////////////////////////////////////
+            std::uint64_t add(std::uint32_t list, Listener listener, bool batch);
+
+            ////////////////////////////////////////////////////////////
+            /// Unregister the listener. Unknown ids are ignored.
+            ////////////////////////////////////////////////////////////
+            void remove(std::uint64_t id);
+
+            ////////////////////////////////////////////////////////////
+            /// Return whether the listener is registered.
+            ////////////////////////////////////////////////////////////
+            bool contains(std::uint64_t id) const;
+
+            ////////////////////////////////////////////////////////////
+            /// Notify the listeners of the given list.
+            ////////////////////////////////////////////////////////////
+            void notify(std::uint32_t list, Event const& event);
+
+            ////////////////////////////////////////////////////////////
+            /// Notify the batch listeners of the given list.
+            ////////////////////////////////////////////////////////////
+            void notify(std::uint32_t list, EventSpan const& events);
+
+            ////////////////////////////////////////////////////////////
+            /// Return whether the given list has batch listeners.
+            ////////////////////////////////////////////////////////////
+            bool has_batch_listeners(std::uint32_t list) const;
+
+            ////////////////////////////////////////////////////////////
+            /// Mark the begin or the end of the notifications. At the
+            /// end, the deferred changes are applied.
+            ////////////////////////////////////////////////////////////
+            void set_dispatching(bool dispatching);
+
+            ////////////////////////////////////////////////////////////
+            /// Add the listeners that were registered during dispatch.
+            /// This must not be called while listeners are notified.
+            ////////////////////////////////////////////////////////////
+            void add_pending();
+
+            ////////////////////////////////////////////////////////////
+            /// Enable or disable measuring the callback times.
+            ////////////////////////////////////////////////////////////
+            void set_timing(bool timing);
+
+            ////////////////////////////////////////////////////////////
+            /// Append the callback times of the listeners of the given
+            /// list. The event is not filled in.
+            ////////////////////////////////////////////////////////////
+            void collect_stats(std::uint32_t list, std::vector<ListenerStats> & stats) const;
+
+            ////////////////////////////////////////////////////////////
+            /// Reset the callback times.
+            ////////////////////////////////////////////////////////////
+            void reset_stats();
+
+        private:
+
+            static std::uint32_t const npos = 0xffffffffu;
+
+            ////////////////////////////////////////////////////////////
+            /// A listener and the index of its handle (npos if the
+            /// listener was unregistered).
+            ////////////////////////////////////////////////////////////
+            struct Entry
+            {
+                Listener listener;
+                std::uint32_t handle;
+#ifdef SFE_EVENT_STATS
+                std::uint64_t calls;
+                std::int64_t total_ns;
+                std::int64_t max_ns;
+#endif
+            };
+
+            ////////////////////////////////////////////////////////////
+            /// The listeners of one event.
+            ////////////////////////////////////////////////////////////
+            struct List
+            {
+                List()
+                    :
+                    removed(0)
+                {}
+
+                std::vector<Entry> listeners;
+                std::vector<Entry> batch_listeners;
+                std::size_t removed; // the number of unregistered entries
+            };
+
+            ////////////////////////////////////////////////////////////
+            /// The location of a listener.
+            ////////////////////////////////////////////////////////////
+            enum class State : std::uint8_t
+            {
+                Free,
+                Pending,
+                Active
+            };
+
+            ////////////////////////////////////////////////////////////
+            /// The slot of a listener id. Free handles are chained by
+            /// their position.
+            ////////////////////////////////////////////////////////////
+            struct Handle
+            {
+                std::uint32_t generation;
+                std::uint32_t list;
+                std::uint32_t position; // index in the list or in the pending listeners
+                State state;
+                bool batch;
+            };
+
+            ////////////////////////////////////////////////////////////
+            /// A listener that was registered during dispatch.
+            ////////////////////////////////////////////////////////////
+            struct PendingEntry
+            {
+                std::uint32_t list;
+                Entry entry;
+            };
+
+            ////////////////////////////////////////////////////////////
+            /// A listener that was unregistered during dispatch.
+            ////////////////////////////////////////////////////////////
+            struct Removal
+            {
+                std::uint32_t list;
+                std::uint32_t position;
+                bool batch;
+            };
+
+            ////////////////////////////////////////////////////////////
+            /// Append the entry to the list.
+            ////////////////////////////////////////////////////////////
+            void append(std::uint32_t list, Entry entry, bool batch);
+
+            ////////////////////////////////////////////////////////////
+            /// Erase the unregistered entries of the list if they make
+            /// up at least half of it.
+            ////////////////////////////////////////////////////////////
+            void compact(std::uint32_t list);
+
+            ////////////////////////////////////////////////////////////
+            /// Notify the registered entries with the given argument.
+            ////////////////////////////////////////////////////////////
+            template <typename T>
+            void notify_entries(std::vector<Entry> & entries, T const& arg);
+
+            std::vector<Handle> handles_;
+            std::uint32_t free_;
+            std::vector<List> lists_;
+            std::vector<PendingEntry> pending_;
+            std::vector<Removal> removals_;
+            bool dispatching_;
+            bool timing_;
+        };
+
+        ListenerRegistry::ListenerRegistry()
+            :
+            free_(npos),
+            dispatching_(false),
+            timing_(false)
+        {}
+
+        std::uint64_t ListenerRegistry::add(std::uint32_t list, Listener listener, bool batch)
+        {
+            std::uint32_t index;
+            if (free_ != npos)
+            {
+                index = free_;
+                free_ = handles_[index].position;
+            }
+            else
+            {
+                index = static_cast<std::uint32_t>(handles_.size());
+                handles_.push_back(Handle{ 1, npos, npos, State::Free, false });
+            }
+            handles_[index].list = list;
+            handles_[index].batch = batch;
+            if (dispatching_)
+            {
+                handles_[index].state = State::Pending;
+                handles_[index].position = static_cast<std::uint32_t>(pending_.size());
+                pending_.push_back(PendingEntry{ list, Entry{ std::move(listener), index } });
+            }
+            else
+            {
+                append(list, Entry{ std::move(listener), index }, batch);
+            }
+            return (static_cast<std::uint64_t>(handles_[index].generation) << 32) | index;
+        }
+
+        void ListenerRegistry::remove(std::uint64_t id)
+        {
+            if (!contains(id))
+                return;
+            auto const index = static_cast<std::uint32_t>(id & 0xffffffffu);
+            auto & h = handles_[index];
+            if (h.state == State::Pending)
+            {
+                pending_[h.position].entry.handle = npos;
+            }
+            else
+            {
+                auto & list = lists_[h.list];
+                auto & entry = (h.batch ? list.batch_listeners : list.listeners)[h.position];
+                entry.handle = npos;
+                ++list.removed;
+
+                // The listener may currently be running, so it is only
+                // destroyed after dispatch.
+                if (dispatching_)
+                {
+                    removals_.push_back(Removal{ h.list, h.position, h.batch });
+                }
+                else
+                {
+                    entry.listener = Listener(Listener::Callback());
+                    compact(h.list);
+                }
+            }
+            ++h.generation;
+            h.state = State::Free;
+            h.position = free_;
+            free_ = index;
+        }
+
+        bool ListenerRegistry::contains(std::uint64_t id) const
+        {
+            auto const index = static_cast<std::uint32_t>(id & 0xffffffffu);
+            auto const generation = static_cast<std::uint32_t>(id >> 32);
+            return index < handles_.size()
+                && handles_[index].generation == generation
+                && handles_[index].state != State::Free;
+        }
+
+        void ListenerRegistry::notify(std::uint32_t list, Event const& event)
+        {
+            if (list < lists_.size())
+                notify_entries(lists_[list].listeners, event);
+        }
+
+        void ListenerRegistry::notify(std::uint32_t list, EventSpan const& events)
+        {
+            notify_entries(lists_[list].batch_listeners, events);
+        }
+
+        template <typename T>
+        void ListenerRegistry::notify_entries(std::vector<Entry> & entries, T const& arg)
+        {
+#ifdef SFE_EVENT_STATS
+            if (timing_)
+            {
+                for (auto & entry : entries)
+                {
+                    if (entry.handle == npos)
+                        continue;
+                    auto const start = std::chrono::steady_clock::now();
+                    entry.listener.notify(arg);
+                    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                    ++entry.calls;
+                    entry.total_ns += ns;
+                    entry.max_ns = std::max<std::int64_t>(entry.max_ns, ns);
+                }
+                return;
+            }
+#endif
+            for (auto const& entry : entries)
+                if (entry.handle != npos)
+                    entry.listener.notify(arg);
+        }
+
+        bool ListenerRegistry::has_batch_listeners(std::uint32_t list) const
+        {
+            return list < lists_.size() && lists_[list].batch_listeners.size() > 0;
+        }
+
+        void ListenerRegistry::set_dispatching(bool dispatching)
+        {
+            dispatching_ = dispatching;
+            if (dispatching)
+                return;
+            add_pending();
+            for (auto const& r : removals_)
+            {
+                auto & list = lists_[r.list];
+                (r.batch ? list.batch_listeners : list.listeners)[r.position].listener = Listener(Listener::Callback());
+            }
+            for (auto const& r : removals_)
+                compact(r.list);
+            removals_.clear();
+        }
+
+        void ListenerRegistry::add_pending()
+        {
+            for (auto & p : pending_)
+                if (p.entry.handle != npos)
+                    append(p.list, std::move(p.entry), handles_[p.entry.handle].batch);
+            pending_.clear();
+        }
+
+        void ListenerRegistry::set_timing(bool timing)
+        {
+            timing_ = timing;
+        }
+
+        void ListenerRegistry::collect_stats(std::uint32_t list, std::vector<ListenerStats> & stats) const
+        {
+#ifdef SFE_EVENT_STATS
+            if (list >= lists_.size())
+                return;
+            for (auto const entries : { &lists_[list].listeners, &lists_[list].batch_listeners })
+            {
+                for (auto const& entry : *entries)
+                {
+                    if (entry.handle == npos)
+                        continue;
+                    auto const& h = handles_[entry.handle];
+                    ListenerStats l;
+                    l.event_id = 0;
+                    l.listener_id = (static_cast<std::uint64_t>(h.generation) << 32) | entry.handle;
+                    l.batch = h.batch;
+                    l.calls = entry.calls;
+                    l.total_ns = entry.total_ns;
+                    l.max_ns = entry.max_ns;
+                    stats.push_back(std::move(l));
+                }
+            }
+#endif
+        }
+
+        void ListenerRegistry::reset_stats()
+        {
+#ifdef SFE_EVENT_STATS
+            for (auto & list : lists_)
+            {
+                for (auto entries : { &list.listeners, &list.batch_listeners })
+                {
+                    for (auto & entry : *entries)
+                    {
+                        entry.calls = 0;
+                        entry.total_ns = 0;
+                        entry.max_ns = 0;
+                    }
+                }
+            }
+#endif
+        }
+
+        void ListenerRegistry::append(std::uint32_t list, Entry entry, bool batch)
+        {
+            if (list >= lists_.size())
+                lists_.resize(list + 1);
+            auto & entries = batch ? lists_[list].batch_listeners : lists_[list].listeners;
+            auto & h = handles_[entry.handle];
+            h.state = State::Active;
+            h.position = static_cast<std::uint32_t>(entries.size());
+            entries.push_back(std::move(entry));
+        }
+
+        void ListenerRegistry::compact(std::uint32_t list)
+        {
+            auto & l = lists_[list];
+            if (l.removed == 0 || 2 * l.removed < l.listeners.size() + l.batch_listeners.size())
+                return;
+            for (auto entries : { &l.listeners, &l.batch_listeners })
+            {
+                std::size_t n = 0;
+                for (std::size_t i = 0; i < entries->size(); ++i)
+                {
+                    if ((*entries)[i].handle == npos)
+                        continue;
+                    if (i != n)
+                        (*entries)[n] = std::move((*entries)[i]);
+                    handles_[(*entries)[n].handle].position = static_cast<std::uint32_t>(n);
+                    ++n;
+                }
+                entries->erase(entries->begin() + n, entries->end());
+            }
+            l.removed = 0;
+        }
+
+    } // namespace detail
+
+    ListenerHandle::ListenerHandle()
+        :
+        id_(0)
+    {}
+
+    ListenerHandle::ListenerHandle(std::weak_ptr<detail::ListenerRegistry> registry, std::uint64_t id)
+        :
+        registry_(std::move(registry)),
+        id_(id)
+    {}
+
+    ListenerHandle::~ListenerHandle()
+    {
+        reset();
+    }
+
+    ListenerHandle::ListenerHandle(ListenerHandle && other) noexcept
+        :
+        registry_(std::move(other.registry_)),
+        id_(other.id_)
+    {
+        other.id_ = 0;
+    }
+
+    ListenerHandle & ListenerHandle::operator=(ListenerHandle && other)
+    {
+        if (this != &other)
+        {
+            reset();
+            registry_ = std::move(other.registry_);
+            id_ = other.id_;
+            other.id_ = 0;
+        }
+        return *this;
+    }
+
+    bool ListenerHandle::is_registered() const
+    {
+        auto const registry = registry_.lock();
+        return registry && registry->contains(id_);
+    }
+
+    std::uint64_t ListenerHandle::get_id() const
+    {
+        return id_;
+    }
+
+    void ListenerHandle::reset()
+    {
+        if (id_ != 0)
+            if (auto registry = registry_.lock())
+                registry->remove(id_);
+        registry_.reset();
+        id_ = 0;
+    }
+
     class EventManager::impl
     {
     public:
 
-        std::shared_ptr<Listener> register_listener(
+        impl();
+
+        std::uint64_t register_listener(
             Event const& event,
             Listener::Callback const& callback
         );
 
+        std::uint64_t register_batch_listener(
+            Event const& event,
+            Listener::BatchCallback const& callback
+        );
+
+        std::shared_ptr<detail::ListenerRegistry> const& get_registry() const;
+
+        void set_coalesce_policy(Event const& event, CoalescePolicy policy);
+
         void enqueue(Event const& event);
 
+        TimerId add_timer(Event const& event, sf::Time delay, sf::Time interval);
+
+        bool cancel_timer(TimerId id);
+
+        void advance_timers(sf::Time elapsed_time);
+
         void dispatch();
 
         void register_event(Event const& event);
 
+        void register_event(std::string const& name);
+
+        std::string get_event_name(Event const& event) const;
+
+        void set_stats_enabled(bool enabled);
+
+        bool get_stats_enabled() const;
+
+        EventManagerStats get_stats() const;
+
+        void reset_stats();
+
+        void enqueue_payload(
+            Event const& event,
+            std::size_t size,
+            std::size_t alignment,
+            void const* payload,
+            void const* payload_type,
+            PayloadConstructor construct
+        );
+
     private:
 
         ////////////////////////////////////////////////////////////
-        /// The registered listeners.
+        /// Marks that no event is waiting for delivery.
+        ////////////////////////////////////////////////////////////
+        static std::size_t const npos = static_cast<std::size_t>(-1);
+
+        ////////////////////////////////////////////////////////////
+        /// Everything that is stored per event type.
+        ////////////////////////////////////////////////////////////
+        struct Slot
+        {
+            Slot()
+                :
+                policy(CoalescePolicy::None),
+                waiting(npos),
+                count(nullptr),
+                enqueued(0),
+                delivered(0)
+            {}
+
+            std::vector<Event> batch;
+            CoalescePolicy policy;
+            std::size_t waiting; // queue index of the event that waits for delivery
+            EventCount* count;   // payload of the waiting event if counted
+            std::uint64_t enqueued;
+            std::uint64_t delivered;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Collects the events that one thread enqueues while
+        /// another thread dispatches. The payloads are written to
+        /// one arena while the payloads in the other arena are
+        /// dispatched. When the owning thread exits, the buffer is
+        /// released and reused by the next thread that needs one.
+        ////////////////////////////////////////////////////////////
+        struct Staging
+        {
+            Staging()
+                :
+                thread(std::thread::id()),
+                current(0)
+            {}
+
+            std::atomic<std::thread::id> thread; // default id if released
+            std::mutex mutex;
+            std::vector<Event> events;
+            Arena arenas[2];
+            int current;
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// Return the slot index of the event or npos if the event
+        /// has no slot.
+        ////////////////////////////////////////////////////////////
+        std::size_t find_slot(Event const& event) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the slot index of the event and create the slot
+        /// if necessary.
+        ////////////////////////////////////////////////////////////
+        std::size_t get_slot(Event const& event);
+
+        ////////////////////////////////////////////////////////////
+        /// Append the event to the queue with respect to the
+        /// coalesce policy.
+        ////////////////////////////////////////////////////////////
+        void push_event(Event const& event);
+
+        ////////////////////////////////////////////////////////////
+        /// Deliver the queued events and the resulting batches
+        /// until the queue is empty.
+        ////////////////////////////////////////////////////////////
+        void deliver_events();
+
+        ////////////////////////////////////////////////////////////
+        /// Reset the per-frame state after dispatch.
+        ////////////////////////////////////////////////////////////
+        void finish_dispatch();
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the calling thread is the dispatching
+        /// thread.
+        ////////////////////////////////////////////////////////////
+        bool on_dispatch_thread() const;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the staging buffer of the calling thread.
+        ////////////////////////////////////////////////////////////
+        Staging & get_staging();
+
+        ////////////////////////////////////////////////////////////
+        /// Append the events of the staging buffers to the queue.
+        ////////////////////////////////////////////////////////////
+        void merge_staged_events();
+
+        ////////////////////////////////////////////////////////////
+        /// Throw if the event is not registered.
+        ////////////////////////////////////////////////////////////
+        void check_event_type(Event const& event, char const* caller) const;
+
+        ////////////////////////////////////////////////////////////
+        /// Maps each event to the index of its slot.
+        ////////////////////////////////////////////////////////////
+        std::unordered_map<Event, std::size_t> slot_indices_;
+
+        ////////////////////////////////////////////////////////////
+        /// The batches and the coalescing state of each event.
         ////////////////////////////////////////////////////////////
-        std::map<Event, std::vector<std::weak_ptr<Listener>>> listeners_;
+        std::vector<Slot> slots_;
 
         ////////////////////////////////////////////////////////////
-        /// The enqueued events.
+        /// The enqueued events. The vector is cleared after each
+        /// dispatch, so its capacity is reused in the next frame.
         ////////////////////////////////////////////////////////////
-        std::queue<Event> event_queue_;
+        std::vector<Event> event_queue_;
+
+        ////////////////////////////////////////////////////////////
+        /// The slots whose batch is not empty.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::size_t> batched_slots_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the events are currently dispatched.
+        ////////////////////////////////////////////////////////////
+        bool dispatching_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether any event has a coalesce policy.
+        ////////////////////////////////////////////////////////////
+        bool coalescing_;
+
+        ////////////////////////////////////////////////////////////
+        /// The listeners. They are stored in lists with the same
+        /// index as the slot of their event. The handles only hold
+        /// a weak reference, so they can outlive the event manager.
+        ////////////////////////////////////////////////////////////
+        std::shared_ptr<detail::ListenerRegistry> registry_;
+
+        ////////////////////////////////////////////////////////////
+        /// The payloads of the enqueued events.
+        ////////////////////////////////////////////////////////////
+        Arena payload_arena_;
+
+        ////////////////////////////////////////////////////////////
+        /// The delayed and repeating events.
+        ////////////////////////////////////////////////////////////
+        TimerWheel timers_;
+
+        ////////////////////////////////////////////////////////////
+        /// The events of the timers that fired in the last call to
+        /// advance_timers(). Kept to reuse the memory.
+        ////////////////////////////////////////////////////////////
+        std::vector<Event> fired_events_;
 
         ////////////////////////////////////////////////////////////
         /// The list with the registered events.
         ////////////////////////////////////////////////////////////
-        std::set<Event> registered_events_;
+        std::unordered_set<Event> registered_events_;
+
+        ////////////////////////////////////////////////////////////
+        /// The names of the events that were registered by name.
+        /// They are only used for debugging.
+        ////////////////////////////////////////////////////////////
+        std::unordered_map<Event, std::string> event_names_;
+
+        ////////////////////////////////////////////////////////////
+        /// The unique id of the event manager.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t const id_;
+
+        ////////////////////////////////////////////////////////////
+        /// The thread that dispatches the events.
+        ////////////////////////////////////////////////////////////
+        std::atomic<std::thread::id> dispatch_thread_;
+
+        ////////////////////////////////////////////////////////////
+        /// Guards the list of staging buffers.
+        ////////////////////////////////////////////////////////////
+        std::mutex staging_mutex_;
+
+        ////////////////////////////////////////////////////////////
+        /// The staging buffers of the threads that enqueued events
+        /// while another thread dispatches. The threads keep weak
+        /// references to release their buffers when they exit.
+        ////////////////////////////////////////////////////////////
+        std::vector<std::shared_ptr<Staging>> staging_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the instrumentation is enabled.
+        ////////////////////////////////////////////////////////////
+        bool stats_enabled_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of calls to dispatch() while the
+        /// instrumentation was enabled.
+        ////////////////////////////////////////////////////////////
+        std::uint64_t stats_dispatches_;
+
+        ////////////////////////////////////////////////////////////
+        /// The largest number of queued events.
+        ////////////////////////////////////////////////////////////
+        std::size_t peak_queue_depth_;
 
     };
 
@@ -85,11 +795,25 @@ namespace sfe
 
     EventManager& EventManager::operator=(EventManager && other) = default;
     
-    std::shared_ptr<Listener> EventManager::register_listener(
+    ListenerHandle EventManager::register_listener(
         Event const & event,
         Listener::Callback const& callback
     ){
-        return impl_->register_listener(event, callback);
+        auto const id = impl_->register_listener(event, callback);
+        return ListenerHandle(impl_->get_registry(), id);
+    }
+
+    ListenerHandle EventManager::register_batch_listener(
+        Event const & event,
+        Listener::BatchCallback const& callback
+    ){
+        auto const id = impl_->register_batch_listener(event, callback);
+        return ListenerHandle(impl_->get_registry(), id);
+    }
+
+    void EventManager::set_coalesce_policy(Event const& event, CoalescePolicy policy)
+    {
+        impl_->set_coalesce_policy(event, policy);
     }
 
     void EventManager::enqueue(Event const& event)
@@ -97,6 +821,32 @@ namespace sfe
         impl_->enqueue(event);
     }
 
+    TimerId EventManager::enqueue_after(Event const& event, sf::Time delay)
+    {
+        Event ev(event);
+        attach_payload(ev, nullptr, nullptr);
+        return impl_->add_timer(ev, delay, sf::Time::Zero);
+    }
+
+    TimerId EventManager::enqueue_every(Event const& event, sf::Time interval)
+    {
+        if (interval <= sf::Time::Zero)
+            throw EventException("EventManager::enqueue_every(): The interval must be positive.");
+        Event ev(event);
+        attach_payload(ev, nullptr, nullptr);
+        return impl_->add_timer(ev, interval, interval);
+    }
+
+    bool EventManager::cancel_timer(TimerId id)
+    {
+        return impl_->cancel_timer(id);
+    }
+
+    void EventManager::advance_timers(sf::Time elapsed_time)
+    {
+        impl_->advance_timers(elapsed_time);
+    }
+
     void EventManager::dispatch()
     {
         impl_->dispatch();
@@ -107,66 +857,499 @@ namespace sfe
         impl_->register_event(event);
     }
 
-    std::shared_ptr<Listener> EventManager::impl::register_listener(
+    void EventManager::register_event(std::string const& name)
+    {
+        impl_->register_event(name);
+    }
+
+    std::string EventManager::get_event_name(Event const& event) const
+    {
+        return impl_->get_event_name(event);
+    }
+
+    void EventManager::set_stats_enabled(bool enabled)
+    {
+        impl_->set_stats_enabled(enabled);
+    }
+
+    bool EventManager::get_stats_enabled() const
+    {
+        return impl_->get_stats_enabled();
+    }
+
+    EventManagerStats EventManager::get_stats() const
+    {
+        return impl_->get_stats();
+    }
+
+    void EventManager::reset_stats()
+    {
+        impl_->reset_stats();
+    }
+
+    void EventManager::enqueue_payload(
+        Event const& event,
+        std::size_t size,
+        std::size_t alignment,
+        void const* payload,
+        void const* payload_type,
+        PayloadConstructor construct
+    ){
+        impl_->enqueue_payload(event, size, alignment, payload, payload_type, construct);
+    }
+
+    void EventManager::attach_payload(Event & event, void const* payload, void const* payload_type)
+    {
+        event.payload_ = payload;
+        event.payload_type_ = payload_type;
+    }
+
+    EventManager::impl::impl()
+        :
+        dispatching_(false),
+        coalescing_(false),
+        registry_(std::make_shared<detail::ListenerRegistry>()),
+        id_(next_event_manager_id++),
+        dispatch_thread_(std::this_thread::get_id()),
+        stats_enabled_(false),
+        stats_dispatches_(0),
+        peak_queue_depth_(0)
+    {}
+
+    std::uint64_t EventManager::impl::register_listener(
         Event const& event,
         Listener::Callback const& callback
     ){
 #ifdef CHECKEVENTTYPE
-        if (registered_events_.count(event) == 0)
-            throw EventException("EventManager::register_listener(): Tried to register a listener for an unregistered event.");
+        check_event_type(event, "EventManager::register_listener()");
+#endif
+        auto const index = static_cast<std::uint32_t>(get_slot(event));
+        return registry_->add(index, Listener(callback), false);
+    }
+
+    std::uint64_t EventManager::impl::register_batch_listener(
+        Event const& event,
+        Listener::BatchCallback const& callback
+    ){
+#ifdef CHECKEVENTTYPE
+        check_event_type(event, "EventManager::register_batch_listener()");
 #endif
-        auto listener = std::make_shared<Listener>(callback);
-        listeners_[event].emplace_back(listener);
-        return listener;
+        auto const index = static_cast<std::uint32_t>(get_slot(event));
+        return registry_->add(index, Listener(callback), true);
+    }
+
+    std::shared_ptr<detail::ListenerRegistry> const& EventManager::impl::get_registry() const
+    {
+        return registry_;
+    }
+
+    void EventManager::impl::set_coalesce_policy(Event const& event, CoalescePolicy policy)
+    {
+        if (dispatching_)
+            throw EventException("EventManager::set_coalesce_policy(): The policy cannot be changed during dispatch.");
+        slots_[get_slot(event)].policy = policy;
+        if (policy != CoalescePolicy::None)
+            coalescing_ = true;
     }
 
     void EventManager::impl::enqueue(Event const& event)
+    {
+        // Events from other threads are checked when they are merged.
+        if (!on_dispatch_thread())
+        {
+            auto & staging = get_staging();
+            std::lock_guard<std::mutex> lock(staging.mutex);
+            staging.events.push_back(event);
+            return;
+        }
+#ifdef CHECKEVENTTYPE
+        check_event_type(event, "EventManager::enqueue()");
+#endif
+        push_event(event);
+    }
+
+    TimerId EventManager::impl::add_timer(Event const& event, sf::Time delay, sf::Time interval)
     {
 #ifdef CHECKEVENTTYPE
-        if (registered_events_.count(event) == 0)
-            throw EventException("EventManager::enqueue(): Tried to post an unregistered event.");
+        check_event_type(event, interval > sf::Time::Zero ? "EventManager::enqueue_every()" : "EventManager::enqueue_after()");
 #endif
-        event_queue_.push(std::move(event));
+        return timers_.add(event, delay, interval);
+    }
+
+    bool EventManager::impl::cancel_timer(TimerId id)
+    {
+        return timers_.cancel(id);
+    }
+
+    void EventManager::impl::advance_timers(sf::Time elapsed_time)
+    {
+        fired_events_.clear();
+        timers_.advance(elapsed_time, fired_events_);
+        for (auto const & event : fired_events_)
+            push_event(event);
+    }
+
+    void EventManager::impl::enqueue_payload(
+        Event const& event,
+        std::size_t size,
+        std::size_t alignment,
+        void const* payload,
+        void const* payload_type,
+        PayloadConstructor construct
+    ){
+        Event ev(event);
+        if (!on_dispatch_thread())
+        {
+            // Allocate and enqueue under the same lock, so the payload ends
+            // up in the arena that belongs to the events of this frame.
+            auto & staging = get_staging();
+            std::lock_guard<std::mutex> lock(staging.mutex);
+            auto p = staging.arenas[staging.current].allocate(size, alignment);
+            construct(p, payload);
+            attach_payload(ev, p, payload_type);
+            staging.events.push_back(ev);
+            return;
+        }
+        auto p = payload_arena_.allocate(size, alignment);
+        construct(p, payload);
+        attach_payload(ev, p, payload_type);
+        enqueue(ev);
     }
 
     void EventManager::impl::dispatch()
     {
-        // Erase all listeners that were destroyed.
-        for (auto & event_listeners : listeners_)
+        // Collect the events from the other threads.
+        dispatch_thread_.store(std::this_thread::get_id());
+        try
+        {
+            merge_staged_events();
+        }
+        catch (...)
+        {
+            finish_dispatch();
+            throw;
+        }
+#ifdef SFE_EVENT_STATS
+        if (stats_enabled_)
+            ++stats_dispatches_;
+#endif
+
+        // Notify the listeners on the events.
+        dispatching_ = true;
+        registry_->set_dispatching(true);
+        try
+        {
+            deliver_events();
+        }
+        catch (...)
+        {
+            finish_dispatch();
+            throw;
+        }
+        finish_dispatch();
+    }
+
+    void EventManager::impl::register_event(Event const& event)
+    {
+        registered_events_.insert(event);
+    }
+
+    void EventManager::impl::register_event(std::string const& name)
+    {
+        Event const event(name);
+        auto const it = event_names_.find(event);
+        if (it == event_names_.end())
+            event_names_.emplace(event, name);
+        else if (it->second != name)
+            throw EventException("EventManager::register_event(): The event names " + it->second + " and " + name + " have the same hash.");
+        registered_events_.insert(event);
+    }
+
+    std::size_t EventManager::impl::find_slot(Event const& event) const
+    {
+        auto const it = slot_indices_.find(event);
+        return it == slot_indices_.end() ? npos : it->second;
+    }
+
+    std::size_t EventManager::impl::get_slot(Event const& event)
+    {
+        // Look up first, because emplace() allocates a node even if the
+        // event already has a slot.
+        auto const index = find_slot(event);
+        if (index != npos)
+            return index;
+        slot_indices_.emplace(event, slots_.size());
+        slots_.emplace_back();
+        return slots_.size() - 1;
+    }
+
+    void EventManager::impl::push_event(Event const& event)
+    {
+#ifdef SFE_EVENT_STATS
+        if (stats_enabled_)
+            ++slots_[get_slot(event)].enqueued;
+#endif
+
+        // Only look up the slot if any event is coalesced.
+        if (coalescing_)
         {
-            auto & listener_vector = event_listeners.second;
-            auto const it = std::remove_if(
-                listener_vector.begin(),
-                listener_vector.end(),
-                [](std::weak_ptr<Listener> const& l)
+            auto const index = find_slot(event);
+            if (index != npos && slots_[index].policy != CoalescePolicy::None)
             {
-                return l.expired();
-            });
-            listener_vector.erase(it, listener_vector.end());
+                auto & slot = slots_[index];
+                if (slot.waiting != npos)
+                {
+                    if (slot.policy == CoalescePolicy::KeepLast)
+                        event_queue_[slot.waiting] = event;
+                    else if (slot.policy == CoalescePolicy::Count && slot.count)
+                        ++slot.count->count;
+                    return;
+                }
+                slot.waiting = event_queue_.size();
+                slot.count = nullptr;
+                if (slot.policy == CoalescePolicy::Count)
+                {
+                    Event ev(event);
+                    slot.count = new (payload_arena_.allocate(sizeof(EventCount), alignof(EventCount))) EventCount{ 1 };
+                    attach_payload(ev, slot.count, &detail::PayloadType<EventCount>::id);
+                    event_queue_.push_back(ev);
+                    return;
+                }
+            }
         }
+        event_queue_.push_back(event);
+    }
 
-        // Notify the listeners on the events
+    void EventManager::impl::deliver_events()
+    {
+        // The callbacks may add new listeners or events. New events are
+        // appended to the queue and delivered in this dispatch. New listeners
+        // are added after the current event was delivered, so the listener
+        // lists are never changed while iterating over them. Registering a
+        // listener may add a slot, so no slot reference is held across the
+        // callbacks.
         while (!event_queue_.empty())
         {
-            auto const& ev = event_queue_.front();
+            for (std::size_t i = 0; i < event_queue_.size(); ++i)
+            {
+                auto const ev = event_queue_[i];
+                auto const index = find_slot(ev);
+                if (index != npos)
+                {
+                    auto const list = static_cast<std::uint32_t>(index);
+                    if (slots_[index].waiting == i)
+                        slots_[index].waiting = npos;
+#ifdef SFE_EVENT_STATS
+                    if (stats_enabled_)
+                        ++slots_[index].delivered;
+#endif
+                    registry_->notify(list, ev);
+                    if (registry_->has_batch_listeners(list))
+                    {
+                        auto & slot = slots_[index];
+                        if (slot.batch.empty())
+                            batched_slots_.push_back(index);
+                        slot.batch.push_back(ev);
+                    }
+                }
+                registry_->add_pending();
+            }
+#ifdef SFE_EVENT_STATS
+            if (stats_enabled_)
+                peak_queue_depth_ = std::max(peak_queue_depth_, event_queue_.size());
+#endif
+            event_queue_.clear();
+
+            // Hand the collected events to the batch listeners. Events that are
+            // enqueued in the batch callbacks are delivered in the next round.
+            for (auto const index : batched_slots_)
+            {
+                auto const& batch = slots_[index].batch;
+                registry_->notify(static_cast<std::uint32_t>(index), EventSpan(batch.data(), batch.size()));
+                slots_[index].batch.clear();
+                registry_->add_pending();
+            }
+            batched_slots_.clear();
+        }
+    }
+
+    void EventManager::impl::finish_dispatch()
+    {
+        dispatching_ = false;
+        registry_->set_dispatching(false);
+        event_queue_.clear();
+        for (auto const index : batched_slots_)
+            slots_[index].batch.clear();
+        batched_slots_.clear();
+        if (coalescing_)
+            for (auto & slot : slots_)
+                slot.waiting = npos;
+        payload_arena_.reset();
+    }
+
+    bool EventManager::impl::on_dispatch_thread() const
+    {
+        return std::this_thread::get_id() == dispatch_thread_.load(std::memory_order_relaxed);
+    }
+
+    EventManager::impl::Staging & EventManager::impl::get_staging()
+    {
+        // Most threads only post to one event manager, so the last used
+        // staging buffer is cached.
+        thread_local std::uint64_t cached_id = 0;
+        thread_local Staging* cached_staging = nullptr;
+        if (cached_id == id_)
+            return *cached_staging;
+
+        // Releases the staging buffers of the thread when it exits. The
+        // buffers may outlive their event manager until then.
+        struct OwnedStagings
+        {
+            ~OwnedStagings()
+            {
+                for (auto const & w : stagings)
+                    if (auto s = w.lock())
+                        s->thread.store(std::thread::id(), std::memory_order_release);
+            }
+
+            std::vector<std::weak_ptr<Staging>> stagings;
+        };
+        thread_local OwnedStagings owned;
+
+        std::lock_guard<std::mutex> lock(staging_mutex_);
+        auto const thread = std::this_thread::get_id();
+        auto it = std::find_if(staging_.begin(), staging_.end(), [thread](auto && s) {
+            return s->thread.load(std::memory_order_acquire) == thread;
+        });
+        if (it == staging_.end())
+        {
+            // Reuse a released buffer. Its pending events are merged as
+            // usual, since the order of the events of one thread is kept.
+            it = std::find_if(staging_.begin(), staging_.end(), [](auto && s) {
+                return s->thread.load(std::memory_order_acquire) == std::thread::id();
+            });
+            if (it == staging_.end())
+            {
+                staging_.push_back(std::make_shared<Staging>());
+                it = staging_.end() - 1;
+            }
+            (*it)->thread.store(thread, std::memory_order_release);
+            owned.stagings.erase(std::remove_if(owned.stagings.begin(), owned.stagings.end(), [](auto && w) {
+                return w.expired();
+            }), owned.stagings.end());
+            owned.stagings.push_back(*it);
+        }
+        cached_id = id_;
+        cached_staging = it->get();
+        return *cached_staging;
+    }
 
-            // Iterate over a copy because the callbacks may add new listeners,
-            // and we do not want to change a container while iterating.
-            auto event_listeners = listeners_[ev];
-            for (auto const& l : event_listeners)
+    void EventManager::impl::merge_staged_events()
+    {
+        // All buffers are merged even if an event is unregistered, so
+        // the flipped arenas stay in sync with the queue. Unregistered
+        // events are dropped and reported after the merge.
+        bool unregistered = false;
+        Event first_unregistered("");
+        {
+            std::lock_guard<std::mutex> registry_lock(staging_mutex_);
+            for (auto & staging : staging_)
             {
-                if (auto s = l.lock())
+                std::lock_guard<std::mutex> lock(staging->mutex);
+                for (auto const& ev : staging->events)
                 {
-                    s->notify(ev);
+#ifdef CHECKEVENTTYPE
+                    if (registered_events_.count(ev) == 0)
+                    {
+                        if (!unregistered)
+                            first_unregistered = ev;
+                        unregistered = true;
+                        continue;
+                    }
+#endif
+                    push_event(ev);
                 }
+                staging->events.clear();
+
+                // The merged payloads stay valid until the next merge. Until
+                // then, the thread writes its payloads to the other arena.
+                staging->current = 1 - staging->current;
+                staging->arenas[staging->current].reset();
             }
-            event_queue_.pop();
         }
+        if (unregistered)
+            check_event_type(first_unregistered, "EventManager::enqueue()");
     }
 
-    void EventManager::impl::register_event(Event const& event)
+    void EventManager::impl::check_event_type(Event const& event, char const* caller) const
     {
-        registered_events_.insert(event);
+        if (registered_events_.count(event) == 0)
+            throw EventException(std::string(caller) + ": Tried to use the unregistered event " + get_event_name(event) + ".");
+    }
+
+    void EventManager::impl::set_stats_enabled(bool enabled)
+    {
+#ifdef SFE_EVENT_STATS
+        stats_enabled_ = enabled;
+        registry_->set_timing(enabled);
+#endif
+    }
+
+    bool EventManager::impl::get_stats_enabled() const
+    {
+        return stats_enabled_;
+    }
+
+    EventManagerStats EventManager::impl::get_stats() const
+    {
+        EventManagerStats stats;
+        stats.dispatches = stats_dispatches_;
+        stats.peak_queue_depth = peak_queue_depth_;
+        for (auto const& p : slot_indices_)
+        {
+            auto const& slot = slots_[p.second];
+            auto const name = get_event_name(p.first);
+            if (slot.enqueued > 0 || slot.delivered > 0)
+                stats.events.push_back(EventTypeStats{ p.first.get_id(), name, slot.enqueued, slot.delivered });
+            auto const begin = stats.listeners.size();
+            registry_->collect_stats(static_cast<std::uint32_t>(p.second), stats.listeners);
+            for (auto i = begin; i < stats.listeners.size(); ++i)
+            {
+                stats.listeners[i].event_id = p.first.get_id();
+                stats.listeners[i].event_name = name;
+            }
+        }
+
+        // Put the most frequent events and the most expensive listeners first.
+        std::sort(stats.events.begin(), stats.events.end(), [](auto && a, auto && b) {
+            return a.enqueued > b.enqueued;
+        });
+        std::sort(stats.listeners.begin(), stats.listeners.end(), [](auto && a, auto && b) {
+            return a.total_ns > b.total_ns;
+        });
+        return stats;
+    }
+
+    void EventManager::impl::reset_stats()
+    {
+        for (auto & slot : slots_)
+        {
+            slot.enqueued = 0;
+            slot.delivered = 0;
+        }
+        registry_->reset_stats();
+        stats_dispatches_ = 0;
+        peak_queue_depth_ = 0;
+    }
+
+    std::string EventManager::impl::get_event_name(Event const& event) const
+    {
+        auto const it = event_names_.find(event);
+        if (it != event_names_.end())
+            return it->second;
+        std::ostringstream ss;
+        ss << "0x" << std::hex << std::setw(16) << std::setfill('0') << event.get_id();
+        return ss.str();
     }
 
 } // namespace sfe
@@ -0,0 +1,92 @@
+#include <SFE/event_stats.hxx>
+#include <SFE/utility.hxx>
+
+#include <iomanip>
+#include <ostream>
+
+namespace sfe
+{
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// Write the event id as fixed-width hexadecimal number.
+        ////////////////////////////////////////////////////////////
+        void write_id(std::ostream & out, std::uint64_t id)
+        {
+            auto const flags = out.flags();
+            auto const fill = out.fill('0');
+            out << "0x" << std::hex << std::setw(16) << id;
+            out.flags(flags);
+            out.fill(fill);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Write the string as quoted CSV field.
+        ////////////////////////////////////////////////////////////
+        void write_csv_string(std::ostream & out, std::string const & s)
+        {
+            out << '"';
+            for (auto c : s)
+            {
+                if (c == '"')
+                    out << '"';
+                out << c;
+            }
+            out << '"';
+        }
+    }
+
+    void EventManagerStats::write_csv(std::ostream & out) const
+    {
+        out << "kind,event_id,event_name,listener,enqueued,delivered,calls,total_ns,max_ns\n";
+        for (auto const & e : events)
+        {
+            out << "event,";
+            write_id(out, e.event_id);
+            out << ',';
+            write_csv_string(out, e.name);
+            out << ",," << e.enqueued << ',' << e.delivered << ",,,\n";
+        }
+        for (auto const & l : listeners)
+        {
+            out << (l.batch ? "batch_listener," : "listener,");
+            write_id(out, l.event_id);
+            out << ',';
+            write_csv_string(out, l.event_name);
+            out << ',' << l.listener_id << ",,," << l.calls << ',' << l.total_ns << ',' << l.max_ns << '\n';
+        }
+    }
+
+    void EventManagerStats::write_json(std::ostream & out) const
+    {
+        out << "{\"dispatches\":" << dispatches
+            << ",\"peak_queue_depth\":" << peak_queue_depth
+            << ",\"events\":[";
+        for (std::size_t i = 0; i < events.size(); ++i)
+        {
+            auto const & e = events[i];
+            out << (i == 0 ? "" : ",") << "{\"id\":\"";
+            write_id(out, e.event_id);
+            out << "\",\"name\":";
+            write_json_string(out, e.name);
+            out << ",\"enqueued\":" << e.enqueued
+                << ",\"delivered\":" << e.delivered << '}';
+        }
+        out << "],\"listeners\":[";
+        for (std::size_t i = 0; i < listeners.size(); ++i)
+        {
+            auto const & l = listeners[i];
+            out << (i == 0 ? "" : ",") << "{\"event_id\":\"";
+            write_id(out, l.event_id);
+            out << "\",\"event_name\":";
+            write_json_string(out, l.event_name);
+            out << ",\"listener\":" << l.listener_id
+                << ",\"batch\":" << (l.batch ? "true" : "false")
+                << ",\"calls\":" << l.calls
+                << ",\"total_ns\":" << l.total_ns
+                << ",\"max_ns\":" << l.max_ns << '}';
+        }
+        out << "]}";
+    }
+
+} // namespace sfe
@@ -1,9 +1,18 @@
 #include <SFE/game.hxx>
 #include <SFE/event_manager.hxx>
 #include <SFE/input.hxx>
+#include <SFE/profiler.hxx>
+#include <SFE/render_commands.hxx>
 #include <SFE/resource_manager.hxx>
 #include <SFE/screen.hxx>
 
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 namespace sfe
 {
     class Game::impl
@@ -18,12 +27,47 @@ namespace sfe
             sf::Uint32 const style = sf::Style::Default
         );
 
+        impl(
+            Game & game,
+            unsigned int const width,
+            unsigned int const height,
+            GameBackend const backend
+        );
+
         void run();
 
+        void quit();
+
+        GameBackend get_backend() const;
+
+        sf::Time get_frame_time() const;
+
+        void set_frame_time(sf::Time const& frame_time);
+
+        std::size_t get_max_frames() const;
+
+        void set_max_frames(std::size_t max_frames);
+
+        std::size_t get_frame_count() const;
+
+        unsigned int get_tick_rate() const;
+
+        void set_tick_rate(unsigned int tick_rate);
+
+        unsigned int get_max_ticks() const;
+
+        void set_max_ticks(unsigned int max_ticks);
+
+        bool get_render_thread() const;
+
+        void set_render_thread(bool b);
+
         sf::RenderWindow & get_window();
 
         sf::RenderWindow const& get_window() const;
 
+        sf::RenderTexture & get_render_texture();
+
         void load_screen(
             std::unique_ptr<Screen> new_screen,
             bool const change_to_default_view
@@ -35,6 +79,61 @@ namespace sfe
 
     private:
 
+        ////////////////////////////////////////////////////////////
+        /// Advance the simulation by the given time.
+        ////////////////////////////////////////////////////////////
+        void tick(sf::Time elapsed_time);
+
+        ////////////////////////////////////////////////////////////
+        /// Run the main loop.
+        ////////////////////////////////////////////////////////////
+        void loop();
+
+        ////////////////////////////////////////////////////////////
+        /// Return the window or the texture, or nullptr for the
+        /// Null backend.
+        ////////////////////////////////////////////////////////////
+        sf::RenderTarget * get_target();
+
+        ////////////////////////////////////////////////////////////
+        /// Activate or deactivate the context of the target on the
+        /// calling thread.
+        ////////////////////////////////////////////////////////////
+        void set_target_active(bool active);
+
+        ////////////////////////////////////////////////////////////
+        /// Show what was drawn to the target.
+        ////////////////////////////////////////////////////////////
+        void display();
+
+        ////////////////////////////////////////////////////////////
+        /// Start the render thread and give it the target.
+        ////////////////////////////////////////////////////////////
+        void start_render_thread();
+
+        ////////////////////////////////////////////////////////////
+        /// Let the render thread finish its frame, stop it and take
+        /// the target back.
+        ////////////////////////////////////////////////////////////
+        void stop_render_thread();
+
+        ////////////////////////////////////////////////////////////
+        /// The loop of the render thread.
+        ////////////////////////////////////////////////////////////
+        void render_loop();
+
+        ////////////////////////////////////////////////////////////
+        /// Wait until the render thread has drawn the last frame.
+        /// Rethrow the exception if drawing failed.
+        ////////////////////////////////////////////////////////////
+        void wait_for_render();
+
+        ////////////////////////////////////////////////////////////
+        /// Wait for the last frame and hand the commands to the
+        /// render thread.
+        ////////////////////////////////////////////////////////////
+        void submit_frame(RenderCommands & commands);
+
         ////////////////////////////////////////////////////////////
         /// Reference to the actual game.
         ////////////////////////////////////////////////////////////
@@ -52,15 +151,113 @@ namespace sfe
         std::unique_ptr<Screen> requested_screen_;
 
         ////////////////////////////////////////////////////////////
-        /// The render window.
+        /// The backend.
+        ////////////////////////////////////////////////////////////
+        GameBackend backend_;
+
+        ////////////////////////////////////////////////////////////
+        /// The viewport size.
         ////////////////////////////////////////////////////////////
-        sf::RenderWindow window_;
+        sf::Vector2u size_;
+
+        ////////////////////////////////////////////////////////////
+        /// The render window of the Window backend.
+        ////////////////////////////////////////////////////////////
+        std::unique_ptr<sf::RenderWindow> window_;
+
+        ////////////////////////////////////////////////////////////
+        /// The render texture of the Offscreen backend.
+        ////////////////////////////////////////////////////////////
+        std::unique_ptr<sf::RenderTexture> texture_;
 
         ////////////////////////////////////////////////////////////
         /// The clock that measures the elapsed time per frame.
         ////////////////////////////////////////////////////////////
         sf::Clock clock_;
 
+        ////////////////////////////////////////////////////////////
+        /// The synthetic frame time or zero.
+        ////////////////////////////////////////////////////////////
+        sf::Time frame_time_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the main loop keeps running.
+        ////////////////////////////////////////////////////////////
+        bool running_;
+
+        ////////////////////////////////////////////////////////////
+        /// The maximum number of frames or 0.
+        ////////////////////////////////////////////////////////////
+        std::size_t max_frames_;
+
+        ////////////////////////////////////////////////////////////
+        /// The number of frames since run() was called.
+        ////////////////////////////////////////////////////////////
+        std::size_t frame_count_;
+
+        ////////////////////////////////////////////////////////////
+        /// The fixed ticks per second or 0.
+        ////////////////////////////////////////////////////////////
+        unsigned int tick_rate_;
+
+        ////////////////////////////////////////////////////////////
+        /// The maximum number of ticks per frame.
+        ////////////////////////////////////////////////////////////
+        unsigned int max_ticks_;
+
+        ////////////////////////////////////////////////////////////
+        /// The elapsed time that was not simulated yet.
+        ////////////////////////////////////////////////////////////
+        sf::Time accumulator_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether a tick saw the input since it was reset.
+        ////////////////////////////////////////////////////////////
+        bool input_consumed_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the game renders on a separate thread.
+        ////////////////////////////////////////////////////////////
+        bool use_render_thread_;
+
+        ////////////////////////////////////////////////////////////
+        /// The render commands. One is recorded while the render
+        /// thread draws the other.
+        ////////////////////////////////////////////////////////////
+        std::array<RenderCommands, 2> commands_;
+
+        ////////////////////////////////////////////////////////////
+        /// The index of the commands that are recorded next.
+        ////////////////////////////////////////////////////////////
+        std::size_t next_commands_;
+
+        ////////////////////////////////////////////////////////////
+        /// The render thread.
+        ////////////////////////////////////////////////////////////
+        std::thread render_thread_;
+
+        ////////////////////////////////////////////////////////////
+        /// Guards the members below. render_changed_ is notified
+        /// when a frame is submitted, drawn or the thread stops.
+        ////////////////////////////////////////////////////////////
+        std::mutex render_mutex_;
+        std::condition_variable render_changed_;
+
+        ////////////////////////////////////////////////////////////
+        /// The commands that the render thread draws or nullptr.
+        ////////////////////////////////////////////////////////////
+        RenderCommands * render_frame_;
+
+        ////////////////////////////////////////////////////////////
+        /// Whether the render thread should stop.
+        ////////////////////////////////////////////////////////////
+        bool render_stop_;
+
+        ////////////////////////////////////////////////////////////
+        /// The exception of the render thread.
+        ////////////////////////////////////////////////////////////
+        std::exception_ptr render_error_;
+
         ////////////////////////////////////////////////////////////
         /// The event manager.
         ////////////////////////////////////////////////////////////
@@ -82,6 +279,14 @@ namespace sfe
         impl_{ std::make_unique<impl>(*this, width, height, title, style) }
     {}
 
+    Game::Game(
+        unsigned int const width,
+        unsigned int const height,
+        GameBackend const backend
+    )   :
+        impl_{ std::make_unique<impl>(*this, width, height, backend) }
+    {}
+
     Game::~Game() = default;
 
     void Game::run()
@@ -89,6 +294,71 @@ namespace sfe
         impl_->run();
     }
 
+    void Game::quit()
+    {
+        impl_->quit();
+    }
+
+    GameBackend Game::get_backend() const
+    {
+        return impl_->get_backend();
+    }
+
+    sf::Time Game::get_frame_time() const
+    {
+        return impl_->get_frame_time();
+    }
+
+    void Game::set_frame_time(sf::Time const& frame_time)
+    {
+        impl_->set_frame_time(frame_time);
+    }
+
+    std::size_t Game::get_max_frames() const
+    {
+        return impl_->get_max_frames();
+    }
+
+    void Game::set_max_frames(std::size_t max_frames)
+    {
+        impl_->set_max_frames(max_frames);
+    }
+
+    std::size_t Game::get_frame_count() const
+    {
+        return impl_->get_frame_count();
+    }
+
+    unsigned int Game::get_tick_rate() const
+    {
+        return impl_->get_tick_rate();
+    }
+
+    void Game::set_tick_rate(unsigned int tick_rate)
+    {
+        impl_->set_tick_rate(tick_rate);
+    }
+
+    unsigned int Game::get_max_ticks() const
+    {
+        return impl_->get_max_ticks();
+    }
+
+    void Game::set_max_ticks(unsigned int max_ticks)
+    {
+        impl_->set_max_ticks(max_ticks);
+    }
+
+    bool Game::get_render_thread() const
+    {
+        return impl_->get_render_thread();
+    }
+
+    void Game::set_render_thread(bool b)
+    {
+        impl_->set_render_thread(b);
+    }
+
     sf::RenderWindow & Game::get_window()
     {
         return impl_->get_window();
@@ -99,6 +369,11 @@ namespace sfe
         return impl_->get_window();
     }
 
+    sf::RenderTexture & Game::get_render_texture()
+    {
+        return impl_->get_render_texture();
+    }
+
     void Game::load_screen(
         std::unique_ptr<Screen> new_screen,
         bool const change_to_default_view
@@ -124,11 +399,62 @@ namespace sfe
         sf::Uint32 const style
     )   :
         game_(game),
-        window_(sf::VideoMode(width, height), title, style),
+        backend_(GameBackend::Window),
+        size_(width, height),
+        window_(std::make_unique<sf::RenderWindow>(sf::VideoMode(width, height), title, style)),
+        running_(false),
+        max_frames_(0),
+        frame_count_(0),
+        tick_rate_(0),
+        max_ticks_(5),
+        input_consumed_(true),
+        use_render_thread_(false),
+        next_commands_(0),
+        render_frame_(nullptr),
+        render_stop_(false),
         event_manager_(std::make_shared<EventManager>()),
         resource_manager_(std::make_shared<ResourceManager>())
     {}
 
+    Game::impl::impl(
+        Game & game,
+        unsigned int const width,
+        unsigned int const height,
+        GameBackend const backend
+    )   :
+        game_(game),
+        backend_(backend),
+        size_(width, height),
+        running_(false),
+        max_frames_(0),
+        frame_count_(0),
+        tick_rate_(0),
+        max_ticks_(5),
+        input_consumed_(true),
+        use_render_thread_(false),
+        next_commands_(0),
+        render_frame_(nullptr),
+        render_stop_(false),
+        event_manager_(std::make_shared<EventManager>()),
+        resource_manager_(std::make_shared<ResourceManager>())
+    {
+        if (backend_ == GameBackend::Window)
+        {
+            window_ = std::make_unique<sf::RenderWindow>(sf::VideoMode(width, height), "");
+        }
+        else
+        {
+            // Headless games are not tied to the wall clock.
+            frame_time_ = sf::seconds(1.0f / 60.0f);
+            if (backend_ == GameBackend::Offscreen)
+            {
+                texture_ = std::make_unique<sf::RenderTexture>();
+                if (!texture_->create(width, height))
+                    throw GameException("Game::Game(): Could not create the render texture.");
+            }
+        }
+    }
+
     void Game::impl::run()
     {
         // Initialize the components.
@@ -142,54 +468,350 @@ namespace sfe
         if (screen_->init_)
             screen_->init_();
 
-        // Run the main loop.
+        // Without a window, nothing else sets the viewport ratio.
+        if (!window_)
+            Widget::viewport_ratio = size_.x / static_cast<float>(size_.y);
+
+        // Run the main loop. The render thread must be stopped
+        // before the target is destroyed, also after an exception.
+        if (use_render_thread_ && get_target())
+            start_render_thread();
+        try
+        {
+            loop();
+        }
+        catch (...)
+        {
+            stop_render_thread();
+            throw;
+        }
+        stop_render_thread();
+    }
+
+    void Game::impl::loop()
+    {
+        SFE_PROFILE_THREAD("main");
         clock_.restart();
-        while (window_.isOpen())
+        running_ = true;
+        frame_count_ = 0;
+        while (running_ && (max_frames_ == 0 || frame_count_ < max_frames_))
         {
-            // Load the next screen.
+            SFE_PROFILE_ZONE("Game::frame");
+
+            // Load the next screen. The last frame may still use the
+            // textures of the old screen.
             if (requested_screen_)
+            {
+                wait_for_render();
                 screen_ = std::move(requested_screen_);
+            }
 
-            // Process window events.
-            sfe::Input::global().reset();
-            sf::Event event;
-            while (window_.pollEvent(event))
+            // Process window events. Presses stay pending until a tick
+            // has seen them.
+            if (input_consumed_)
             {
-                if (event.type == sf::Event::Closed)
-                    window_.close();
-                else if (event.type == sf::Event::KeyPressed)
-                    sfe::Input::global().press(event.key.code);
-                else if (event.type == sf::Event::MouseButtonPressed)
-                    sfe::Input::global().press(event.mouseButton.button);
+                SFE_PROFILE_ZONE("Input::reset");
+                sfe::Input::global().reset();
+                input_consumed_ = false;
+            }
+            if (window_)
+            {
+                SFE_PROFILE_ZONE("Game::poll_events");
+                sf::Event event;
+                while (window_->pollEvent(event))
+                {
+                    if (event.type == sf::Event::Closed)
+                    {
+                        stop_render_thread();
+                        window_->close();
+                    }
+                    else if (event.type == sf::Event::KeyPressed)
+                        sfe::Input::global().press(event.key.code);
+                    else if (event.type == sf::Event::MouseButtonPressed)
+                        sfe::Input::global().press(event.mouseButton.button);
+                }
+                if (!window_->isOpen())
+                    break;
             }
-            if (!window_.isOpen())
-                break;
 
-            // Update the screen.
             auto elapsed_time = clock_.restart();
-            screen_->update(window_, elapsed_time);
+            if (frame_time_ != sf::Time::Zero)
+                elapsed_time = frame_time_;
+            if (tick_rate_ == 0)
+            {
+                screen_->set_interpolation(1);
+                tick(elapsed_time);
+            }
+            else
+            {
+                // Run the ticks that are due and drop the time that
+                // is left after max_ticks_.
+                auto const step = sf::seconds(1.0f / tick_rate_);
+                accumulator_ += elapsed_time;
+                for (unsigned int i = 0; i < max_ticks_ && accumulator_ >= step; ++i)
+                {
+                    // Later ticks of the frame must not see the same
+                    // presses again.
+                    if (i > 0)
+                        sfe::Input::global().reset();
+                    screen_->store_transforms();
+                    tick(step);
+                    accumulator_ -= step;
+                }
+                if (accumulator_ >= step)
+                    accumulator_ = sf::Time::Zero;
+
+                // Render between the last two ticks.
+                screen_->set_interpolation(accumulator_ / step);
+            }
 
-            // Call the concrete update method.
-            game_.update_impl(elapsed_time);
+            // Draw the screen or let the render thread draw it while
+            // the next frame is updated.
+            if (render_thread_.joinable())
+            {
+                auto & commands = commands_[next_commands_];
+                next_commands_ = 1 - next_commands_;
+                commands.clear();
+                {
+                    SFE_PROFILE_ZONE("Screen::render");
+                    screen_->render(commands);
+                }
+                SFE_PROFILE_ZONE("Game::submit_frame");
+                submit_frame(commands);
+            }
+            else if (auto const target = get_target())
+            {
+                target->clear();
+                {
+                    SFE_PROFILE_ZONE("Screen::render");
+                    screen_->render(*target);
+                }
+                SFE_PROFILE_ZONE("Game::display");
+                display();
+            }
+            ++frame_count_;
+            SFE_PROFILE_FRAME();
+        }
+    }
+
+    sf::RenderTarget * Game::impl::get_target()
+    {
+        if (window_)
+            return window_.get();
+        return texture_.get();
+    }
+
+    void Game::impl::set_target_active(bool active)
+    {
+        if (window_)
+            window_->setActive(active);
+        else if (texture_)
+            texture_->setActive(active);
+    }
+
+    void Game::impl::display()
+    {
+        if (window_)
+            window_->display();
+        else if (texture_)
+            texture_->display();
+    }
+
+    void Game::impl::start_render_thread()
+    {
+        render_stop_ = false;
+        render_error_ = nullptr;
+        set_target_active(false);
+        render_thread_ = std::thread([this]() { render_loop(); });
+    }
+
+    void Game::impl::stop_render_thread()
+    {
+        if (!render_thread_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(render_mutex_);
+            render_stop_ = true;
+        }
+        render_changed_.notify_all();
+        render_thread_.join();
+        set_target_active(true);
+    }
+
+    void Game::impl::render_loop()
+    {
+        SFE_PROFILE_THREAD("render");
+        set_target_active(true);
+        std::unique_lock<std::mutex> lock(render_mutex_);
+        while (true)
+        {
+            // Draw the pending frame before stopping.
+            render_changed_.wait(lock, [this]() { return render_frame_ || render_stop_; });
+            if (!render_frame_)
+                break;
+            auto const frame = render_frame_;
+            lock.unlock();
+            std::exception_ptr error;
+            try
+            {
+                SFE_PROFILE_ZONE("Game::render_frame");
+                auto & target = *get_target();
+                target.clear();
+                frame->execute(target);
+                display();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+            if (error && !render_error_)
+                render_error_ = error;
+            render_frame_ = nullptr;
+            render_changed_.notify_all();
+        }
+        set_target_active(false);
+    }
+
+    void Game::impl::wait_for_render()
+    {
+        std::unique_lock<std::mutex> lock(render_mutex_);
+        render_changed_.wait(lock, [this]() { return !render_frame_; });
+        if (render_error_)
+        {
+            auto const error = render_error_;
+            render_error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    void Game::impl::submit_frame(RenderCommands & commands)
+    {
+        wait_for_render();
+        {
+            std::lock_guard<std::mutex> lock(render_mutex_);
+            render_frame_ = &commands;
+        }
+        render_changed_.notify_all();
+    }
+
+    void Game::impl::tick(sf::Time elapsed_time)
+    {
+        input_consumed_ = true;
 
-            // Handle all events.
-            event_manager_->dispatch();
+        SFE_PROFILE_ZONE("Game::tick");
+
+        // Update the screen. Only a window has user input.
+        {
+            SFE_PROFILE_ZONE("Screen::update");
+            if (window_)
+                screen_->update(*window_, elapsed_time);
+            else
+                screen_->update(elapsed_time);
+        }
+
+        // Call the concrete update method.
+        {
+            SFE_PROFILE_ZONE("Game::update_impl");
+            game_.update_impl(elapsed_time);
+        }
 
-            // Draw the screen.
-            window_.clear();
-            screen_->render(window_);
-            window_.display();
+        // Enqueue the events of the timers that are due.
+        {
+            SFE_PROFILE_ZONE("EventManager::advance_timers");
+            event_manager_->advance_timers(elapsed_time);
         }
+
+        // Handle all events.
+        SFE_PROFILE_ZONE("EventManager::dispatch");
+        event_manager_->dispatch();
+    }
+
+    void Game::impl::quit()
+    {
+        running_ = false;
+    }
+
+    GameBackend Game::impl::get_backend() const
+    {
+        return backend_;
+    }
+
+    sf::Time Game::impl::get_frame_time() const
+    {
+        return frame_time_;
+    }
+
+    void Game::impl::set_frame_time(sf::Time const& frame_time)
+    {
+        frame_time_ = frame_time;
+    }
+
+    std::size_t Game::impl::get_max_frames() const
+    {
+        return max_frames_;
+    }
+
+    void Game::impl::set_max_frames(std::size_t max_frames)
+    {
+        max_frames_ = max_frames;
+    }
+
+    std::size_t Game::impl::get_frame_count() const
+    {
+        return frame_count_;
+    }
+
+    unsigned int Game::impl::get_tick_rate() const
+    {
+        return tick_rate_;
+    }
+
+    void Game::impl::set_tick_rate(unsigned int tick_rate)
+    {
+        tick_rate_ = tick_rate;
+        accumulator_ = sf::Time::Zero;
+    }
+
+    bool Game::impl::get_render_thread() const
+    {
+        return use_render_thread_;
+    }
+
+    void Game::impl::set_render_thread(bool b)
+    {
+        use_render_thread_ = b;
+    }
+
+    unsigned int Game::impl::get_max_ticks() const
+    {
+        return max_ticks_;
+    }
+
+    void Game::impl::set_max_ticks(unsigned int max_ticks)
+    {
+        max_ticks_ = std::max(max_ticks, 1u);
     }
 
     sf::RenderWindow & Game::impl::get_window()
     {
-        return window_;
+        if (!window_)
+            throw GameException("Game::get_window(): The game has no window.");
+        return *window_;
     }
 
     sf::RenderWindow const & Game::impl::get_window() const
     {
-        return window_;
+        if (!window_)
+            throw GameException("Game::get_window(): The game has no window.");
+        return *window_;
+    }
+
+    sf::RenderTexture & Game::impl::get_render_texture()
+    {
+        if (!texture_)
+            throw GameException("Game::get_render_texture(): The game does not render offscreen.");
+        return *texture_;
     }
 
     void Game::impl::load_screen(
@@ -199,7 +821,7 @@ namespace sfe
         requested_screen_ = std::move(new_screen);
         if (change_to_default_view)
         {
-            float const ratio = window_.getSize().x / static_cast<float>(window_.getSize().y);
+            float const ratio = size_.x / static_cast<float>(size_.y);
             requested_screen_->set_game_view(sf::View({ -ratio, -1, 2 * ratio, 2 }));
         }
     }
@@ -1,16 +1,112 @@
 #include <SFE/game_object.hxx>
+#include <SFE/game.hxx>
+#include <SFE/object_pool.hxx>
+#include <SFE/screen.hxx>
+
+#include <cmath>
 
 namespace sfe
 {
+    GameObjectHandle::GameObjectHandle()
+        :
+        id_(0)
+    {}
+
+    GameObjectHandle::GameObjectHandle(std::uint64_t id)
+        :
+        id_(id)
+    {}
+
+    std::uint64_t GameObjectHandle::get_id() const
+    {
+        return id_;
+    }
+
+    GameObjectHandle::operator bool() const
+    {
+        return id_ != 0;
+    }
+
+    bool GameObjectHandle::operator==(GameObjectHandle const & other) const
+    {
+        return id_ == other.id_;
+    }
+
+    bool GameObjectHandle::operator!=(GameObjectHandle const & other) const
+    {
+        return id_ != other.id_;
+    }
+
     GameObject::GameObject()
         :
         position_({ 0, 0 }),
         size_({ 1, 1 }),
         rotation_(0),
+        previous_position_({ 0, 0 }),
+        previous_rotation_(0),
+        previous_stored_(false),
         z_index_(0),
-        visible_(true)
+        visible_(true),
+        parallel_update_(false),
+        z_index_changed_(false),
+        bounds_changed_(false),
+        mouseover_(false),
+        cull_stamp_(0),
+        screen_(nullptr)
     {}
 
+    GameObject::GameObject(GameObject const& other)
+        :
+        position_(other.position_),
+        size_(other.size_),
+        rotation_(other.rotation_),
+        previous_position_(other.position_),
+        previous_rotation_(other.rotation_),
+        previous_stored_(false),
+        z_index_(other.z_index_),
+        visible_(other.visible_),
+        parallel_update_(other.parallel_update_),
+        z_index_changed_(false),
+        bounds_changed_(false),
+        mouseover_(false),
+        cull_stamp_(0),
+        screen_(nullptr)
+    {}
+
+    void* GameObject::operator new(std::size_t size)
+    {
+        return ObjectPool::global().allocate(size);
+    }
+
+    void GameObject::operator delete(void* p, std::size_t size)
+    {
+        ObjectPool::global().deallocate(p, size);
+    }
+
+#ifdef __cpp_aligned_new
+    void* GameObject::operator new(std::size_t size, std::align_val_t alignment)
+    {
+        return ::operator new(size, alignment);
+    }
+
+    void GameObject::operator delete(void* p, std::size_t size, std::align_val_t alignment)
+    {
+        ::operator delete(p, size, alignment);
+    }
+#endif
+
+    GameObject & GameObject::operator=(GameObject const& other)
+    {
+        position_ = other.position_;
+        size_ = other.size_;
+        rotation_ = other.rotation_;
+        set_z_index(other.z_index_);
+        visible_ = other.visible_;
+        parallel_update_ = other.parallel_update_;
+        bounds_changed();
+        return *this;
+    }
+
     void GameObject::update(sf::Time elapsed_time)
     {}
 
@@ -20,6 +116,20 @@ namespace sfe
             render_impl(target);
     }
 
+    void GameObject::render(SpriteBatch & batch) const
+    {
+        if (visible_)
+            render_batch_impl(batch);
+    }
+
+    void GameObject::render_batch_impl(SpriteBatch & batch) const
+    {
+        if (batch.is_recording())
+            throw GameException("GameObject::render_batch_impl(): The object cannot be recorded for the render thread. Override render_batch_impl().");
+        batch.flush();
+        render_impl(batch.get_target());
+    }
+
     sf::Vector2f const & GameObject::get_position() const
     {
         return position_;
@@ -28,12 +138,14 @@ namespace sfe
     void GameObject::set_position(sf::Vector2f const & position)
     {
         position_ = position;
+        bounds_changed();
     }
 
     void GameObject::set_position(float x, float y)
     {
         position_.x = x;
         position_.y = y;
+        bounds_changed();
     }
 
     sf::Vector2f const & GameObject::get_size() const
@@ -44,12 +156,14 @@ namespace sfe
     void GameObject::set_size(sf::Vector2f const & size)
     {
         size_ = size;
+        bounds_changed();
     }
 
     void GameObject::set_size(float width, float height)
     {
         size_.x = width;
         size_.y = height;
+        bounds_changed();
     }
 
     float GameObject::get_rotation() const
@@ -60,11 +174,30 @@ namespace sfe
     void GameObject::set_rotation(float angle)
     {
         rotation_ = angle;
+        bounds_changed();
     }
 
     void GameObject::rotate(float angle)
     {
         rotation_ += angle;
+        bounds_changed();
+    }
+
+    sf::Vector2f GameObject::get_render_position() const
+    {
+        if (!screen_ || !previous_stored_ || screen_->interpolation_ >= 1)
+            return position_;
+        return previous_position_ + screen_->interpolation_ * (position_ - previous_position_);
+    }
+
+    float GameObject::get_render_rotation() const
+    {
+        if (!screen_ || !previous_stored_ || screen_->interpolation_ >= 1)
+            return rotation_;
+
+        // Turn the short way, e. g. from 350 to 10 degrees over 0.
+        auto const d = std::remainder(rotation_ - previous_rotation_, 360.0f);
+        return rotation_ - (1 - screen_->interpolation_) * d;
     }
 
     int GameObject::get_z_index() const
@@ -74,7 +207,12 @@ namespace sfe
 
     void GameObject::set_z_index(int z_index)
     {
+        if (z_index == z_index_)
+            return;
         z_index_ = z_index;
+        if (screen_ && !z_index_changed_)
+            screen_->order_changed(*this);
+        z_index_changed_ = true;
     }
 
     bool GameObject::get_visible() const
@@ -87,30 +225,122 @@ namespace sfe
         visible_ = b;
     }
 
+    bool GameObject::get_parallel_update() const
+    {
+        return parallel_update_;
+    }
+
+    void GameObject::set_parallel_update(bool b)
+    {
+        parallel_update_ = b;
+    }
+
+    sf::FloatRect GameObject::get_bounds() const
+    {
+        auto const angle = rotation_ * 3.14159265f / 180.0f;
+        auto const c = std::abs(std::cos(angle));
+        auto const s = std::abs(std::sin(angle));
+        auto const half_width = 0.5f * (c * size_.x + s * size_.y);
+        auto const half_height = 0.5f * (s * size_.x + c * size_.y);
+        return { position_.x - half_width, position_.y - half_height, 2 * half_width, 2 * half_height };
+    }
+
+    bool GameObject::contains(sf::Vector2f const & point) const
+    {
+        // Rotate the point into the frame of the object.
+        auto const angle = rotation_ * 3.14159265f / 180.0f;
+        auto const c = std::cos(angle);
+        auto const s = std::sin(angle);
+        auto const d = point - position_;
+        auto const x = c * d.x + s * d.y;
+        auto const y = -s * d.x + c * d.y;
+        return std::abs(x) <= 0.5f * size_.x && std::abs(y) <= 0.5f * size_.y;
+    }
+
+    bool GameObject::get_mouseover() const
+    {
+        return mouseover_;
+    }
+
+    GameObjectHandle GameObject::get_handle() const
+    {
+        return handle_;
+    }
+
+    void GameObject::add_mouse_enter_callback(CallbackFunction && f)
+    {
+        mouse_enter_callbacks_.emplace_back(f);
+    }
+
+    void GameObject::add_mouse_leave_callback(CallbackFunction && f)
+    {
+        mouse_leave_callbacks_.emplace_back(f);
+    }
+
+    void GameObject::add_click_begin_callback(CallbackFunction && f)
+    {
+        click_begin_callbacks_.emplace_back(f);
+    }
+
+    void GameObject::add_click_end_callback(CallbackFunction && f)
+    {
+        click_end_callbacks_.emplace_back(f);
+    }
+
+    void GameObject::clear_mouse_enter_callbacks()
+    {
+        mouse_enter_callbacks_.clear();
+    }
+
+    void GameObject::clear_mouse_leave_callbacks()
+    {
+        mouse_leave_callbacks_.clear();
+    }
+
+    void GameObject::clear_click_begin_callbacks()
+    {
+        click_begin_callbacks_.clear();
+    }
+
+    void GameObject::clear_click_end_callbacks()
+    {
+        click_end_callbacks_.clear();
+    }
+
+    void GameObject::bounds_changed()
+    {
+        if (screen_ && !bounds_changed_)
+        {
+            bounds_changed_ = true;
+            screen_->bounds_changed(*this);
+        }
+    }
+
     ImageObject::ImageObject(std::shared_ptr<sf::Texture> const& texture)
         :
-        texture_(texture),
+        region_(texture),
+        mirror_x_(false),
+        mirror_y_(false)
+    {}
+
+    ImageObject::ImageObject(TextureRegion const& region)
+        :
+        region_(region),
         mirror_x_(false),
         mirror_y_(false)
     {}
 
     void ImageObject::render_impl(sf::RenderTarget & target) const
     {
-        auto const & texture = *texture_;
-        sf::Sprite spr(texture);
-        float rotation_offset = 0;
-        if (mirror_x_ && mirror_y_)
-            rotation_offset = 180;
-        else if (mirror_x_)
-            spr.setTextureRect(sf::IntRect(texture.getSize().x, 0, -static_cast<int>(texture.getSize().x), texture.getSize().y));
-        else if (mirror_y_)
-            spr.setTextureRect(sf::IntRect(0, texture.getSize().y, texture.getSize().x, -static_cast<int>(texture.getSize().y)));
-        spr.setOrigin(0.5f * texture.getSize().x, 0.5f * texture.getSize().y);
-        spr.setPosition(get_position().x, get_position().y);
-        spr.setRotation(get_rotation()+rotation_offset);
-        spr.setScale(get_size().x / static_cast<float>(texture.getSize().x),
-                     get_size().y / static_cast<float>(texture.getSize().y));
-        target.draw(spr);
+        SpriteBatch batch;
+        batch.begin(target);
+        render_batch_impl(batch);
+        batch.end();
+    }
+
+    void ImageObject::render_batch_impl(SpriteBatch & batch) const
+    {
+        batch.draw(*region_.texture, region_.rect, get_render_position(), get_size(), get_render_rotation(), mirror_x_, mirror_y_);
     }
 
     bool ImageObject::get_mirror_x() const
@@ -134,6 +364,11 @@ namespace sfe
     }
     void ImageObject::set_texture(std::shared_ptr<sf::Texture> const & texture)
     {
-        texture_ = texture;
+        region_ = TextureRegion(texture);
+    }
+
+    void ImageObject::set_texture(TextureRegion const& region)
+    {
+        region_ = region;
     }
 }
@@ -0,0 +1,258 @@
+#include <SFE/job_system.hxx>
+
+#include <algorithm>
+
+namespace sfe
+{
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// The job system and the index of the calling thread if
+        /// it is a worker.
+        ////////////////////////////////////////////////////////////
+        thread_local JobSystem const * current_system = nullptr;
+        thread_local std::size_t current_index = 0;
+
+        ////////////////////////////////////////////////////////////
+        /// The initial capacity of a queue.
+        ////////////////////////////////////////////////////////////
+        std::size_t const initial_queue_capacity = 64;
+    }
+
+    JobGroup::JobGroup()
+        :
+        pending_(0),
+        failed_(false)
+    {}
+
+    bool JobGroup::is_done() const
+    {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+    void JobGroup::fail(std::exception_ptr e)
+    {
+        if (!failed_.exchange(true))
+            exception_ = e;
+    }
+
+    JobSystem::JobSystem(std::size_t thread_count)
+        :
+        queued_(0),
+        sleeping_(0),
+        stop_(false)
+    {
+        if (thread_count == 0)
+            thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            queues_.push_back(std::make_unique<Queue>());
+            queues_.back()->jobs.resize(initial_queue_capacity);
+            queues_.back()->head = 0;
+            queues_.back()->size = 0;
+        }
+        for (std::size_t i = 1; i < thread_count; ++i)
+            workers_.emplace_back([this, i]() { work(i); });
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto & worker : workers_)
+            worker.join();
+    }
+
+    JobSystem & JobSystem::global()
+    {
+        // Intentionally leaked, see the declaration.
+        static JobSystem * const system = new JobSystem();
+        return *system;
+    }
+
+    std::size_t JobSystem::get_thread_count() const
+    {
+        return queues_.size();
+    }
+
+    std::size_t JobSystem::get_thread_index() const
+    {
+        return current_system == this ? current_index : 0;
+    }
+
+    void JobSystem::run(JobGroup & group, std::function<void()> job)
+    {
+        using Function = std::function<void()>;
+        auto const context = new Function(std::move(job));
+        group.pending_.fetch_add(1, std::memory_order_relaxed);
+        push({
+            [](void const * context, std::size_t, std::size_t)
+            {
+                std::unique_ptr<Function const> f(static_cast<Function const *>(context));
+                (*f)();
+            },
+            context, 0, 1, 1, &group
+        });
+    }
+
+    void JobSystem::wait(JobGroup & group)
+    {
+        auto const index = get_thread_index();
+        while (!group.is_done())
+        {
+            Job job;
+            if (pop(index, job))
+                execute(job);
+            else
+                std::this_thread::yield();
+        }
+
+        if (group.failed_)
+        {
+            auto const e = group.exception_;
+            group.exception_ = nullptr;
+            group.failed_ = false;
+            std::rethrow_exception(e);
+        }
+    }
+
+    void JobSystem::push(Job const & job)
+    {
+        auto & queue = *queues_[get_thread_index()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            auto const capacity = queue.jobs.size();
+            if (queue.size == capacity)
+            {
+                // Unroll the ring buffer into a larger one.
+                std::vector<Job> jobs(2 * capacity);
+                for (std::size_t i = 0; i < queue.size; ++i)
+                    jobs[i] = queue.jobs[(queue.head + i) % capacity];
+                queue.jobs.swap(jobs);
+                queue.head = 0;
+            }
+            queue.jobs[(queue.head + queue.size) % queue.jobs.size()] = job;
+            ++queue.size;
+        }
+
+        // A worker that goes to sleep counts itself before it checks
+        // queued_, so either it sees the job or it is woken up.
+        queued_.fetch_add(1);
+        if (sleeping_.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            wake_.notify_one();
+        }
+    }
+
+    bool JobSystem::pop(std::size_t thread_index, Job & job)
+    {
+        if (queued_.load() == 0)
+            return false;
+
+        // Take the newest job of the own queue, it is the one whose
+        // data is most likely still in the cache.
+        {
+            auto & queue = *queues_[thread_index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.size > 0)
+            {
+                --queue.size;
+                job = queue.jobs[(queue.head + queue.size) % queue.jobs.size()];
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // Steal the oldest job of another queue, it is the largest
+        // piece of a split range.
+        for (std::size_t i = 1; i < queues_.size(); ++i)
+        {
+            auto & queue = *queues_[(thread_index + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.size > 0)
+            {
+                job = queue.jobs[queue.head];
+                queue.head = (queue.head + 1) % queue.jobs.size();
+                --queue.size;
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::execute(Job job)
+    {
+        auto & group = *job.group;
+        try
+        {
+            // Keep the first half and let other threads steal the
+            // second half.
+            while (job.end - job.begin > job.grain)
+            {
+                auto second = job;
+                second.begin = job.begin + (job.end - job.begin) / 2;
+                job.end = second.begin;
+                group.pending_.fetch_add(1, std::memory_order_relaxed);
+                push(second);
+            }
+            job.fn(job.context, job.begin, job.end);
+        }
+        catch (...)
+        {
+            group.fail(std::current_exception());
+        }
+        group.pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void JobSystem::parallel_for_impl(
+        std::size_t begin,
+        std::size_t end,
+        std::size_t grain,
+        void (*fn)(void const * context, std::size_t begin, std::size_t end),
+        void const * context
+    ){
+        if (begin >= end)
+            return;
+
+        // Small ranges and single threads do not need the queues.
+        grain = std::max<std::size_t>(grain, 1);
+        if (end - begin <= grain || queues_.size() == 1)
+        {
+            fn(context, begin, end);
+            return;
+        }
+
+        JobGroup group;
+        group.pending_ = 1;
+        execute({ fn, context, begin, end, grain, &group });
+        wait(group);
+    }
+
+    void JobSystem::work(std::size_t thread_index)
+    {
+        current_system = this;
+        current_index = thread_index;
+        while (true)
+        {
+            Job job;
+            if (pop(thread_index, job))
+            {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleeping_.fetch_add(1);
+            wake_.wait(lock, [this]() { return stop_ || queued_.load() > 0; });
+            sleeping_.fetch_sub(1);
+            if (stop_ && queued_.load() == 0)
+                return;
+        }
+    }
+
+} // namespace sfe
@@ -0,0 +1,102 @@
+#include <SFE/object_pool.hxx>
+
+#include <algorithm>
+#include <new>
+
+namespace sfe
+{
+    std::size_t const ObjectPool::granularity;
+    std::size_t const ObjectPool::max_block_size;
+
+    ObjectPool::ObjectPool(std::size_t chunk_size)
+        :
+        chunk_size_(chunk_size)
+    {
+        free_.fill(nullptr);
+        free_count_.fill(0);
+    }
+
+    ObjectPool & ObjectPool::global()
+    {
+        // Intentionally leaked, see the declaration.
+        static ObjectPool * const pool = new ObjectPool();
+        return *pool;
+    }
+
+    void* ObjectPool::allocate(std::size_t size)
+    {
+        if (size > max_block_size)
+            return ::operator new(size);
+
+        auto const c = size_class(size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_[c])
+            grow(c, 1);
+        auto const block = free_[c];
+        free_[c] = block->next;
+        --free_count_[c];
+        return block;
+    }
+
+    void ObjectPool::deallocate(void* p, std::size_t size)
+    {
+        if (!p)
+            return;
+        if (size > max_block_size)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        auto const c = size_class(size);
+        auto const block = static_cast<FreeBlock*>(p);
+        std::lock_guard<std::mutex> lock(mutex_);
+        block->next = free_[c];
+        free_[c] = block;
+        ++free_count_[c];
+    }
+
+    void ObjectPool::reserve(std::size_t size, std::size_t count)
+    {
+        if (size > max_block_size)
+            return;
+
+        auto const c = size_class(size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_count_[c] < count)
+            grow(c, count - free_count_[c]);
+    }
+
+    std::size_t ObjectPool::get_capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t capacity = 0;
+        for (auto const & chunk : chunks_)
+            capacity += chunk.second;
+        return capacity;
+    }
+
+    std::size_t ObjectPool::size_class(std::size_t size)
+    {
+        return size == 0 ? 0 : (size - 1) / granularity;
+    }
+
+    void ObjectPool::grow(std::size_t size_class, std::size_t count)
+    {
+        // The chunk memory comes from operator new[], so blocks at
+        // multiples of the granularity are suitably aligned.
+        auto const block_size = (size_class + 1) * granularity;
+        auto const n = std::max(count, chunk_size_ / block_size);
+        auto const chunk_size = n * block_size;
+        chunks_.emplace_back(std::unique_ptr<char[]>(new char[chunk_size]), chunk_size);
+        auto const data = chunks_.back().first.get();
+        for (std::size_t i = n; i > 0; --i)
+        {
+            auto const block = reinterpret_cast<FreeBlock*>(data + (i - 1) * block_size);
+            block->next = free_[size_class];
+            free_[size_class] = block;
+        }
+        free_count_[size_class] += n;
+    }
+
+} // namespace sfe
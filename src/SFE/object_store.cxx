@@ -0,0 +1,336 @@
+#include <SFE/object_store.hxx>
+
+#include <algorithm>
+
+namespace sfe
+{
+    std::uint32_t const ObjectStore::npos;
+
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// Return the generation of the object id.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t object_generation(ObjectId id)
+        {
+            return static_cast<std::uint32_t>(id >> 32);
+        }
+    }
+
+    ObjectStore::ObjectStore()
+        :
+        free_(npos),
+        next_sequence_(0),
+        order_dirty_(false)
+    {}
+
+    ObjectId ObjectStore::create()
+    {
+        // Reuse a free slot or append a new one.
+        std::uint32_t slot;
+        if (free_ != npos)
+        {
+            slot = free_;
+            free_ = slots_[slot].index;
+        }
+        else
+        {
+            slot = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back({ 1, npos });
+        }
+
+        auto const index = static_cast<std::uint32_t>(ids_.size());
+        auto const id = (static_cast<ObjectId>(slots_[slot].generation) << 32) | slot;
+        slots_[slot].index = index;
+
+        ids_.push_back(id);
+        positions_.emplace_back(0.0f, 0.0f);
+        sizes_.emplace_back(1.0f, 1.0f);
+        rotations_.push_back(0.0f);
+        z_indices_.push_back(0);
+        visible_.push_back(1);
+        sequences_.push_back(next_sequence_++);
+
+        // A new object has z-index 0 and the highest sequence number,
+        // so the order is only kept if no object is in front of it.
+        if (!order_dirty_ && (order_.empty() || z_indices_[order_.back()] <= 0))
+            order_.push_back(index);
+        else
+            order_dirty_ = true;
+
+        return id;
+    }
+
+    void ObjectStore::destroy(ObjectId id)
+    {
+        if (!contains(id))
+            return;
+
+        auto const slot = detail::object_slot(id);
+        auto const index = slots_[slot].index;
+        auto const last = static_cast<std::uint32_t>(ids_.size() - 1);
+
+        for (auto & p : pools_)
+            p.second->remove_slot(slot);
+
+        // Move the last object into the gap.
+        if (index != last)
+        {
+            ids_[index] = ids_[last];
+            positions_[index] = positions_[last];
+            sizes_[index] = sizes_[last];
+            rotations_[index] = rotations_[last];
+            z_indices_[index] = z_indices_[last];
+            visible_[index] = visible_[last];
+            sequences_[index] = sequences_[last];
+            slots_[detail::object_slot(ids_[index])].index = index;
+        }
+        ids_.pop_back();
+        positions_.pop_back();
+        sizes_.pop_back();
+        rotations_.pop_back();
+        z_indices_.pop_back();
+        visible_.pop_back();
+        sequences_.pop_back();
+
+        // Bump the generation so old ids become invalid. A slot whose
+        // generation would wrap around is not reused.
+        auto & s = slots_[slot];
+        ++s.generation;
+        if (s.generation != 0)
+        {
+            s.index = free_;
+            free_ = slot;
+        }
+        else
+        {
+            s.index = npos;
+        }
+
+        // Remove the object from the order in place and rename the
+        // moved object, so the order needs no sort.
+        if (!order_dirty_)
+        {
+            order_.erase(std::find(order_.begin(), order_.end(), index));
+            if (index != last)
+                *std::find(order_.begin(), order_.end(), last) = index;
+        }
+    }
+
+    void ObjectStore::clear()
+    {
+        for (auto const id : ids_)
+        {
+            auto & s = slots_[detail::object_slot(id)];
+            ++s.generation;
+            if (s.generation != 0)
+            {
+                s.index = free_;
+                free_ = detail::object_slot(id);
+            }
+            else
+            {
+                s.index = npos;
+            }
+        }
+        for (auto & p : pools_)
+            p.second->clear();
+        ids_.clear();
+        positions_.clear();
+        sizes_.clear();
+        rotations_.clear();
+        z_indices_.clear();
+        visible_.clear();
+        sequences_.clear();
+        order_.clear();
+        order_dirty_ = false;
+    }
+
+    bool ObjectStore::contains(ObjectId id) const
+    {
+        auto const slot = detail::object_slot(id);
+        return slot < slots_.size()
+            && slots_[slot].generation == object_generation(id)
+            && slots_[slot].index != npos
+            && ids_[slots_[slot].index] == id;
+    }
+
+    std::size_t ObjectStore::size() const
+    {
+        return ids_.size();
+    }
+
+    std::size_t ObjectStore::get_index(ObjectId id) const
+    {
+        return checked_index(id);
+    }
+
+    ObjectId const * ObjectStore::get_ids() const
+    {
+        return ids_.data();
+    }
+
+    sf::Vector2f * ObjectStore::get_positions()
+    {
+        return positions_.data();
+    }
+
+    sf::Vector2f const * ObjectStore::get_positions() const
+    {
+        return positions_.data();
+    }
+
+    sf::Vector2f * ObjectStore::get_sizes()
+    {
+        return sizes_.data();
+    }
+
+    sf::Vector2f const * ObjectStore::get_sizes() const
+    {
+        return sizes_.data();
+    }
+
+    float * ObjectStore::get_rotations()
+    {
+        return rotations_.data();
+    }
+
+    float const * ObjectStore::get_rotations() const
+    {
+        return rotations_.data();
+    }
+
+    int const * ObjectStore::get_z_indices() const
+    {
+        return z_indices_.data();
+    }
+
+    std::uint8_t * ObjectStore::get_visible()
+    {
+        return visible_.data();
+    }
+
+    std::uint8_t const * ObjectStore::get_visible() const
+    {
+        return visible_.data();
+    }
+
+    sf::Vector2f const & ObjectStore::get_position(ObjectId id) const
+    {
+        return positions_[checked_index(id)];
+    }
+
+    void ObjectStore::set_position(ObjectId id, sf::Vector2f const & position)
+    {
+        positions_[checked_index(id)] = position;
+    }
+
+    sf::Vector2f const & ObjectStore::get_size(ObjectId id) const
+    {
+        return sizes_[checked_index(id)];
+    }
+
+    void ObjectStore::set_size(ObjectId id, sf::Vector2f const & size)
+    {
+        sizes_[checked_index(id)] = size;
+    }
+
+    float ObjectStore::get_rotation(ObjectId id) const
+    {
+        return rotations_[checked_index(id)];
+    }
+
+    void ObjectStore::set_rotation(ObjectId id, float angle)
+    {
+        rotations_[checked_index(id)] = angle;
+    }
+
+    int ObjectStore::get_z_index(ObjectId id) const
+    {
+        return z_indices_[checked_index(id)];
+    }
+
+    void ObjectStore::set_z_index(ObjectId id, int z_index)
+    {
+        auto & z = z_indices_[checked_index(id)];
+        if (z != z_index)
+        {
+            z = z_index;
+            order_dirty_ = true;
+        }
+    }
+
+    bool ObjectStore::get_visible(ObjectId id) const
+    {
+        return visible_[checked_index(id)] != 0;
+    }
+
+    void ObjectStore::set_visible(ObjectId id, bool b)
+    {
+        visible_[checked_index(id)] = b ? 1 : 0;
+    }
+
+    std::size_t ObjectStore::render(SpriteBatch & batch, std::size_t first, int end_z_index) const
+    {
+        update_order();
+        first = std::min(first, order_.size());
+        auto const last = std::lower_bound(order_.begin() + first, order_.end(), end_z_index,
+            [this](std::uint32_t index, int z) {
+                return z_indices_[index] < z;
+            }
+        );
+        auto const last_pos = static_cast<std::size_t>(last - order_.begin());
+        render_range(batch, first, last_pos);
+        return last_pos;
+    }
+
+    void ObjectStore::render(SpriteBatch & batch, std::size_t first) const
+    {
+        update_order();
+        render_range(batch, std::min(first, order_.size()), order_.size());
+    }
+
+    void ObjectStore::render_range(SpriteBatch & batch, std::size_t first, std::size_t last) const
+    {
+        auto const sprites = find_pool<SpriteComponent>();
+        if (!sprites)
+            return;
+
+        for (auto i = first; i < last; ++i)
+        {
+            auto const index = order_[i];
+            if (!visible_[index])
+                continue;
+            auto const sprite = sprites->get(ids_[index]);
+            if (!sprite || !sprite->region.texture)
+                continue;
+            batch.draw(*sprite->region.texture, sprite->region.rect,
+                positions_[index], sizes_[index], rotations_[index], sprite->mirror_x, sprite->mirror_y);
+        }
+    }
+
+    std::size_t ObjectStore::checked_index(ObjectId id) const
+    {
+        if (!contains(id))
+            throw ObjectStoreException("ObjectStore: The object does not exist.");
+        return slots_[detail::object_slot(id)].index;
+    }
+
+    void ObjectStore::update_order() const
+    {
+        if (!order_dirty_)
+            return;
+
+        order_.resize(ids_.size());
+        for (std::size_t i = 0; i < order_.size(); ++i)
+            order_[i] = static_cast<std::uint32_t>(i);
+        std::sort(order_.begin(), order_.end(),
+            [this](std::uint32_t a, std::uint32_t b) {
+                return z_indices_[a] < z_indices_[b]
+                    || (z_indices_[a] == z_indices_[b] && sequences_[a] < sequences_[b]);
+            }
+        );
+        order_dirty_ = false;
+    }
+
+} // namespace sfe
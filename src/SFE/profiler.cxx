@@ -0,0 +1,394 @@
+#include <SFE/profiler.hxx>
+#include <SFE/utility.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <utility>
+
+namespace sfe
+{
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// The index of the parent of zones without parent.
+        ////////////////////////////////////////////////////////////
+        std::size_t const no_parent = std::numeric_limits<std::size_t>::max();
+
+        ////////////////////////////////////////////////////////////
+        /// The number of open zones of the calling thread.
+        ////////////////////////////////////////////////////////////
+        thread_local std::size_t zone_depth = 0;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the time of the steady clock in nanoseconds.
+        ////////////////////////////////////////////////////////////
+        std::int64_t clock_ns()
+        {
+            auto const now = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Write the nanoseconds as microseconds with three
+        /// decimals, as the trace events expect them.
+        ////////////////////////////////////////////////////////////
+        void write_us(std::ostream & out, std::int64_t ns)
+        {
+            auto const fill = out.fill('0');
+            out << ns / 1000 << '.' << std::setw(3) << ns % 1000;
+            out.fill(fill);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Write the nanoseconds as milliseconds.
+        ////////////////////////////////////////////////////////////
+        void write_ms(std::ostream & out, std::int64_t ns)
+        {
+            auto const flags = out.flags();
+            auto const precision = out.precision(3);
+            out << std::fixed << std::setw(9) << ns / 1e6 << " ms";
+            out.flags(flags);
+            out.precision(precision);
+        }
+    }
+
+    void ProfileFrame::write_text(std::ostream & out) const
+    {
+        out << "frame " << frame << ": ";
+        write_ms(out, duration_ns);
+        out << '\n';
+        for (auto const & z : zones)
+        {
+            out << std::string(2 + 2 * z.depth, ' ') << z.name
+                << " calls=" << z.calls << " total=";
+            write_ms(out, z.total_ns);
+            out << " self=";
+            write_ms(out, z.self_ns);
+            out << " max=";
+            write_ms(out, z.max_ns);
+            out << '\n';
+        }
+    }
+
+    Profiler & Profiler::global()
+    {
+        static auto const profiler = new Profiler();
+        return *profiler;
+    }
+
+    Profiler::Profiler()
+        :
+        enabled_(false),
+        epoch_(clock_ns()),
+        capacity_(1 << 16),
+        frame_count_(0),
+        frame_begin_(0),
+        last_frame_begin_(0),
+        last_frame_end_(0)
+    {}
+
+    void Profiler::set_enabled(bool enabled)
+    {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    void Profiler::set_capacity(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        for (auto const & buffer : buffers_)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->zones = std::vector<Zone>();
+            buffer->written = 0;
+        }
+    }
+
+    std::size_t Profiler::get_capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto const & buffer : buffers_)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->written = 0;
+        }
+    }
+
+    void Profiler::set_thread_name(char const * name)
+    {
+        auto & buffer = get_buffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.name = name;
+    }
+
+    void Profiler::record(char const * name, std::int64_t begin, std::int64_t end, std::size_t depth)
+    {
+        auto & buffer = get_buffer();
+        std::unique_lock<std::mutex> lock(buffer.mutex);
+        if (buffer.zones.empty())
+        {
+            // Allocate the ring on the first record, so threads that
+            // only name themselves cost no memory. The profiler mutex
+            // is locked first, as in set_capacity().
+            lock.unlock();
+            std::lock_guard<std::mutex> profiler_lock(mutex_);
+            lock.lock();
+            if (buffer.zones.empty())
+            {
+                buffer.zones.resize(capacity_);
+                buffer.written = 0;
+            }
+            if (buffer.zones.empty())
+                return;
+        }
+        buffer.zones[buffer.written % buffer.zones.size()] = { name, begin, end, depth };
+        ++buffer.written;
+    }
+
+    void Profiler::end_frame()
+    {
+        auto const now = now_ns();
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_frame_begin_ = frame_begin_;
+        last_frame_end_ = now;
+        frame_begin_ = now;
+        ++frame_count_;
+    }
+
+    std::uint64_t Profiler::get_frame_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frame_count_;
+    }
+
+    ProfileFrame Profiler::get_last_frame() const
+    {
+        ProfileFrame frame;
+        std::int64_t begin;
+        std::int64_t end;
+        std::vector<ThreadBuffer *> buffers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frame.frame = frame_count_;
+            begin = last_frame_begin_;
+            end = last_frame_end_;
+            for (auto const & buffer : buffers_)
+                buffers.push_back(buffer.get());
+        }
+        frame.duration_ns = end - begin;
+        if (frame.frame == 0)
+            return frame;
+
+        // Merge the zones of all threads into a tree, where the
+        // zones with the same name and parent share a node.
+        struct Node
+        {
+            ProfileZoneStats stats;
+            std::vector<std::size_t> children;
+        };
+        std::vector<Node> nodes;
+        std::vector<std::size_t> roots;
+        std::map<std::pair<std::size_t, std::string>, std::size_t> node_index;
+
+        for (auto const buffer : buffers)
+        {
+            auto zones = copy_zones(*buffer);
+            zones.erase(std::remove_if(zones.begin(), zones.end(), [begin, end](Zone const & z)
+            {
+                return z.begin < begin || z.begin >= end;
+            }), zones.end());
+
+            // Zones are recorded when they end, so the children come
+            // before their parent.
+            std::sort(zones.begin(), zones.end(), [](Zone const & a, Zone const & b)
+            {
+                return a.begin < b.begin || (a.begin == b.begin && a.depth < b.depth);
+            });
+
+            std::vector<std::pair<Zone const *, std::size_t>> open;
+            for (auto const & z : zones)
+            {
+                while (!open.empty() && (open.back().first->depth >= z.depth || open.back().first->end < z.end))
+                    open.pop_back();
+                auto const parent = open.empty() ? no_parent : open.back().second;
+
+                auto const key = std::make_pair(parent, std::string(z.name));
+                auto it = node_index.find(key);
+                if (it == node_index.end())
+                {
+                    auto const depth = parent == no_parent ? 0 : nodes[parent].stats.depth + 1;
+                    it = node_index.emplace(key, nodes.size()).first;
+                    nodes.push_back({ { z.name, depth, 0, 0, 0, 0 }, {} });
+                    if (parent == no_parent)
+                        roots.push_back(it->second);
+                    else
+                        nodes[parent].children.push_back(it->second);
+                }
+
+                auto const duration = z.end - z.begin;
+                auto & stats = nodes[it->second].stats;
+                ++stats.calls;
+                stats.total_ns += duration;
+                stats.self_ns += duration;
+                stats.max_ns = std::max(stats.max_ns, duration);
+                if (parent != no_parent)
+                    nodes[parent].stats.self_ns -= duration;
+                open.emplace_back(&z, it->second);
+            }
+        }
+
+        // Flatten the tree depth-first.
+        std::vector<std::size_t> pending(roots.rbegin(), roots.rend());
+        while (!pending.empty())
+        {
+            auto const i = pending.back();
+            pending.pop_back();
+            frame.zones.push_back(nodes[i].stats);
+            pending.insert(pending.end(), nodes[i].children.rbegin(), nodes[i].children.rend());
+        }
+        return frame;
+    }
+
+    void Profiler::write_chrome_trace(std::ostream & out) const
+    {
+        std::vector<ThreadBuffer *> buffers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto const & buffer : buffers_)
+                buffers.push_back(buffer.get());
+        }
+
+        out << "{\"traceEvents\":[";
+        auto first = true;
+        for (auto const buffer : buffers)
+        {
+            std::string name;
+            {
+                std::lock_guard<std::mutex> lock(buffer->mutex);
+                name = buffer->name;
+            }
+            if (!name.empty())
+            {
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                    << buffer->id << ",\"args\":{\"name\":";
+                write_json_string(out, name);
+                out << "}}";
+                first = false;
+            }
+            for (auto const & z : copy_zones(*buffer))
+            {
+                out << (first ? "" : ",") << "\n{\"name\":";
+                write_json_string(out, z.name);
+                out << ",\"cat\":\"sfe\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":";
+                write_us(out, z.begin);
+                out << ",\"dur\":";
+                write_us(out, z.end - z.begin);
+                out << '}';
+                first = false;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    std::int64_t Profiler::now_ns() const
+    {
+        return clock_ns() - epoch_;
+    }
+
+    Profiler::ThreadBuffer & Profiler::get_buffer()
+    {
+        // Releases the buffer of the thread when it exits. The
+        // profiler is never destroyed, so it outlives all threads.
+        struct OwnedBuffer
+        {
+            ~OwnedBuffer()
+            {
+                if (buffer)
+                {
+                    std::lock_guard<std::mutex> lock(Profiler::global().mutex_);
+                    buffer->released = true;
+                    buffer = nullptr;
+                }
+            }
+
+            ThreadBuffer * buffer = nullptr;
+        };
+        thread_local OwnedBuffer owned;
+
+        if (!owned.buffer)
+        {
+            // Reuse a released buffer. Its zones are kept until they
+            // are overwritten, since they do not overlap the zones of
+            // the new thread.
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = std::find_if(buffers_.begin(), buffers_.end(), [](auto const & b) {
+                return b->released;
+            });
+            if (it != buffers_.end())
+            {
+                owned.buffer = it->get();
+                owned.buffer->released = false;
+                std::lock_guard<std::mutex> buffer_lock(owned.buffer->mutex);
+                owned.buffer->name.clear();
+            }
+            else
+            {
+                auto new_buffer = std::make_unique<ThreadBuffer>();
+                new_buffer->id = buffers_.size();
+                owned.buffer = new_buffer.get();
+                buffers_.push_back(std::move(new_buffer));
+            }
+        }
+        return *owned.buffer;
+    }
+
+    std::vector<Profiler::Zone> Profiler::copy_zones(ThreadBuffer & buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        auto const size = buffer.zones.size();
+        if (buffer.written <= size)
+            return std::vector<Zone>(buffer.zones.begin(), buffer.zones.begin() + buffer.written);
+
+        // The oldest zone is the next one to be overwritten.
+        auto const oldest = buffer.zones.begin() + buffer.written % size;
+        std::vector<Zone> zones(oldest, buffer.zones.end());
+        zones.insert(zones.end(), buffer.zones.begin(), oldest);
+        return zones;
+    }
+
+    ProfileZone::ProfileZone(char const * name)
+        :
+        name_(nullptr),
+        begin_(0)
+    {
+        auto & profiler = Profiler::global();
+        if (profiler.is_enabled())
+        {
+            name_ = name;
+            ++zone_depth;
+            begin_ = profiler.now_ns();
+        }
+    }
+
+    ProfileZone::~ProfileZone()
+    {
+        if (name_)
+        {
+            auto & profiler = Profiler::global();
+            auto const end = profiler.now_ns();
+            --zone_depth;
+            profiler.record(name_, begin_, end, zone_depth);
+        }
+    }
+
+} // namespace sfe
@@ -0,0 +1,104 @@
+#include <SFE/render_commands.hxx>
+
+#include <algorithm>
+#include <limits>
+
+namespace sfe
+{
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// The view index of commands before the first view.
+        ////////////////////////////////////////////////////////////
+        std::size_t const no_view = std::numeric_limits<std::size_t>::max();
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the render states are equal.
+        ////////////////////////////////////////////////////////////
+        bool same_states(sf::RenderStates const & a, sf::RenderStates const & b)
+        {
+            return a.texture == b.texture
+                && a.shader == b.shader
+                && a.blendMode == b.blendMode
+                && std::equal(a.transform.getMatrix(), a.transform.getMatrix() + 16, b.transform.getMatrix());
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether two draw calls of the primitive type can
+        /// be merged into one.
+        ////////////////////////////////////////////////////////////
+        bool is_list(sf::PrimitiveType type)
+        {
+            return type == sf::Triangles || type == sf::Lines || type == sf::Points;
+        }
+    }
+
+    RenderCommands::RenderCommands()
+    {}
+
+    void RenderCommands::clear()
+    {
+        views_.clear();
+        vertices_.clear();
+        commands_.clear();
+    }
+
+    bool RenderCommands::empty() const
+    {
+        return commands_.empty() && views_.empty();
+    }
+
+    void RenderCommands::set_view(sf::View const & view)
+    {
+        views_.push_back(view);
+    }
+
+    void RenderCommands::draw(
+        sf::Vertex const * vertices,
+        std::size_t count,
+        sf::PrimitiveType type,
+        sf::RenderStates const & states
+    ){
+        if (count == 0)
+            return;
+
+        auto const view = views_.empty() ? no_view : views_.size() - 1;
+        auto const first = vertices_.size();
+        vertices_.insert(vertices_.end(), vertices, vertices + count);
+
+        if (!commands_.empty())
+        {
+            auto & last = commands_.back();
+            if (last.view == view && last.type == type && is_list(type) && same_states(last.states, states))
+            {
+                last.count += count;
+                return;
+            }
+        }
+        commands_.push_back({ view, first, count, type, states });
+    }
+
+    void RenderCommands::execute(sf::RenderTarget & target) const
+    {
+        auto view = no_view;
+        for (auto const & c : commands_)
+        {
+            if (c.view != view)
+            {
+                view = c.view;
+                target.setView(views_[view]);
+            }
+            target.draw(&vertices_[c.first], c.count, c.type, c.states);
+        }
+
+        // Views after the last draw call still apply to the target.
+        if (!views_.empty() && views_.size() - 1 != view)
+            target.setView(views_.back());
+    }
+
+    std::size_t RenderCommands::get_draw_calls() const
+    {
+        return commands_.size();
+    }
+
+} // namespace sfe
@@ -27,4 +27,33 @@ namespace sfe
         }
     }
 
+    TextureRegion ResourceManager::get_texture_region(std::string const & name)
+    {
+        if (atlas_.contains(name))
+            return atlas_.get_region(name);
+        else
+            return TextureRegion(get_texture(name));
+    }
+
+    void ResourceManager::build_atlas(std::vector<std::string> const & names)
+    {
+        for (auto const & name : names)
+        {
+            if (atlas_.contains(name))
+                continue;
+            sf::Image image;
+            if (!image.loadFromFile(name))
+            {
+                throw ResourceException("Could not load image " + name);
+            }
+            atlas_.add(name, image);
+        }
+        atlas_.build();
+    }
+
+    TextureAtlas const & ResourceManager::get_atlas() const
+    {
+        return atlas_;
+    }
+
 } // namespace sfe
@@ -1,12 +1,47 @@
 #include <SFE/screen.hxx>
 #include <SFE/event_manager.hxx>
+#include <SFE/input.hxx>
+#include <SFE/job_system.hxx>
+#include <SFE/profiler.hxx>
 #include <SFE/resource_manager.hxx>
 #include <SFE/utility.hxx>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
 
 namespace sfe
 {
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// Marks the end of the free slot list.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t const no_slot = 0xffffffffu;
+
+        ////////////////////////////////////////////////////////////
+        /// Return the slot of the handle.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t handle_slot(GameObjectHandle handle)
+        {
+            return static_cast<std::uint32_t>(handle.get_id() & 0xffffffffu);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return the generation of the handle.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t handle_generation(GameObjectHandle handle)
+        {
+            return static_cast<std::uint32_t>(handle.get_id() >> 32);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// The id of the next parallel update of any screen.
+        ////////////////////////////////////////////////////////////
+        std::atomic<std::uint64_t> next_parallel_update_id(1);
+    }
+
     Screen::Screen(
         sf::View game_view,
         std::shared_ptr<EventManager> const& event_manager,
@@ -14,7 +49,21 @@ namespace sfe
     )   :
         game_view_(std::move(game_view)),
         event_manager_(event_manager),
-        resource_manager_(resource_manager)
+        resource_manager_(resource_manager),
+        removed_objects_(0),
+        free_slot_(no_slot),
+        order_dirty_(false),
+        updating_parallel_(false),
+        used_thread_changes_(0),
+        parallel_update_id_(0),
+        pressed_object_(nullptr),
+        culling_(true),
+        render_stamp_(0),
+        drawn_objects_(0),
+        culled_objects_(0),
+        interpolation_(1),
+        gui_mouse_(-1.0f, -1.0f),
+        gui_handled_(false)
     {}
 
     Screen::~Screen() = default;
@@ -30,41 +79,100 @@ namespace sfe
             // Get the mouse position on the window.
             auto mouse_pos = sf::Mouse::getPosition(window);
 
-            // Update mouseover states of the gui widgets.
-            auto handled = gui_.update_mouse(mouse_pos.x / static_cast<float>(window.getSize().x),
-                                  mouse_pos.y / static_cast<float>(window.getSize().y));
+            // Update mouseover states of the gui widgets. Changes
+            // since the last frame must be laid out first. The hit
+            // test is skipped if neither the mouse nor the gui
+            // changed since the last one, since its result would be
+            // the same.
+            gui_.layout({ 0.0f, 0.0f, 1.0f, 1.0f });
+            sf::Vector2f const gui_mouse(mouse_pos.x / static_cast<float>(window.getSize().x),
+                                         mouse_pos.y / static_cast<float>(window.getSize().y));
+            auto const & input = Input::global();
+            if (gui_.needs_mouse_update() || gui_mouse != gui_mouse_ ||
+                input.is_pressed(sf::Mouse::Left) || input.is_released(sf::Mouse::Left))
+            {
+                gui_handled_ = gui_.update_mouse(gui_mouse.x, gui_mouse.y);
+                gui_mouse_ = gui_mouse;
+            }
 
-            // TODO:
             // Update the hover states of the game objects.
             // If no gui widget was clicked, forward the click to the game objects.
+            update_mouse(window.mapPixelToCoords(mouse_pos, game_view_), gui_handled_);
         }
 
+        update(elapsed_time);
+    }
+
+    void Screen::update(sf::Time elapsed_time)
+    {
         // Update the logic of the gui widgets.
-        gui_.update(elapsed_time);
-        
-        // Update the logic of the game objects.
-        for (auto & obj : game_objects_)
-            obj->update(elapsed_time);
+        {
+            SFE_PROFILE_ZONE("Widget::update");
+            gui_.update(elapsed_time);
+        }
+
+        // Update the logic of the game objects. They may add and
+        // remove game objects, so the vector must not be iterated.
+        {
+            SFE_PROFILE_ZONE("GameObject::update");
+            for (std::size_t i = 0; i < game_objects_.size(); ++i)
+                if (game_objects_[i] && !game_objects_[i]->parallel_update_)
+                    game_objects_[i]->update(elapsed_time);
+            update_parallel(elapsed_time);
+        }
 
         // Call the custom update method.
         if (update_)
             update_(elapsed_time);
 
-        // Sort the game objects by their z-index so they are drawn in the right order.
-        std::sort(game_objects_.begin(), game_objects_.end(),
-            [](auto && a, auto && b) {
-                return a->get_z_index() < b->get_z_index();
-            }
-        );
+        // Keep the game objects ordered by their z-index so they are drawn in the right order.
+        update_order();
     }
 
     void Screen::render(sf::RenderTarget & target) const
     {
-        target.setView(game_view_);
-        for (auto const & obj : game_objects_)
-            obj->render(target);
-        target.setView({ { 0.5f, 0.5f },{ 1.0f, 1.0f } });
-        gui_.render(target, { 0.0f, 0.0f, 1.0f, 1.0f });
+        batch_.begin(target);
+        render_batch();
+        batch_.end();
+    }
+
+    void Screen::render(RenderCommands & commands) const
+    {
+        batch_.begin(commands);
+        render_batch();
+        batch_.end();
+    }
+
+    void Screen::render_batch() const
+    {
+        batch_.set_view(game_view_);
+        {
+            SFE_PROFILE_ZONE("GameObject::render");
+            cull_objects();
+            std::size_t pos = 0;
+            drawn_objects_ = 0;
+            culled_objects_ = 0;
+            for (auto const & obj : game_objects_)
+            {
+                // Hidden objects are neither drawn nor culled.
+                if (!obj || !obj->get_visible())
+                    continue;
+                if (culling_ && obj->cull_stamp_ != render_stamp_)
+                {
+                    ++culled_objects_;
+                    continue;
+                }
+                pos = objects_.render(batch_, pos, obj->get_z_index());
+                obj->render(batch_);
+                ++drawn_objects_;
+            }
+            objects_.render(batch_, pos);
+        }
+        batch_.set_view({ { 0.5f, 0.5f },{ 1.0f, 1.0f } });
+        {
+            SFE_PROFILE_ZONE("Widget::render");
+            gui_.render(batch_, { 0.0f, 0.0f, 1.0f, 1.0f });
+        }
     }
 
     Widget & Screen::get_gui()
@@ -77,35 +185,503 @@ namespace sfe
         return gui_;
     }
 
-    GameObject* Screen::add_game_object(std::unique_ptr<GameObject> obj)
+    GameObjectHandle Screen::add_game_object(std::unique_ptr<GameObject> obj)
     {
+        // Reuse a free slot or append a new one.
+        std::uint32_t slot;
+        if (free_slot_ != no_slot)
+        {
+            slot = free_slot_;
+            free_slot_ = slots_[slot].index;
+        }
+        else
+        {
+            slot = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back({ 1, no_slot, 0 });
+        }
+        slots_[slot].index = static_cast<std::uint32_t>(game_objects_.size());
+
         auto ptr = obj.get();
+        ptr->screen_ = this;
+        ptr->previous_stored_ = false;
+        ptr->handle_ = GameObjectHandle((static_cast<std::uint64_t>(slots_[slot].generation) << 32) | slot);
+        slots_[slot].entry = index_.insert(ptr, ptr->get_bounds());
+
+        // While the order is dirty, the back object may be a gap or
+        // a changed object, so the new object is sorted in as well.
+        if (order_dirty_ || (!game_objects_.empty() && game_objects_.back()->get_z_index() > ptr->get_z_index()))
+        {
+            ptr->z_index_changed_ = true;
+            order_dirty_ = true;
+        }
         game_objects_.push_back(std::move(obj));
-        return ptr;
+        return ptr->handle_;
     }
 
-    std::unique_ptr<GameObject> Screen::remove_game_object(GameObject* obj)
+    GameObject* Screen::get_game_object(GameObjectHandle handle) const
     {
-        auto comp = [obj](auto && objptr)
-        {
-            return objptr.get() == obj;
-        };
-        auto it = std::find_if(game_objects_.begin(), game_objects_.end(), comp);
-        if (it != game_objects_.end())
+        // Generation 0 is never handed out, it marks retired slots.
+        auto const slot = handle_slot(handle);
+        auto const generation = handle_generation(handle);
+        if (generation == 0 || slot >= slots_.size() || slots_[slot].generation != generation)
+            return nullptr;
+        return game_objects_[slots_[slot].index].get();
+    }
+
+    std::unique_ptr<GameObject> Screen::remove_game_object(GameObjectHandle handle)
+    {
+        auto const obj = get_game_object(handle);
+        if (!obj)
+            return std::unique_ptr<GameObject>();
+
+        // Leave a gap in the draw order, it is closed in update_order().
+        auto & s = slots_[handle_slot(handle)];
+        auto objptr = std::move(game_objects_[s.index]);
+        index_.remove(s.entry);
+        ++removed_objects_;
+        order_dirty_ = true;
+
+        // Bump the generation so old handles become invalid. A slot
+        // whose generation would wrap around is not reused.
+        ++s.generation;
+        if (s.generation != 0)
         {
-            auto objptr = std::move(*it);
-            game_objects_.erase(it);
-            return objptr;
+            s.index = free_slot_;
+            free_slot_ = handle_slot(handle);
         }
         else
         {
-            return std::unique_ptr<GameObject>();
+            s.index = no_slot;
         }
+
+        hovered_objects_.erase(std::remove(hovered_objects_.begin(), hovered_objects_.end(), obj), hovered_objects_.end());
+        std::replace(pending_objects_.begin(), pending_objects_.end(), obj, static_cast<GameObject*>(nullptr));
+        if (pressed_object_ == obj)
+            pressed_object_ = nullptr;
+        objptr->z_index_changed_ = false;
+        objptr->bounds_changed_ = false;
+        objptr->mouseover_ = false;
+        objptr->screen_ = nullptr;
+        objptr->handle_ = GameObjectHandle();
+        return objptr;
+    }
+
+    std::unique_ptr<GameObject> Screen::remove_game_object(GameObject* obj)
+    {
+        if (!obj || obj->screen_ != this)
+            return std::unique_ptr<GameObject>();
+        return remove_game_object(obj->handle_);
     }
 
     void Screen::clear_game_objects()
     {
+        for (auto const & obj : game_objects_)
+        {
+            if (!obj)
+                continue;
+            auto & s = slots_[handle_slot(obj->handle_)];
+            ++s.generation;
+            if (s.generation != 0)
+            {
+                s.index = free_slot_;
+                free_slot_ = handle_slot(obj->handle_);
+            }
+            else
+            {
+                s.index = no_slot;
+            }
+        }
         game_objects_.clear();
+        removed_objects_ = 0;
+        order_dirty_ = false;
+        index_.clear();
+        moved_objects_.clear();
+        hovered_objects_.clear();
+        std::fill(pending_objects_.begin(), pending_objects_.end(), nullptr);
+        pressed_object_ = nullptr;
+        objects_.clear();
+    }
+
+    void Screen::find_objects_at(sf::Vector2f const & point, std::vector<GameObject*> & result)
+    {
+        update_index();
+        auto const first = result.size();
+        index_.query_point(point, result);
+        result.erase(
+            std::remove_if(result.begin() + first, result.end(), [&point](GameObject* obj) {
+                return !obj->contains(point);
+            }),
+            result.end()
+        );
+    }
+
+    void Screen::find_objects_in(sf::FloatRect const & rect, std::vector<GameObject*> & result)
+    {
+        update_index();
+        index_.query_rect(rect, result);
+    }
+
+    GameObject* Screen::find_nearest_object(sf::Vector2f const & point, float max_distance)
+    {
+        update_index();
+        return index_.query_nearest(point, max_distance);
+    }
+
+    void Screen::set_spatial_cell_size(float cell_size)
+    {
+        update_index();
+        index_.set_cell_size(cell_size);
+    }
+
+    bool Screen::get_culling() const
+    {
+        return culling_;
+    }
+
+    void Screen::set_culling(bool culling)
+    {
+        culling_ = culling;
+    }
+
+    std::size_t Screen::get_drawn_objects() const
+    {
+        return drawn_objects_;
+    }
+
+    std::size_t Screen::get_culled_objects() const
+    {
+        return culled_objects_;
+    }
+
+    float Screen::get_interpolation() const
+    {
+        return interpolation_;
+    }
+
+    void Screen::set_interpolation(float alpha)
+    {
+        interpolation_ = alpha;
+    }
+
+    void Screen::store_transforms()
+    {
+        for (auto const & obj : game_objects_)
+        {
+            if (obj)
+            {
+                obj->previous_position_ = obj->position_;
+                obj->previous_rotation_ = obj->rotation_;
+                obj->previous_stored_ = true;
+            }
+        }
+    }
+
+    ObjectStore & Screen::get_object_store()
+    {
+        return objects_;
+    }
+
+    ObjectStore const & Screen::get_object_store() const
+    {
+        return objects_;
+    }
+
+    void Screen::update_order()
+    {
+        if (!order_dirty_)
+            return;
+
+        // Take out the changed objects and close the gaps, including
+        // those of removed objects. The remaining objects are still
+        // ordered.
+        std::size_t unchanged = 0;
+        for (auto & obj : game_objects_)
+        {
+            if (!obj)
+                continue;
+            if (obj->z_index_changed_)
+            {
+                obj->z_index_changed_ = false;
+                changed_objects_.push_back(std::move(obj));
+            }
+            else
+            {
+                set_draw_index(*obj, unchanged);
+                game_objects_[unchanged++].swap(obj);
+            }
+        }
+        game_objects_.resize(unchanged + changed_objects_.size());
+        // The slots still hold the old positions of the changed
+        // objects, which makes the sort stable without the buffer
+        // of std::stable_sort.
+        std::sort(changed_objects_.begin(), changed_objects_.end(),
+            [this](auto && a, auto && b) {
+                return a->get_z_index() < b->get_z_index()
+                    || (a->get_z_index() == b->get_z_index()
+                        && slots_[handle_slot(a->handle_)].index < slots_[handle_slot(b->handle_)].index);
+            }
+        );
+
+        // Merge from the back, so the changed objects go behind the
+        // unchanged objects with the same z-index.
+        auto out = game_objects_.size();
+        auto i = unchanged;
+        auto j = changed_objects_.size();
+        while (j > 0)
+        {
+            if (i > 0 && game_objects_[i - 1]->get_z_index() > changed_objects_[j - 1]->get_z_index())
+                game_objects_[--out] = std::move(game_objects_[--i]);
+            else
+                game_objects_[--out] = std::move(changed_objects_[--j]);
+            set_draw_index(*game_objects_[out], out);
+        }
+        changed_objects_.clear();
+        removed_objects_ = 0;
+        order_dirty_ = false;
+    }
+
+    void Screen::set_draw_index(GameObject const & obj, std::size_t index)
+    {
+        slots_[handle_slot(obj.handle_)].index = static_cast<std::uint32_t>(index);
+    }
+
+    void Screen::order_changed(GameObject & obj)
+    {
+        if (updating_parallel_)
+            get_thread_changes().order_dirty = true;
+        else
+            order_dirty_ = true;
+    }
+
+    void Screen::bounds_changed(GameObject & obj)
+    {
+        if (updating_parallel_)
+            get_thread_changes().moved_objects.push_back(obj.handle_);
+        else
+            moved_objects_.push_back(obj.handle_);
+    }
+
+    void Screen::update_parallel(sf::Time elapsed_time)
+    {
+        parallel_objects_.clear();
+        for (auto const & obj : game_objects_)
+            if (obj && obj->parallel_update_)
+                parallel_objects_.push_back(obj.get());
+        if (parallel_objects_.empty())
+            return;
+
+        // The objects report their changes to the buffer of their
+        // thread, so they do not need to synchronize.
+        auto & jobs = JobSystem::global();
+        parallel_update_id_ = next_parallel_update_id++;
+        used_thread_changes_ = 0;
+        updating_parallel_ = true;
+        std::exception_ptr error;
+        try
+        {
+            jobs.parallel_for(0, parallel_objects_.size(), 64, [this, elapsed_time](std::size_t i)
+            {
+                parallel_objects_[i]->update(elapsed_time);
+            });
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        updating_parallel_ = false;
+
+        // Also apply the changes of a failed update, so the flags of
+        // the objects stay in sync with the screen.
+        for (std::size_t i = 0; i < used_thread_changes_; ++i)
+        {
+            auto & changes = *thread_changes_[i];
+            moved_objects_.insert(moved_objects_.end(), changes.moved_objects.begin(), changes.moved_objects.end());
+            changes.moved_objects.clear();
+            order_dirty_ = order_dirty_ || changes.order_dirty;
+            changes.order_dirty = false;
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    Screen::ThreadChanges & Screen::get_thread_changes()
+    {
+        // The thread index of the job system is not unique, since all
+        // threads that are not workers share index 0, so the buffers
+        // are assigned per thread instead. The ids are unique over all
+        // screens, so a cached buffer is never mistaken for another one.
+        thread_local std::uint64_t cached_id = 0;
+        thread_local ThreadChanges* cached_changes = nullptr;
+        if (cached_id == parallel_update_id_)
+            return *cached_changes;
+
+        std::lock_guard<std::mutex> lock(thread_changes_mutex_);
+        if (used_thread_changes_ == thread_changes_.size())
+            thread_changes_.push_back(std::make_unique<ThreadChanges>());
+        cached_id = parallel_update_id_;
+        cached_changes = thread_changes_[used_thread_changes_++].get();
+        return *cached_changes;
+    }
+
+    void Screen::update_index() const
+    {
+        // Objects that were removed in the meantime are skipped.
+        for (auto const handle : moved_objects_)
+        {
+            auto const obj = get_game_object(handle);
+            if (!obj)
+                continue;
+            obj->bounds_changed_ = false;
+            index_.update(slots_[handle_slot(handle)].entry, obj->get_bounds());
+        }
+        moved_objects_.clear();
+    }
+
+    void Screen::cull_objects() const
+    {
+        if (!culling_)
+            return;
+
+        update_index();
+        if (++render_stamp_ == 0)
+        {
+            for (auto const & obj : game_objects_)
+                if (obj)
+                    obj->cull_stamp_ = 0;
+            render_stamp_ = 1;
+        }
+
+        // Find the objects whose bounds intersect the bounding box
+        // of the view.
+        auto const & center = game_view_.getCenter();
+        auto const half_size = 0.5f * game_view_.getSize();
+        auto const angle = game_view_.getRotation() * 3.14159265f / 180.0f;
+        auto const c = std::cos(angle);
+        auto const s = std::sin(angle);
+        auto const half_width = std::abs(c) * std::abs(half_size.x) + std::abs(s) * std::abs(half_size.y);
+        auto const half_height = std::abs(s) * std::abs(half_size.x) + std::abs(c) * std::abs(half_size.y);
+        view_objects_.clear();
+        index_.query_rect({ center.x - half_width, center.y - half_height, 2 * half_width, 2 * half_height }, view_objects_);
+
+        // If the view is rotated, the corners of its bounding box
+        // are outside the view. Check the objects against the axes
+        // of the view as well.
+        for (auto obj : view_objects_)
+        {
+            auto const bounds = obj->get_bounds();
+            auto const dx = bounds.left + 0.5f * bounds.width - center.x;
+            auto const dy = bounds.top + 0.5f * bounds.height - center.y;
+            auto const extent_x = 0.5f * (std::abs(c) * bounds.width + std::abs(s) * bounds.height);
+            auto const extent_y = 0.5f * (std::abs(s) * bounds.width + std::abs(c) * bounds.height);
+            if (std::abs(c * dx + s * dy) <= std::abs(half_size.x) + extent_x
+                && std::abs(-s * dx + c * dy) <= std::abs(half_size.y) + extent_y)
+                obj->cull_stamp_ = render_stamp_;
+        }
+    }
+
+    void Screen::update_mouse(sf::Vector2f const & point, bool over_gui)
+    {
+        update_order();
+        update_index();
+
+        // Find the visible objects under the mouse.
+        pending_objects_.clear();
+        if (!over_gui)
+        {
+            index_.query_point(point, pending_objects_);
+            pending_objects_.erase(
+                std::remove_if(pending_objects_.begin(), pending_objects_.end(), [&point](GameObject* obj) {
+                    return !obj->get_visible() || !obj->contains(point);
+                }),
+                pending_objects_.end()
+            );
+        }
+        hovered_objects_.swap(pending_objects_);
+
+        // Collect the objects that the mouse left, followed by the
+        // objects that the mouse entered. Only a few objects are
+        // under the mouse, so the linear searches are cheap.
+        pending_objects_.erase(
+            std::remove_if(pending_objects_.begin(), pending_objects_.end(), [this](GameObject* obj) {
+                return std::find(hovered_objects_.begin(), hovered_objects_.end(), obj) != hovered_objects_.end();
+            }),
+            pending_objects_.end()
+        );
+        auto const left = pending_objects_.size();
+        for (auto obj : hovered_objects_)
+            if (!obj->mouseover_)
+                pending_objects_.push_back(obj);
+        for (std::size_t i = 0; i < pending_objects_.size(); ++i)
+            pending_objects_[i]->mouseover_ = i >= left;
+
+        // Fire the mouseover events. The callbacks may remove objects.
+        for (std::size_t i = 0; i < pending_objects_.size(); ++i)
+        {
+            auto obj = pending_objects_[i];
+            if (!obj)
+                continue;
+            call_mouse_callbacks(obj, i < left ? &GameObject::mouse_leave_callbacks_ : &GameObject::mouse_enter_callbacks_);
+        }
+        pending_objects_.clear();
+
+        // Only the top most object under the mouse receives the click.
+        if (Input::global().is_pressed(sf::Mouse::Left) && !hovered_objects_.empty())
+        {
+            update_order();
+            auto top = *std::max_element(hovered_objects_.begin(), hovered_objects_.end(),
+                [](GameObject* a, GameObject* b) {
+                    return a->get_z_index() < b->get_z_index();
+                }
+            );
+
+            // Among objects with equal z-index, the one that is drawn last is on top.
+            auto const z = top->get_z_index();
+            auto const first = std::lower_bound(game_objects_.begin(), game_objects_.end(), z,
+                [](auto && obj, int z) {
+                    return obj->get_z_index() < z;
+                }
+            );
+            auto const last = std::upper_bound(first, game_objects_.end(), z,
+                [](int z, auto && obj) {
+                    return z < obj->get_z_index();
+                }
+            );
+            for (auto it = last; it != first; --it)
+            {
+                if ((it - 1)->get()->mouseover_)
+                {
+                    top = (it - 1)->get();
+                    break;
+                }
+            }
+
+            pressed_object_ = top;
+            call_mouse_callbacks(top, &GameObject::click_begin_callbacks_);
+        }
+        if (Input::global().is_released(sf::Mouse::Left))
+        {
+            auto obj = pressed_object_;
+            pressed_object_ = nullptr;
+            if (obj && obj->mouseover_)
+                call_mouse_callbacks(obj, &GameObject::click_end_callbacks_);
+        }
+    }
+
+    void Screen::call_mouse_callbacks(
+        GameObject* obj,
+        std::vector<GameObject::CallbackFunction> GameObject::* callbacks
+    ){
+        // A callback that removes its own object destroys the callback
+        // list and itself, so a copy of each callback is called. Mouse
+        // events are rare, the copies do not matter.
+        auto const handle = obj->handle_;
+        for (std::size_t i = 0; i < (obj->*callbacks).size(); ++i)
+        {
+            auto const f = (obj->*callbacks)[i];
+            f(*obj);
+            if (get_game_object(handle) != obj)
+                return;
+        }
     }
 
     sf::View & Screen::get_game_view()
@@ -133,7 +709,7 @@ namespace sfe
         return resource_manager_;
     }
 
-    void Screen::add_listener(std::shared_ptr<Listener> listener)
+    void Screen::add_listener(ListenerHandle listener)
     {
         listeners_.push_back(std::move(listener));
     }
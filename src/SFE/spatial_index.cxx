@@ -0,0 +1,494 @@
+#include <SFE/spatial_index.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sfe
+{
+    std::int64_t const SpatialIndex::max_cells;
+
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// The cell coordinates are clamped to this range.
+        ////////////////////////////////////////////////////////////
+        float const max_cell_coordinate = 1 << 30;
+
+        ////////////////////////////////////////////////////////////
+        /// Marks the end of a cell list.
+        ////////////////////////////////////////////////////////////
+        std::uint32_t const no_link = 0xffffffffu;
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the rectangles overlap, including their
+        /// borders.
+        ////////////////////////////////////////////////////////////
+        bool overlaps(sf::FloatRect const & a, sf::FloatRect const & b)
+        {
+            return a.left <= b.left + b.width && b.left <= a.left + a.width
+                && a.top <= b.top + b.height && b.top <= a.top + a.height;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return whether the rectangle contains the point,
+        /// including its border.
+        ////////////////////////////////////////////////////////////
+        bool contains(sf::FloatRect const & r, sf::Vector2f const & p)
+        {
+            return r.left <= p.x && p.x <= r.left + r.width && r.top <= p.y && p.y <= r.top + r.height;
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return the distance between the point and the rectangle.
+        ////////////////////////////////////////////////////////////
+        float distance(sf::Vector2f const & p, sf::FloatRect const & r)
+        {
+            auto const dx = std::max({ r.left - p.x, 0.0f, p.x - (r.left + r.width) });
+            auto const dy = std::max({ r.top - p.y, 0.0f, p.y - (r.top + r.height) });
+            return std::sqrt(dx * dx + dy * dy);
+        }
+
+        ////////////////////////////////////////////////////////////
+        /// Return the larger side of the rectangle.
+        ////////////////////////////////////////////////////////////
+        float extent(sf::FloatRect const & r)
+        {
+            return std::max(r.width, r.height);
+        }
+    }
+
+    bool SpatialIndex::CellRange::operator==(CellRange const & other) const
+    {
+        return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+    }
+
+    SpatialIndex::SpatialIndex()
+        :
+        cell_size_(0),
+        auto_cell_size_(true),
+        free_link_(no_link),
+        extent_{ 1, 1, 0, 0 },
+        extent_dirty_(false),
+        stamp_(0)
+    {}
+
+    std::uint32_t SpatialIndex::insert(GameObject * obj, sf::FloatRect const & bounds)
+    {
+        if (cell_size_ <= 0)
+        {
+            auto const e = extent(bounds);
+            cell_size_ = e > 0 ? 2 * e : 1;
+        }
+
+        // Reuse a free entry or append a new one.
+        std::uint32_t index;
+        if (!free_entries_.empty())
+        {
+            index = free_entries_.back();
+            free_entries_.pop_back();
+            entries_[index] = { obj, bounds, {}, false };
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(entries_.size());
+            entries_.push_back({ obj, bounds, {}, false });
+        }
+        link(index);
+
+        // Adapt the automatic cell size to the typical object size
+        // from time to time.
+        auto const n = size();
+        if (auto_cell_size_ && n >= 16 && (n & (n - 1)) == 0)
+        {
+            std::vector<float> extents;
+            extents.reserve(n);
+            for (auto const & entry : entries_)
+                if (entry.obj)
+                    extents.push_back(extent(entry.bounds));
+            std::nth_element(extents.begin(), extents.begin() + n / 2, extents.end());
+            auto const cell_size = extents[n / 2] > 0 ? 2 * extents[n / 2] : cell_size_;
+            if (cell_size > 4 * cell_size_ || 4 * cell_size < cell_size_)
+            {
+                cell_size_ = cell_size;
+                rebuild();
+            }
+        }
+        return index;
+    }
+
+    void SpatialIndex::update(std::uint32_t entry, sf::FloatRect const & bounds)
+    {
+        auto & e = entries_[entry];
+        e.bounds = bounds;
+        if (get_cells(bounds) == e.cells)
+            return;
+        unlink(entry);
+        link(entry);
+    }
+
+    void SpatialIndex::remove(std::uint32_t entry)
+    {
+        // Free the entry. The other entries keep their place, so
+        // only the cells of the removed entry are touched.
+        unlink(entry);
+        entries_[entry].obj = nullptr;
+        free_entries_.push_back(entry);
+    }
+
+    void SpatialIndex::clear()
+    {
+        entries_.clear();
+        free_entries_.clear();
+        cells_.clear();
+        links_.clear();
+        free_link_ = no_link;
+        large_.clear();
+        extent_ = { 1, 1, 0, 0 };
+        extent_dirty_ = false;
+    }
+
+    std::size_t SpatialIndex::size() const
+    {
+        return entries_.size() - free_entries_.size();
+    }
+
+    float SpatialIndex::get_cell_size() const
+    {
+        return cell_size_;
+    }
+
+    void SpatialIndex::set_cell_size(float cell_size)
+    {
+        cell_size_ = cell_size;
+        auto_cell_size_ = cell_size <= 0;
+        if (auto_cell_size_)
+        {
+            // Choose the cell size from the current objects.
+            std::vector<float> extents;
+            for (auto const & entry : entries_)
+                if (entry.obj)
+                    extents.push_back(extent(entry.bounds));
+            cell_size_ = 1;
+            if (!extents.empty())
+            {
+                std::nth_element(extents.begin(), extents.begin() + extents.size() / 2, extents.end());
+                if (extents[extents.size() / 2] > 0)
+                    cell_size_ = 2 * extents[extents.size() / 2];
+            }
+        }
+        rebuild();
+    }
+
+    void SpatialIndex::query_point(sf::Vector2f const & point, std::vector<GameObject*> & result) const
+    {
+        for (auto const e : large_)
+            if (contains(entries_[e].bounds, point))
+                result.push_back(entries_[e].obj);
+
+        if (size() == 0)
+            return;
+        auto const cells = get_cells({ point, { 0, 0 } });
+        auto const it = cells_.find(cell_key(cells.x0, cells.y0));
+        if (it == cells_.end())
+            return;
+        for (auto l = it->second; l != no_link; l = links_[l].next)
+        {
+            auto const e = links_[l].entry;
+            if (contains(entries_[e].bounds, point))
+                result.push_back(entries_[e].obj);
+        }
+    }
+
+    void SpatialIndex::query_rect(sf::FloatRect const & rect, std::vector<GameObject*> & result) const
+    {
+        for (auto const e : large_)
+            if (overlaps(entries_[e].bounds, rect))
+                result.push_back(entries_[e].obj);
+
+        if (size() == 0)
+            return;
+        update_extent();
+        auto cells = get_cells(rect);
+        cells.x0 = std::max(cells.x0, extent_.x0);
+        cells.y0 = std::max(cells.y0, extent_.y0);
+        cells.x1 = std::min(cells.x1, extent_.x1);
+        cells.y1 = std::min(cells.y1, extent_.y1);
+        if (cells.x0 > cells.x1 || cells.y0 > cells.y1)
+            return;
+
+        // Large rectangles are faster answered by checking all entries.
+        auto const count = static_cast<std::int64_t>(cells.x1 - cells.x0 + 1) * (cells.y1 - cells.y0 + 1);
+        if (count > static_cast<std::int64_t>(entries_.size()))
+        {
+            for (auto const & entry : entries_)
+                if (entry.obj && !entry.large && overlaps(entry.bounds, rect))
+                    result.push_back(entry.obj);
+            return;
+        }
+
+        auto const stamp = next_stamp();
+        for (auto y = cells.y0; y <= cells.y1; ++y)
+        {
+            for (auto x = cells.x0; x <= cells.x1; ++x)
+            {
+                auto const it = cells_.find(cell_key(x, y));
+                if (it == cells_.end())
+                    continue;
+                for (auto l = it->second; l != no_link; l = links_[l].next)
+                {
+                    auto const e = links_[l].entry;
+                    if (stamps_[e] == stamp)
+                        continue;
+                    stamps_[e] = stamp;
+                    if (overlaps(entries_[e].bounds, rect))
+                        result.push_back(entries_[e].obj);
+                }
+            }
+        }
+    }
+
+    GameObject * SpatialIndex::query_nearest(sf::Vector2f const & point, float max_distance) const
+    {
+        GameObject * nearest = nullptr;
+        auto best = max_distance;
+        auto const check = [&](std::uint32_t e)
+        {
+            auto const d = distance(point, entries_[e].bounds);
+            if (d <= best && (d < best || !nearest))
+            {
+                best = d;
+                nearest = entries_[e].obj;
+            }
+        };
+
+        for (auto const e : large_)
+            check(e);
+        if (size() == 0)
+            return nearest;
+        update_extent();
+        if (extent_.x0 > extent_.x1)
+            return nearest;
+
+        // Search the cells in rings around the point, starting with
+        // the first ring that reaches the occupied cells and visiting
+        // only the part of each ring inside them. Each object is
+        // stored in the cell of its point that is closest to the
+        // query point, so ring r cannot contain objects closer than
+        // (r - 1) cells. The coordinates are 64 bit, so the rings
+        // cannot overflow.
+        auto const center = get_cells({ point, { 0, 0 } });
+        std::int64_t const cx = center.x0;
+        std::int64_t const cy = center.y0;
+        std::int64_t const x0 = extent_.x0;
+        std::int64_t const y0 = extent_.y0;
+        std::int64_t const x1 = extent_.x1;
+        std::int64_t const y1 = extent_.y1;
+        auto const visit = [&](std::int64_t x, std::int64_t y)
+        {
+            auto const it = cells_.find(cell_key(static_cast<std::int32_t>(x), static_cast<std::int32_t>(y)));
+            if (it != cells_.end())
+                for (auto l = it->second; l != no_link; l = links_[l].next)
+                    check(links_[l].entry);
+        };
+        auto const visit_row = [&](std::int64_t y, std::int64_t r)
+        {
+            if (y < y0 || y > y1)
+                return;
+            for (auto x = std::max(cx - r, x0), last = std::min(cx + r, x1); x <= last; ++x)
+                visit(x, y);
+        };
+        auto const visit_column = [&](std::int64_t x, std::int64_t r)
+        {
+            if (x < x0 || x > x1)
+                return;
+            for (auto y = std::max(cy - r + 1, y0), last = std::min(cy + r - 1, y1); y <= last; ++y)
+                visit(x, y);
+        };
+        auto const first = std::max({ x0 - cx, cx - x1, y0 - cy, cy - y1, std::int64_t(0) });
+        for (auto r = first; ; ++r)
+        {
+            if (r > 1 && (r - 1) * cell_size_ > best)
+                break;
+            if (r == 0)
+            {
+                visit(cx, cy);
+            }
+            else
+            {
+                visit_row(cy - r, r);
+                visit_row(cy + r, r);
+                visit_column(cx - r, r);
+                visit_column(cx + r, r);
+            }
+
+            // Stop when the ring encloses all occupied cells.
+            if (cx - r <= x0 && cx + r >= x1 && cy - r <= y0 && cy + r >= y1)
+                break;
+        }
+        return nearest;
+    }
+
+    SpatialIndex::CellRange SpatialIndex::get_cells(sf::FloatRect const & bounds) const
+    {
+        auto const cell = [this](float v)
+        {
+            auto const c = std::floor(v / cell_size_);
+            return static_cast<std::int32_t>(std::max(-max_cell_coordinate, std::min(c, max_cell_coordinate)));
+        };
+        return {
+            cell(bounds.left),
+            cell(bounds.top),
+            cell(bounds.left + bounds.width),
+            cell(bounds.top + bounds.height)
+        };
+    }
+
+    std::uint64_t SpatialIndex::cell_key(std::int32_t x, std::int32_t y)
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+    }
+
+    void SpatialIndex::link(std::uint32_t e)
+    {
+        auto & entry = entries_[e];
+        entry.cells = get_cells(entry.bounds);
+        auto const & c = entry.cells;
+        auto const count = static_cast<std::int64_t>(c.x1 - c.x0 + 1) * (c.y1 - c.y0 + 1);
+        entry.large = count > max_cells;
+        if (entry.large)
+        {
+            large_.push_back(e);
+            return;
+        }
+
+        for (auto y = c.y0; y <= c.y1; ++y)
+        {
+            for (auto x = c.x0; x <= c.x1; ++x)
+            {
+                auto const key = cell_key(x, y);
+                auto it = cells_.find(key);
+                if (it == cells_.end())
+                    it = cells_.emplace(key, no_link).first;
+                auto & head = it->second;
+                auto l = free_link_;
+                if (l != no_link)
+                {
+                    free_link_ = links_[l].next;
+                }
+                else
+                {
+                    l = static_cast<std::uint32_t>(links_.size());
+                    links_.emplace_back();
+                }
+                links_[l] = { e, head };
+                head = l;
+            }
+        }
+
+        if (extent_.x0 > extent_.x1)
+        {
+            extent_ = c;
+        }
+        else
+        {
+            extent_.x0 = std::min(extent_.x0, c.x0);
+            extent_.y0 = std::min(extent_.y0, c.y0);
+            extent_.x1 = std::max(extent_.x1, c.x1);
+            extent_.y1 = std::max(extent_.y1, c.y1);
+        }
+    }
+
+    void SpatialIndex::unlink(std::uint32_t e)
+    {
+        auto const & entry = entries_[e];
+        if (entry.large)
+        {
+            auto const it = std::find(large_.begin(), large_.end(), e);
+            if (it != large_.end())
+            {
+                *it = large_.back();
+                large_.pop_back();
+            }
+            return;
+        }
+
+        // Empty cells are kept and the links are reused, so moving
+        // and spawning objects do not allocate.
+        auto const & c = entry.cells;
+        if (c.x0 == extent_.x0 || c.y0 == extent_.y0 || c.x1 == extent_.x1 || c.y1 == extent_.y1)
+            extent_dirty_ = true;
+        for (auto y = c.y0; y <= c.y1; ++y)
+        {
+            for (auto x = c.x0; x <= c.x1; ++x)
+            {
+                auto const it = cells_.find(cell_key(x, y));
+                if (it == cells_.end())
+                    continue;
+                for (auto p = &it->second; *p != no_link; p = &links_[*p].next)
+                {
+                    auto const l = *p;
+                    if (links_[l].entry == e)
+                    {
+                        *p = links_[l].next;
+                        links_[l].next = free_link_;
+                        free_link_ = l;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void SpatialIndex::rebuild()
+    {
+        cells_.clear();
+        links_.clear();
+        free_link_ = no_link;
+        large_.clear();
+        extent_ = { 1, 1, 0, 0 };
+        extent_dirty_ = false;
+        for (std::uint32_t e = 0; e < entries_.size(); ++e)
+            if (entries_[e].obj)
+                link(e);
+    }
+
+    void SpatialIndex::update_extent() const
+    {
+        if (!extent_dirty_)
+            return;
+
+        extent_ = { 1, 1, 0, 0 };
+        for (auto const & entry : entries_)
+        {
+            if (!entry.obj || entry.large)
+                continue;
+            auto const & c = entry.cells;
+            if (extent_.x0 > extent_.x1)
+            {
+                extent_ = c;
+            }
+            else
+            {
+                extent_.x0 = std::min(extent_.x0, c.x0);
+                extent_.y0 = std::min(extent_.y0, c.y0);
+                extent_.x1 = std::max(extent_.x1, c.x1);
+                extent_.y1 = std::max(extent_.y1, c.y1);
+            }
+        }
+        extent_dirty_ = false;
+    }
+
+    std::uint32_t SpatialIndex::next_stamp() const
+    {
+        if (stamps_.size() < entries_.size())
+            stamps_.resize(entries_.size(), 0);
+        ++stamp_;
+        if (stamp_ == 0)
+        {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            stamp_ = 1;
+        }
+        return stamp_;
+    }
+
+} // namespace sfe
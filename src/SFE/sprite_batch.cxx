@@ -0,0 +1,144 @@
+#include <SFE/sprite_batch.hxx>
+#include <SFE/render_commands.hxx>
+
+#include <cmath>
+#include <utility>
+
+namespace sfe
+{
+    SpriteBatch::SpriteBatch()
+        :
+        target_(nullptr),
+        commands_(nullptr),
+        texture_(nullptr),
+        vertices_(sf::Triangles),
+        draw_calls_(0)
+    {}
+
+    void SpriteBatch::begin(sf::RenderTarget & target)
+    {
+        target_ = &target;
+        commands_ = nullptr;
+        texture_ = nullptr;
+        vertices_.clear();
+        draw_calls_ = 0;
+    }
+
+    void SpriteBatch::begin(RenderCommands & commands)
+    {
+        target_ = nullptr;
+        commands_ = &commands;
+        texture_ = nullptr;
+        vertices_.clear();
+        draw_calls_ = 0;
+    }
+
+    void SpriteBatch::end()
+    {
+        flush();
+    }
+
+    void SpriteBatch::draw(
+        sf::Texture const & texture,
+        sf::IntRect const & texture_rect,
+        sf::Vector2f const & position,
+        sf::Vector2f const & size,
+        float rotation,
+        bool mirror_x,
+        bool mirror_y
+    ){
+        if (&texture != texture_)
+        {
+            flush();
+            texture_ = &texture;
+        }
+
+        // Rotate the corners around the center.
+        auto const half = 0.5f * size;
+        auto const angle = rotation * 3.14159265f / 180.0f;
+        auto const c = std::cos(angle);
+        auto const s = std::sin(angle);
+        auto const corner = [&](float x, float y)
+        {
+            return sf::Vector2f(position.x + c * x - s * y, position.y + s * x + c * y);
+        };
+        auto const tl = corner(-half.x, -half.y);
+        auto const tr = corner(half.x, -half.y);
+        auto const br = corner(half.x, half.y);
+        auto const bl = corner(-half.x, half.y);
+
+        // Mirroring swaps the texture coordinates.
+        auto left = static_cast<float>(texture_rect.left);
+        auto top = static_cast<float>(texture_rect.top);
+        auto right = left + texture_rect.width;
+        auto bottom = top + texture_rect.height;
+        if (mirror_x)
+            std::swap(left, right);
+        if (mirror_y)
+            std::swap(top, bottom);
+
+        vertices_.append(sf::Vertex(tl, sf::Vector2f(left, top)));
+        vertices_.append(sf::Vertex(tr, sf::Vector2f(right, top)));
+        vertices_.append(sf::Vertex(br, sf::Vector2f(right, bottom)));
+        vertices_.append(sf::Vertex(tl, sf::Vector2f(left, top)));
+        vertices_.append(sf::Vertex(br, sf::Vector2f(right, bottom)));
+        vertices_.append(sf::Vertex(bl, sf::Vector2f(left, bottom)));
+    }
+
+    void SpriteBatch::draw(sf::FloatRect const & rect, sf::Color const & color)
+    {
+        if (texture_)
+        {
+            flush();
+            texture_ = nullptr;
+        }
+
+        sf::Vector2f const tl(rect.left, rect.top);
+        sf::Vector2f const tr(rect.left + rect.width, rect.top);
+        sf::Vector2f const br(rect.left + rect.width, rect.top + rect.height);
+        sf::Vector2f const bl(rect.left, rect.top + rect.height);
+        vertices_.append(sf::Vertex(tl, color));
+        vertices_.append(sf::Vertex(tr, color));
+        vertices_.append(sf::Vertex(br, color));
+        vertices_.append(sf::Vertex(tl, color));
+        vertices_.append(sf::Vertex(br, color));
+        vertices_.append(sf::Vertex(bl, color));
+    }
+
+    void SpriteBatch::set_view(sf::View const & view)
+    {
+        flush();
+        if (commands_)
+            commands_->set_view(view);
+        else
+            target_->setView(view);
+    }
+
+    void SpriteBatch::flush()
+    {
+        if (vertices_.getVertexCount() == 0)
+            return;
+        if (commands_)
+            commands_->draw(&vertices_[0], vertices_.getVertexCount(), sf::Triangles, sf::RenderStates(texture_));
+        else
+            target_->draw(vertices_, sf::RenderStates(texture_));
+        vertices_.clear();
+        ++draw_calls_;
+    }
+
+    bool SpriteBatch::is_recording() const
+    {
+        return commands_ != nullptr;
+    }
+
+    sf::RenderTarget & SpriteBatch::get_target() const
+    {
+        return *target_;
+    }
+
+    std::size_t SpriteBatch::get_draw_calls() const
+    {
+        return draw_calls_;
+    }
+
+} // namespace sfe
@@ -0,0 +1,217 @@
+#include <SFE/texture_atlas.hxx>
+#include <SFE/resource_manager.hxx>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace sfe
+{
+    TextureRegion::TextureRegion()
+        :
+        rect(0, 0, 0, 0)
+    {}
+
+    TextureRegion::TextureRegion(std::shared_ptr<sf::Texture> const& texture)
+        :
+        texture(texture),
+        rect({ 0, 0 }, sf::Vector2i(texture->getSize()))
+    {}
+
+    TextureRegion::TextureRegion(std::shared_ptr<sf::Texture> const& texture, sf::IntRect const& rect)
+        :
+        texture(texture),
+        rect(rect)
+    {}
+
+    sf::Vector2i TextureRegion::get_size() const
+    {
+        return { rect.width, rect.height };
+    }
+
+    TextureAtlas::TextureAtlas(unsigned int page_size)
+        :
+        page_size_(page_size)
+    {}
+
+    void TextureAtlas::add(std::string const & name, sf::Image const & image)
+    {
+        pending_.emplace_back(name, image);
+    }
+
+    void TextureAtlas::build(bool smooth)
+    {
+        if (pending_.empty())
+            return;
+
+        auto const max_size = std::min(page_size_, sf::Texture::getMaximumSize());
+
+        // Place the large images first, this packs much tighter.
+        std::vector<std::size_t> order(pending_.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [this](std::size_t a, std::size_t b) {
+                auto const size_a = pending_[a].second.getSize();
+                auto const size_b = pending_[b].second.getSize();
+                return size_a.y > size_b.y || (size_a.y == size_b.y && size_a.x > size_b.x);
+            }
+        );
+
+        // Assign the images to pages. Each image gets a border of
+        // one pixel.
+        std::vector<Page> pages;
+        for (auto const i : order)
+        {
+            auto const size = pending_[i].second.getSize() + sf::Vector2u(2, 2);
+            std::size_t segment = 0;
+            sf::Vector2u pos;
+            auto page = std::find_if(pages.begin(), pages.end(),
+                [&](Page const & p) {
+                    return find_position(p, size, segment, pos);
+                }
+            );
+            if (page == pages.end())
+            {
+                // Open a new page. Too large images get a page of their own.
+                Page p;
+                p.width = std::max(max_size, size.x);
+                p.height = std::max(max_size, size.y);
+                p.skyline.push_back({ 0, 0, p.width });
+                pages.push_back(std::move(p));
+                page = pages.end() - 1;
+                find_position(*page, size, segment, pos);
+            }
+            place(*page, segment, pos, size);
+            page->images.push_back(i);
+            page->positions.push_back(pos);
+        }
+
+        // Create the page textures. The page height is cut to the
+        // used height.
+        for (auto const & page : pages)
+        {
+            unsigned int height = 0;
+            for (auto const & s : page.skyline)
+                height = std::max(height, s.y);
+
+            sf::Image image;
+            image.create(page.width, height, sf::Color(0, 0, 0, 0));
+            for (std::size_t k = 0; k < page.images.size(); ++k)
+            {
+                auto const & source = pending_[page.images[k]].second;
+                auto const size = sf::Vector2i(source.getSize());
+                auto const x = page.positions[k].x;
+                auto const y = page.positions[k].y;
+                image.copy(source, x + 1, y + 1);
+                if (size.x > 0 && size.y > 0)
+                {
+                    image.copy(source, x, y + 1, { 0, 0, 1, size.y });
+                    image.copy(source, x + size.x + 1, y + 1, { size.x - 1, 0, 1, size.y });
+                    image.copy(source, x + 1, y, { 0, 0, size.x, 1 });
+                    image.copy(source, x + 1, y + size.y + 1, { 0, size.y - 1, size.x, 1 });
+                }
+            }
+
+            auto texture = std::make_shared<sf::Texture>();
+            if (!texture->loadFromImage(image))
+                throw ResourceException("TextureAtlas::build(): Could not create a texture of size "
+                    + std::to_string(page.width) + "x" + std::to_string(height) + ".");
+            texture->setSmooth(smooth);
+            pages_.push_back(texture);
+
+            for (std::size_t k = 0; k < page.images.size(); ++k)
+            {
+                auto const & entry = pending_[page.images[k]];
+                sf::IntRect const rect(page.positions[k].x + 1, page.positions[k].y + 1,
+                                       entry.second.getSize().x, entry.second.getSize().y);
+                regions_[entry.first] = TextureRegion(texture, rect);
+            }
+        }
+        pending_.clear();
+    }
+
+    bool TextureAtlas::contains(std::string const & name) const
+    {
+        return regions_.find(name) != regions_.end();
+    }
+
+    TextureRegion const & TextureAtlas::get_region(std::string const & name) const
+    {
+        auto const it = regions_.find(name);
+        if (it == regions_.end())
+            throw ResourceException("TextureAtlas::get_region(): Unknown image " + name);
+        return it->second;
+    }
+
+    std::vector<std::shared_ptr<sf::Texture>> const & TextureAtlas::get_pages() const
+    {
+        return pages_;
+    }
+
+    bool TextureAtlas::find_position(Page const & page, sf::Vector2u const & size, std::size_t & segment, sf::Vector2u & pos)
+    {
+        auto best_y = std::numeric_limits<unsigned int>::max();
+        for (std::size_t i = 0; i < page.skyline.size(); ++i)
+        {
+            auto const x = page.skyline[i].x;
+            if (x + size.x > page.width)
+                break;
+
+            // The rectangle rests on the highest segment below it.
+            unsigned int y = 0;
+            unsigned int covered = 0;
+            for (auto j = i; covered < size.x; ++j)
+            {
+                y = std::max(y, page.skyline[j].y);
+                covered += page.skyline[j].width;
+            }
+            if (y + size.y > page.height || y >= best_y)
+                continue;
+
+            best_y = y;
+            segment = i;
+            pos = { x, y };
+        }
+        return best_y != std::numeric_limits<unsigned int>::max();
+    }
+
+    void TextureAtlas::place(Page & page, std::size_t segment, sf::Vector2u const & pos, sf::Vector2u const & size)
+    {
+        auto & skyline = page.skyline;
+        skyline.insert(skyline.begin() + segment, { pos.x, pos.y + size.y, size.x });
+
+        // Cut the segments below the new one.
+        auto const end = pos.x + size.x;
+        auto i = segment + 1;
+        while (i < skyline.size() && skyline[i].x < end)
+        {
+            auto const segment_end = skyline[i].x + skyline[i].width;
+            if (segment_end <= end)
+            {
+                skyline.erase(skyline.begin() + i);
+            }
+            else
+            {
+                skyline[i].x = end;
+                skyline[i].width = segment_end - end;
+                break;
+            }
+        }
+
+        // Merge neighbours of the same height.
+        for (std::size_t k = 0; k + 1 < skyline.size(); )
+        {
+            if (skyline[k].y == skyline[k + 1].y)
+            {
+                skyline[k].width += skyline[k + 1].width;
+                skyline.erase(skyline.begin() + k + 1);
+            }
+            else
+            {
+                ++k;
+            }
+        }
+    }
+
+} // namespace sfe
@@ -0,0 +1,188 @@
+#include <SFE/timer_wheel.hxx>
+
+#include <algorithm>
+
+namespace sfe
+{
+
+    std::uint32_t const TimerWheel::num_slots;
+
+    std::uint32_t const TimerWheel::npos;
+
+    TimerWheel::TimerWheel()
+        :
+        free_(npos),
+        current_tick_(0),
+        remainder_us_(0),
+        size_(0)
+    {
+        slots_.fill(npos);
+    }
+
+    TimerId TimerWheel::add(Event const& event, sf::Time delay, sf::Time interval)
+    {
+        // Round the times up to full ticks. Timers fire on the next tick at
+        // the earliest.
+        auto const to_ticks = [](sf::Time t) -> std::uint64_t
+        {
+            auto const us = std::max<sf::Int64>(t.asMicroseconds(), 0);
+            return static_cast<std::uint64_t>((us + 999) / 1000);
+        };
+
+        // Reuse an unused timer or append a new one.
+        std::uint32_t index;
+        if (free_ != npos)
+        {
+            index = free_;
+            free_ = timers_[index].next;
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(timers_.size());
+            timers_.push_back(Timer{ event, 0, 0, 1, npos, npos, npos });
+        }
+
+        auto & timer = timers_[index];
+        timer.event = event;
+        timer.expiry = current_tick_ + std::max<std::uint64_t>(to_ticks(delay), 1);
+        timer.interval = interval > sf::Time::Zero ? std::max<std::uint64_t>(to_ticks(interval), 1) : 0;
+        insert(index);
+        ++size_;
+        return (static_cast<TimerId>(timer.generation) << 32) | index;
+    }
+
+    bool TimerWheel::cancel(TimerId id)
+    {
+        auto const index = static_cast<std::uint32_t>(id & 0xffffffffu);
+        auto const generation = static_cast<std::uint32_t>(id >> 32);
+        if (index >= timers_.size())
+            return false;
+        auto & timer = timers_[index];
+        if (timer.generation != generation || timer.slot == npos)
+            return false;
+
+        // Invalidate the id and put the timer into the free list.
+        unlink(index);
+        ++timer.generation;
+        timer.next = free_;
+        free_ = index;
+        --size_;
+        return true;
+    }
+
+    void TimerWheel::advance(sf::Time elapsed_time, std::vector<Event> & fired)
+    {
+        remainder_us_ += elapsed_time.asMicroseconds();
+        auto const ticks = remainder_us_ / 1000;
+        remainder_us_ -= ticks * 1000;
+
+        // Without timers, there is nothing to cascade or fire.
+        if (size_ == 0)
+        {
+            current_tick_ += static_cast<std::uint64_t>(ticks);
+            return;
+        }
+        for (sf::Int64 i = 0; i < ticks; ++i)
+            tick(fired);
+    }
+
+    std::size_t TimerWheel::size() const
+    {
+        return size_;
+    }
+
+    void TimerWheel::insert(std::uint32_t index)
+    {
+        auto & timer = timers_[index];
+        auto expiry = timer.expiry;
+        if (expiry < current_tick_)
+            expiry = current_tick_;
+
+        // Find the finest level whose range covers the expiry. Timers beyond
+        // the range of the highest level are parked in its last reachable
+        // slot and moved on when that slot is cascaded.
+        auto const delta = expiry - current_tick_;
+        int level = 0;
+        while (level < num_levels - 1 && delta >= (std::uint64_t(1) << (slot_bits * (level + 1))))
+            ++level;
+        auto const max_delta = (std::uint64_t(1) << (slot_bits * num_levels)) - 1;
+        if (delta > max_delta)
+            expiry = current_tick_ + max_delta;
+        auto const slot = level * num_slots + static_cast<std::uint32_t>((expiry >> (slot_bits * level)) & (num_slots - 1));
+
+        // Push the timer to the front of the slot list.
+        timer.slot = slot;
+        timer.prev = npos;
+        timer.next = slots_[slot];
+        if (timer.next != npos)
+            timers_[timer.next].prev = index;
+        slots_[slot] = index;
+    }
+
+    void TimerWheel::unlink(std::uint32_t index)
+    {
+        auto & timer = timers_[index];
+        if (timer.prev != npos)
+            timers_[timer.prev].next = timer.next;
+        else
+            slots_[timer.slot] = timer.next;
+        if (timer.next != npos)
+            timers_[timer.next].prev = timer.prev;
+        timer.slot = npos;
+        timer.prev = npos;
+        timer.next = npos;
+    }
+
+    void TimerWheel::cascade(int level, std::uint32_t slot)
+    {
+        auto index = slots_[level * num_slots + slot];
+        slots_[level * num_slots + slot] = npos;
+        while (index != npos)
+        {
+            auto const next = timers_[index].next;
+            insert(index);
+            index = next;
+        }
+    }
+
+    void TimerWheel::tick(std::vector<Event> & fired)
+    {
+        ++current_tick_;
+
+        // Whenever the index of a level wraps around, the next slot of the
+        // level above is moved down.
+        for (int level = 1; level < num_levels; ++level)
+        {
+            if (((current_tick_ >> (slot_bits * (level - 1))) & (num_slots - 1)) != 0)
+                break;
+            cascade(level, static_cast<std::uint32_t>((current_tick_ >> (slot_bits * level)) & (num_slots - 1)));
+        }
+
+        // Fire the timers of the current slot. Repeating timers are inserted
+        // again, all others are put into the free list.
+        auto const slot = static_cast<std::uint32_t>(current_tick_ & (num_slots - 1));
+        auto index = slots_[slot];
+        slots_[slot] = npos;
+        while (index != npos)
+        {
+            auto & timer = timers_[index];
+            auto const next = timer.next;
+            fired.push_back(timer.event);
+            if (timer.interval > 0)
+            {
+                timer.expiry += timer.interval;
+                insert(index);
+            }
+            else
+            {
+                timer.slot = npos;
+                ++timer.generation;
+                timer.next = free_;
+                free_ = index;
+                --size_;
+            }
+            index = next;
+        }
+    }
+
+} // namespace sfe
@@ -2,6 +2,9 @@
 
 #include <boost/filesystem.hpp>
 
+#include <iomanip>
+#include <ostream>
+
 namespace sfe
 {
 
@@ -11,4 +14,29 @@ namespace sfe
         return p.generic_string();
     }
 
+    void write_json_string(std::ostream & out, std::string const & s)
+    {
+        out << '"';
+        for (auto c : s)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                auto const flags = out.flags();
+                auto const fill = out.fill('0');
+                out << "\\u" << std::hex << std::setw(4) << static_cast<int>(c);
+                out.flags(flags);
+                out.fill(fill);
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
 } // namespace sfe
@@ -1,13 +1,32 @@
 #include <SFE/widget.hxx>
 #include <SFE/event_manager.hxx>
+#include <SFE/game.hxx>
 #include <SFE/input.hxx>
+#include <SFE/object_pool.hxx>
 
 #include <algorithm>
 #include <string>
+#include <typeinfo>
 
 namespace sfe
 {
 
+    namespace
+    {
+        ////////////////////////////////////////////////////////////
+        /// Return the smallest rectangle that contains both
+        /// rectangles.
+        ////////////////////////////////////////////////////////////
+        sf::FloatRect unite(sf::FloatRect const & a, sf::FloatRect const & b)
+        {
+            auto const left = std::min(a.left, b.left);
+            auto const top = std::min(a.top, b.top);
+            auto const right = std::max(a.left + a.width, b.left + b.width);
+            auto const bottom = std::max(a.top + a.height, b.top + b.height);
+            return { left, top, right - left, bottom - top };
+        }
+    }
+
     float Widget::viewport_ratio = 1.0f;
 
     Widget::Widget()
@@ -22,22 +41,103 @@ namespace sfe
         mouseover_(false),
         mousedown_(false),
         absorb_click_(false),
-        remove_this_(false)
+        remove_this_(false),
+        order_dirty_(false),
+        removal_pending_(false),
+        layout_parent_rect_({0.0f, 0.0f, 1.0f, 1.0f}),
+        layout_ratio_(viewport_ratio),
+        mouse_active_(false),
+        layout_dirty_(true),
+        subtree_dirty_(false),
+        mouse_dirty_(true),
+        parent_(nullptr)
     {}
 
+    Widget::Widget(Widget && other)
+        :
+        Widget()
+    {
+        *this = std::move(other);
+    }
+
+    Widget& Widget::operator=(Widget && other)
+    {
+        rect_ = other.rect_;
+        render_rect_ = other.render_rect_;
+        visible_ = other.visible_;
+        z_index_ = other.z_index_;
+        align_x_ = other.align_x_;
+        align_y_ = other.align_y_;
+        scale_ = other.scale_;
+        ratio_ = other.ratio_;
+        mouseover_ = other.mouseover_;
+        mousedown_ = other.mousedown_;
+        absorb_click_ = other.absorb_click_;
+        remove_this_ = other.remove_this_;
+        mouse_active_ = other.mouse_active_;
+        order_dirty_ = other.order_dirty_;
+        removal_pending_ = other.removal_pending_;
+        widgets_ = std::move(other.widgets_);
+        mouse_enter_callbacks_ = std::move(other.mouse_enter_callbacks_);
+        mouse_leave_callbacks_ = std::move(other.mouse_leave_callbacks_);
+        click_begin_callbacks_ = std::move(other.click_begin_callbacks_);
+        click_end_callbacks_ = std::move(other.click_end_callbacks_);
+        listeners_ = std::move(other.listeners_);
+
+        // The subwidgets have a new parent.
+        for (auto const & w : widgets_)
+            w->parent_ = this;
+        mark_layout_dirty();
+        return *this;
+    }
+
     Widget::~Widget() = default;
 
+    void* Widget::operator new(std::size_t size)
+    {
+        return ObjectPool::global().allocate(size);
+    }
+
+    void Widget::operator delete(void* p, std::size_t size)
+    {
+        ObjectPool::global().deallocate(p, size);
+    }
+
+#ifdef __cpp_aligned_new
+    void* Widget::operator new(std::size_t size, std::align_val_t alignment)
+    {
+        return ::operator new(size, alignment);
+    }
+
+    void Widget::operator delete(void* p, std::size_t size, std::align_val_t alignment)
+    {
+        ::operator delete(p, size, alignment);
+    }
+#endif
+
     Widget* Widget::add_widget(std::unique_ptr<Widget> w)
     {
         auto ret = w.get();
 
-        // Use insertion sort with respect to the z-index.
-        auto comp = [](auto && a, auto && b)
+        // Use insertion sort with respect to the z-index, unless the
+        // subwidgets are sorted in the next update anyway.
+        if (order_dirty_)
         {
-            return a->get_z_index() < b->get_z_index();
-        };
-        auto it = std::lower_bound(widgets_.begin(), widgets_.end(), w, comp);
-        widgets_.insert(it, std::move(w));
+            widgets_.push_back(std::move(w));
+        }
+        else
+        {
+            auto comp = [](auto && a, auto && b)
+            {
+                return a->get_z_index() < b->get_z_index();
+            };
+            auto it = std::lower_bound(widgets_.begin(), widgets_.end(), w, comp);
+            widgets_.insert(it, std::move(w));
+        }
+        if (ret->remove_this_)
+            removal_pending_ = true;
+        ret->parent_ = this;
+        ret->mark_layout_dirty();
         return ret;
     }
 
@@ -52,6 +152,8 @@ namespace sfe
         {
             auto wptr = std::move(*it);
             widgets_.erase(it);
+            wptr->parent_ = nullptr;
+            mark_layout_dirty();
             return wptr;
         }
         else
@@ -63,18 +165,39 @@ namespace sfe
     void Widget::remove_from_parent()
     {
         remove_this_ = true;
+        if (parent_)
+            parent_->removal_pending_ = true;
     }
 
     void Widget::clear_widgets()
     {
         widgets_.clear();
+        mark_layout_dirty();
     }
 
     bool Widget::update_mouse(float x, float y)
     {
+        mouse_dirty_ = false;
+        return update_mouse(x, y, false);
+    }
+
+    bool Widget::needs_mouse_update() const
+    {
+        return mouse_dirty_;
+    }
+
+    bool Widget::update_mouse(float x, float y, bool occluded)
+    {
+        // Skip subtrees that cannot contain the mouse and have no
+        // state to reset. Hidden widgets are treated as occluded.
+        auto const hidden = occluded || !visible_;
+        auto const inside = !hidden && bounds_.contains(x, y);
+        if (!inside && !mouse_active_)
+            return false;
+
         // Update the mouseoverstate.
         auto old_mouseover = mouseover_;
-        mouseover_ = render_rect_.contains(x, y);
+        mouseover_ = inside && render_rect_.contains(x, y);
 
         // Fire the mouseover events.
         if (!old_mouseover && mouseover_)
@@ -84,11 +207,16 @@ namespace sfe
             for (auto const & f : mouse_leave_callbacks_)
                 f(*this);
 
-        // Update the subwidgets.
+        // Update the subwidgets from the topmost one down.
         bool handled = false;
-        for (auto const & w : widgets_)
-            if (w->update_mouse(x, y))
+        bool active = false;
+        for (auto it = widgets_.rbegin(); it != widgets_.rend(); ++it)
+        {
+            if ((*it)->update_mouse(x, y, hidden || handled))
                 handled = true;
+            if ((*it)->mouse_active_)
+                active = true;
+        }
 
         // Fire the click callbacks.
         if (!handled)
@@ -105,8 +233,9 @@ namespace sfe
                     f(*this);
             }
         }
-        if (sfe::Input::global().is_released(sf::Mouse::Left))
+        if (!visible_ || sfe::Input::global().is_released(sf::Mouse::Left))
             mousedown_ = false;
+        mouse_active_ = mouseover_ || mousedown_ || active;
 
         // Check if the click should be absorbed.
         if (mouseover_ && absorb_click_)
@@ -119,31 +248,76 @@ namespace sfe
     {
         // Update this widget and the subwidgets.
         update_impl(elapsed_time);
-        sort_widgets();
+        if (order_dirty_)
+        {
+            sort_widgets();
+            order_dirty_ = false;
+        }
         for (auto const & w : widgets_)
             w->update(elapsed_time);
 
-        //// Remove subwidgets that are marked for removal.
-        widgets_.erase(
-            std::remove_if(widgets_.begin(), widgets_.end(), [](auto && w) {
-                return w->remove_this_;
-            }),
-            widgets_.end()
-        );
+        // Remove subwidgets that are marked for removal.
+        if (removal_pending_)
+        {
+            widgets_.erase(
+                std::remove_if(widgets_.begin(), widgets_.end(), [](auto && w) {
+                    return w->remove_this_;
+                }),
+                widgets_.end()
+            );
+            removal_pending_ = false;
+            mark_layout_dirty();
+        }
     }
 
-    void Widget::render(sf::RenderTarget & target, sf::FloatRect const & parent_render_rect) const
+    void Widget::layout(sf::FloatRect const & parent_render_rect) const
     {
-        // Compute the render rectangle.
-        render_rect_ = compute_render_rect(parent_render_rect);
+        // Render rectangles also change with the viewport ratio, which
+        // does not mark the widgets.
+        if (layout_subtree(parent_render_rect))
+            mark_mouse_dirty();
+    }
 
-        // Render the widget and the subwidgets.
-        if (visible_)
+    bool Widget::layout_subtree(sf::FloatRect const & parent_render_rect) const
+    {
+        // Recompute the render rectangle if one of its inputs changed.
+        if (parent_render_rect != layout_parent_rect_ || viewport_ratio != layout_ratio_)
+            layout_dirty_ = true;
+        auto changed = layout_dirty_;
+        if (layout_dirty_)
         {
-            render_impl(target);
+            render_rect_ = compute_render_rect(parent_render_rect);
+            layout_parent_rect_ = parent_render_rect;
+            layout_ratio_ = viewport_ratio;
+        }
+
+        // The subwidgets check themselves whether the new render
+        // rectangle changes anything for them.
+        if (layout_dirty_ || subtree_dirty_)
+        {
+            bounds_ = render_rect_;
             for (auto const & w : widgets_)
-                w->render(target, render_rect_);
+            {
+                if (w->layout_subtree(render_rect_))
+                    changed = true;
+                bounds_ = unite(bounds_, w->bounds_);
+            }
         }
+        layout_dirty_ = false;
+        subtree_dirty_ = false;
+        return changed;
+    }
+
+    void Widget::render(sf::RenderTarget & target, sf::FloatRect const & parent_render_rect) const
+    {
+        layout(parent_render_rect);
+        render_tree(target);
+    }
+
+    void Widget::render(SpriteBatch & batch, sf::FloatRect const & parent_render_rect) const
+    {
+        layout(parent_render_rect);
+        render_tree(batch);
     }
 
     float Widget::get_x() const
@@ -154,6 +328,7 @@ namespace sfe
     void Widget::set_x(float x)
     {
         rect_.left = x;
+        mark_layout_dirty();
     }
 
     float Widget::get_y() const
@@ -164,6 +339,7 @@ namespace sfe
     void Widget::set_y(float y)
     {
         rect_.top = y;
+        mark_layout_dirty();
     }
 
     float Widget::get_width() const
@@ -174,6 +350,7 @@ namespace sfe
     void Widget::set_width(float w)
     {
         rect_.width = w;
+        mark_layout_dirty();
     }
 
     float Widget::get_height() const
@@ -184,6 +361,7 @@ namespace sfe
     void Widget::set_height(float h)
     {
         rect_.height = h;
+        mark_layout_dirty();
     }
 
     bool Widget::get_visible() const
@@ -193,7 +371,11 @@ namespace sfe
 
     void Widget::set_visible(bool b)
     {
-        visible_ = b;
+        if (visible_ != b)
+        {
+            visible_ = b;
+            mark_mouse_dirty();
+        }
     }
 
     int Widget::get_z_index() const
@@ -203,7 +385,14 @@ namespace sfe
 
     void Widget::set_z_index(int z_index)
     {
+        if (z_index == z_index_)
+            return;
         z_index_ = z_index;
+        if (parent_)
+            parent_->order_dirty_ = true;
+
+        // The stacking order changes which widget is hit.
+        mark_layout_dirty();
     }
 
     AlignX Widget::get_align_x() const
@@ -214,6 +403,7 @@ namespace sfe
     void Widget::set_align_x(AlignX a)
     {
         align_x_ = a;
+        mark_layout_dirty();
     }
 
     AlignY Widget::get_align_y() const
@@ -224,6 +414,7 @@ namespace sfe
     void Widget::set_align_y(AlignY a)
     {
         align_y_ = a;
+        mark_layout_dirty();
     }
 
     Scale Widget::get_scale() const
@@ -234,6 +425,7 @@ namespace sfe
     void Widget::set_scale(Scale s)
     {
         scale_ = s;
+        mark_layout_dirty();
     }
 
     float Widget::get_ratio() const
@@ -244,6 +436,7 @@ namespace sfe
     void Widget::set_ratio(float r)
     {
         ratio_ = r;
+        mark_layout_dirty();
     }
 
     bool Widget::get_mouseover() const
@@ -258,7 +451,12 @@ namespace sfe
 
     void Widget::set_absorb_click(bool absorb_click)
     {
+        if (absorb_click == absorb_click_)
+            return;
         absorb_click_ = absorb_click;
+
+        // Absorbing widgets hide the widgets below from the mouse.
+        mark_layout_dirty();
     }
 
     sf::FloatRect const & Widget::get_render_rect() const
@@ -306,7 +504,7 @@ namespace sfe
         click_end_callbacks_.clear();
     }
 
-    void Widget::add_listener(std::shared_ptr<Listener> listener)
+    void Widget::add_listener(ListenerHandle listener)
     {
         listeners_.push_back(std::move(listener));
     }
@@ -317,6 +515,20 @@ namespace sfe
     void Widget::render_impl(sf::RenderTarget & target) const
     {}
 
+    void Widget::render_batch_impl(SpriteBatch & batch) const
+    {
+        // A plain widget draws nothing, but a subclass that only
+        // overrides render_impl() would be lost by the render thread.
+        if (batch.is_recording())
+        {
+            if (typeid(*this) == typeid(Widget))
+                return;
+            throw GameException("Widget::render_batch_impl(): The widget cannot be recorded for the render thread. Override render_batch_impl().");
+        }
+        batch.flush();
+        render_impl(batch.get_target());
+    }
+
     sf::FloatRect Widget::compute_render_rect(sf::FloatRect const & parent_render_rect) const
     {
         // Compute the size with respect to the scale method.
@@ -354,13 +566,59 @@ namespace sfe
         return r;
     }
 
+    void Widget::mark_layout_dirty()
+    {
+        layout_dirty_ = true;
+        for (auto p = parent_; p && !p->subtree_dirty_; p = p->parent_)
+            p->subtree_dirty_ = true;
+        mark_mouse_dirty();
+    }
+
+    void Widget::mark_mouse_dirty() const
+    {
+        // Only the root keeps the flag, the widgets on the way are not
+        // marked, so the walk cannot stop early.
+        auto root = this;
+        while (root->parent_)
+            root = root->parent_;
+        root->mouse_dirty_ = true;
+    }
+
+    void Widget::render_tree(sf::RenderTarget & target) const
+    {
+        if (visible_)
+        {
+            render_impl(target);
+            for (auto const & w : widgets_)
+                w->render_tree(target);
+        }
+    }
+
+    void Widget::render_tree(SpriteBatch & batch) const
+    {
+        if (visible_)
+        {
+            render_batch_impl(batch);
+            for (auto const & w : widgets_)
+                w->render_tree(batch);
+        }
+    }
+
     void Widget::sort_widgets()
     {
+        // Only a few subwidgets changed their z-index, so insertion
+        // sort is fast and does not allocate like std::stable_sort.
         auto comp = [](auto && a, auto && b)
         {
             return a->get_z_index() < b->get_z_index();
         };
-        std::sort(widgets_.begin(), widgets_.end(), comp);
+        for (auto it = widgets_.begin(); it != widgets_.end(); ++it)
+        {
+            if (it == widgets_.begin() || !comp(*it, *(it - 1)))
+                continue;
+            auto pos = std::upper_bound(widgets_.begin(), it, *it, comp);
+            std::rotate(pos, it, it + 1);
+        }
     }
 
     ColorWidget::ColorWidget(sf::Color color)
@@ -377,6 +635,11 @@ namespace sfe
         target.draw(r);
     }
 
+    void ColorWidget::render_batch_impl(SpriteBatch & batch) const
+    {
+        batch.draw(get_render_rect(), color_);
+    }
+
     sf::Color const & ColorWidget::get_color() const
     {
         return color_;
@@ -389,24 +652,39 @@ namespace sfe
 
     ImageWidget::ImageWidget(std::shared_ptr<sf::Texture> const& texture)
         :
-        texture_(texture)
+        ImageWidget(TextureRegion(texture))
+    {}
+
+    ImageWidget::ImageWidget(TextureRegion const& region)
+        :
+        region_(region)
     {
-        set_ratio(texture->getSize().x / static_cast<float>(texture->getSize().y));
+        set_ratio(region.rect.width / static_cast<float>(region.rect.height));
     }
 
     void ImageWidget::set_texture(std::shared_ptr<sf::Texture> const & texture)
     {
-        texture_ = texture;
+        region_ = TextureRegion(texture);
+    }
+
+    void ImageWidget::set_texture(TextureRegion const & region)
+    {
+        region_ = region;
     }
 
     void ImageWidget::render_impl(sf::RenderTarget & target) const
     {
-        auto const& texture = *texture_;
         auto const & r = get_render_rect();
-        sf::Sprite spr(texture);
+        sf::Sprite spr(*region_.texture, region_.rect);
         spr.setPosition(r.left, r.top);
-        spr.setScale(r.width / texture.getSize().x, r.height / texture.getSize().y);
+        spr.setScale(r.width / region_.rect.width, r.height / region_.rect.height);
         target.draw(spr);
     }
 
+    void ImageWidget::render_batch_impl(SpriteBatch & batch) const
+    {
+        auto const & r = get_render_rect();
+        batch.draw(*region_.texture, region_.rect, { r.left + 0.5f * r.width, r.top + 0.5f * r.height }, { r.width, r.height }, 0);
+    }
+
 } // namespace sfe